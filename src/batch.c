@@ -0,0 +1,130 @@
+#include "batch.h"
+#include "keyboard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Where the batch devices read keys and put output words
+typedef struct {
+    const batch_job* job;
+    size_t position;             // Next input byte
+    batch_result* result;
+} batch_io;
+
+bool batch_keyboard_flag(void* device, PDP7_cpu* cpu);
+bool batch_keyboard_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction);
+bool batch_output_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction);
+void collect_changes(const PDP7_cpu* cpu, const PDP7_cpu* image, batch_result* result);
+
+void run_batch(const batch_job* job, batch_result* result) {
+    const PDP7_cpu* image = job->image;
+    PDP7_cpu cpu;
+    iot_bus bus;
+    batch_io io = { job, 0, result };
+
+    memset(result, 0, sizeof(batch_result));
+    initialize_cpu(&cpu, NULL, NULL, NULL, image->program_start_address);
+    cpu.model = image->model;
+    cpu.pc = image->pc;
+    share_memory(&cpu, image);
+
+    // The standard bus with keyboard and output replaced, storage stays detached
+    initialize_iot_bus(&bus);
+    iot_attach(&bus, IOT_CODE_KEYBOARD, "keyboard", batch_keyboard_flag, batch_keyboard_pulse, &io, 0);
+    iot_attach(&bus, IOT_CODE_OUTPUT, "output", NULL, batch_output_pulse, &io, 0);
+    cpu.bus = &bus;
+
+    run_cycles(&cpu, job->cycles);
+
+    result->cycles = cpu.cycles;
+    result->accumulator = cpu.accumulator;
+    result->pc = cpu.pc;
+    result->link = cpu.link;
+    result->extend_mode = cpu.extend_mode;
+    result->running = cpu.running;
+    result->trap = cpu.trap;
+    result->trap_pc = cpu.trap_pc;
+    result->trap_instruction = cpu.trap_instruction;
+    collect_changes(&cpu, image, result);
+    free_memory(&cpu);
+}
+
+void free_batch_result(batch_result* result) {
+    free(result->changes);
+    free(result->output);
+    memset(result, 0, sizeof(batch_result));
+}
+
+bool batch_results_equal(const batch_result* a, const batch_result* b) {
+    return a->cycles == b->cycles && a->accumulator == b->accumulator && a->pc == b->pc &&
+           a->link == b->link && a->extend_mode == b->extend_mode && a->running == b->running &&
+           a->trap == b->trap && a->trap_pc == b->trap_pc && a->trap_instruction == b->trap_instruction &&
+           a->change_count == b->change_count && a->output_count == b->output_count &&
+           (a->change_count == 0 || memcmp(a->changes, b->changes, a->change_count * sizeof(memory_change)) == 0) &&
+           (a->output_count == 0 || memcmp(a->output, b->output, a->output_count * sizeof(uint32_t)) == 0);
+}
+
+// KSF: set while input is left. Once it is all read the guest would wait
+// forever, so the machine stops like a replayed session does.
+bool batch_keyboard_flag(void* device, PDP7_cpu* cpu) {
+    batch_io* io = device;
+    if (io->position < io->job->input_size) {
+        return true;
+    }
+    cpu->running = false;
+    return false;
+}
+
+// KRB
+bool batch_keyboard_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    batch_io* io = device;
+    if (instruction != IOT_KRB) {
+        return false;
+    }
+    cpu->accumulator = io->position < io->job->input_size ? io->job->input[io->position++] : 0;
+    return true;
+}
+
+// TLS
+bool batch_output_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    batch_result* result = ((batch_io*)device)->result;
+    if (instruction != IOT_TLS) {
+        return false;
+    }
+    if (result->output_count == result->output_capacity) {
+        result->output_capacity = result->output_capacity ? result->output_capacity * 2 : 256;
+        result->output = realloc(result->output, result->output_capacity * sizeof(uint32_t));
+        if (!result->output) {
+            fprintf(stderr, "Failed to allocate batch output\n");
+            exit(1);
+        }
+    }
+    result->output[result->output_count++] = cpu->accumulator;
+    return true;
+}
+
+// Only the pages the run wrote can differ from the image
+void collect_changes(const PDP7_cpu* cpu, const PDP7_cpu* image, batch_result* result) {
+    uint32_t capacity = 0;
+
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (!cpu->dirty[page]) {
+            continue;
+        }
+        for (uint32_t word = 0; word < MEMORY_PAGE_WORDS; word++) {
+            uint32_t value = cpu->pages[page][word];
+            if (value == image->pages[page][word]) {
+                continue;
+            }
+            if (result->change_count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                result->changes = realloc(result->changes, capacity * sizeof(memory_change));
+                if (!result->changes) {
+                    fprintf(stderr, "Failed to allocate batch memory changes\n");
+                    exit(1);
+                }
+            }
+            result->changes[result->change_count++] = (memory_change){ page * MEMORY_PAGE_WORDS + word, value };
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "iot_bus.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// One headless run of a loaded image: keys come from `input`, one byte per
+// KRB, and every TLS word is collected. Nothing else is attached, so the
+// result depends only on the job.
+typedef struct {
+    const PDP7_cpu* image;       // Loaded program and memory, shared read-only by the run
+    const uint8_t* input;
+    size_t input_size;
+    uint64_t cycles;             // Budget, the run stops once it is used up
+} batch_job;
+
+typedef struct {
+    uint32_t address;
+    uint32_t word;
+} memory_change;
+
+// Final registers, the words that differ from the image, and the output
+typedef struct {
+    uint64_t cycles;
+    uint32_t accumulator;
+    uint32_t pc;
+    bool link;
+    bool extend_mode;
+    bool running;                // Still running when the budget ran out
+    cpu_trap_kind trap;
+    uint32_t trap_pc;
+    uint32_t trap_instruction;
+    memory_change* changes;
+    uint32_t change_count;
+    uint32_t* output;
+    uint32_t output_count;
+    uint32_t output_capacity;
+} batch_result;
+
+void run_batch(const batch_job* job, batch_result* result);
+void free_batch_result(batch_result* result);
+bool batch_results_equal(const batch_result* a, const batch_result* b);
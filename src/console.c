@@ -0,0 +1,79 @@
+#include "console.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CONSOLE_FULL_SLEEP_US 100
+
+void initialize_console_queue(console_queue* queue) {
+    atomic_store(&queue->head, 0);
+    atomic_store(&queue->tail, 0);
+    atomic_store(&queue->attention, false);
+}
+
+void console_push(console_queue* queue, const char* line) {
+    // The CPU drains the queue every slice, so a full queue never lasts long
+    while (!console_try_push(queue, line)) {
+        usleep(CONSOLE_FULL_SLEEP_US);
+    }
+}
+
+// False, with nothing queued, when the queue is full
+bool console_try_push(console_queue* queue, const char* line) {
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    if (head - atomic_load_explicit(&queue->tail, memory_order_acquire) == CONSOLE_QUEUE_SIZE) {
+        return false;
+    }
+
+    snprintf(queue->lines[head & (CONSOLE_QUEUE_SIZE - 1)], CONSOLE_LINE_SIZE, "%s", line);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    atomic_store_explicit(&queue->attention, true, memory_order_relaxed);
+    return true;
+}
+
+bool console_pop(console_queue* queue, char* line) {
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    if (atomic_load_explicit(&queue->head, memory_order_acquire) == tail) {
+        return false;
+    }
+
+    memcpy(line, queue->lines[tail & (CONSOLE_QUEUE_SIZE - 1)], CONSOLE_LINE_SIZE);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Owns stdin for the whole interactive session so the machine keeps
+// running while the user types. Ends after queueing `q` (or on EOF).
+void* run_console(void* queue_arg) {
+    console_queue* queue = (console_queue*)queue_arg;
+    char command[CONSOLE_LINE_SIZE];
+
+    while (1) {
+        printf("> ");
+        fflush(stdout);
+        if (!fgets(command, sizeof(command), stdin)) {
+            console_push(queue, "q");
+            break;
+        }
+        command[strcspn(command, "\r\n")] = '\0';
+
+        if (strcmp(command, "m") == 0) {
+            uint32_t start, end;
+            printf("Enter start address: ");
+            scanf("%o", &start);
+            printf("Enter end address: ");
+            scanf("%o", &end);
+            while (getchar() != '\n');
+            snprintf(command, sizeof(command), "m %o %o", start, end);
+        }
+
+        console_push(queue, command);
+        if (strcmp(command, "q") == 0) {
+            break;
+        }
+    }
+
+    return NULL;
+}
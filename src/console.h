@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CONSOLE_QUEUE_SIZE 16        // Must be a power of two
+#define CONSOLE_LINE_SIZE 64
+#define CONSOLE_POLL_INSTRUCTIONS 4096 // Instructions run between queue polls
+
+// Command lines typed on the console thread, consumed by the CPU thread
+// between instruction slices (single producer, single consumer)
+typedef struct console_queue {
+    char lines[CONSOLE_QUEUE_SIZE][CONSOLE_LINE_SIZE];
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    atomic_bool attention;   // Raised on push, so a blocked CPU loop returns early
+} console_queue;
+
+void initialize_console_queue(console_queue* queue);
+void console_push(console_queue* queue, const char* line);
+bool console_try_push(console_queue* queue, const char* line);
+bool console_pop(console_queue* queue, char* line);
+void* run_console(void* queue_arg);
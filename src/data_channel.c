@@ -0,0 +1,29 @@
+#include "data_channel.h"
+#include "metrics.h"
+
+// Moves `count` words between a device buffer and core memory starting at
+// `address`, wrapping around the top of memory like the real channel does.
+// Every word transferred steals one memory cycle from the processor.
+// Words going into memory are cut to 18 bits, the device buffer is left as
+// it is.
+uint32_t data_channel_transfer(PDP7_cpu* cpu, uint32_t* device_words, uint32_t address, uint32_t count, bool to_memory) {
+    if (to_memory) {
+        uint32_t words[MEMORY_PAGE_WORDS];
+        for (uint32_t done = 0; done < count; done += MEMORY_PAGE_WORDS) {
+            uint32_t chunk = count - done < MEMORY_PAGE_WORDS ? count - done : MEMORY_PAGE_WORDS;
+            for (uint32_t i = 0; i < chunk; i++) {
+                words[i] = device_words[done + i] & 0777777;
+            }
+            write_memory_range(cpu, address + done, words, chunk);
+        }
+    } else {
+        read_memory_range(cpu, address, device_words, count);
+    }
+
+    cpu->cycles += count;
+    if (cpu->metrics) {
+        cpu->metrics->io_words += count;
+    }
+
+    return count;
+}
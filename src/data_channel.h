@@ -0,0 +1,9 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+
+// Data channel (block DMA between a device and core memory)
+#define DATA_CHANNEL_TO_MEMORY true
+#define DATA_CHANNEL_FROM_MEMORY false
+
+uint32_t data_channel_transfer(PDP7_cpu* cpu, uint32_t* device_words, uint32_t address, uint32_t count, bool to_memory);
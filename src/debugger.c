@@ -0,0 +1,138 @@
+#include "debugger.h"
+#include "pdp7_isa.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char* CONDITION_NAMES[] = { "ac", "link", "cycles" };
+
+void initialize_debugger(cpu_debugger* debugger) {
+    memset(debugger->flags, 0, sizeof(debugger->flags));
+    debugger->flagged_words = 0;
+    debugger->condition_count = 0;
+    debugger->reason[0] = '\0';
+}
+
+void debugger_flag_range(cpu_debugger* debugger, uint32_t start, uint32_t end, uint8_t flags) {
+    for (uint32_t address = start; address <= end && address < MEMORY_SIZE; address++) {
+        if (debugger->flags[address] == 0) {
+            debugger->flagged_words++;
+        }
+        debugger->flags[address] |= flags;
+    }
+}
+
+void debugger_unflag_range(cpu_debugger* debugger, uint32_t start, uint32_t end, uint8_t flags) {
+    for (uint32_t address = start; address <= end && address < MEMORY_SIZE; address++) {
+        if (debugger->flags[address] == 0) {
+            continue;
+        }
+        debugger->flags[address] &= ~flags;
+        if (debugger->flags[address] == 0) {
+            debugger->flagged_words--;
+        }
+    }
+}
+
+bool debugger_add_condition(cpu_debugger* debugger, condition_kind kind, uint64_t value) {
+    if (debugger->condition_count == DEBUG_MAX_CONDITIONS) {
+        return false;
+    }
+    debugger->conditions[debugger->condition_count].kind = kind;
+    debugger->conditions[debugger->condition_count].value = value;
+    debugger->conditions[debugger->condition_count].was_true = false;
+    debugger->condition_count++;
+    return true;
+}
+
+void debugger_clear(cpu_debugger* debugger) {
+    initialize_debugger(debugger);
+}
+
+void debugger_print(const cpu_debugger* debugger) {
+    for (uint32_t address = 0; address < MEMORY_SIZE; address++) {
+        uint8_t flags = debugger->flags[address];
+        if (flags) {
+            printf("%05" PRIo32 ": %s%s%s%s\n", address,
+                   flags & DEBUG_BREAK ? "break " : "",
+                   flags & DEBUG_WATCH_READ ? "read " : "",
+                   flags & DEBUG_WATCH_WRITE ? "write " : "",
+                   flags & DEBUG_WATCH_EXEC ? "exec " : "");
+        }
+    }
+    for (uint32_t i = 0; i < debugger->condition_count; i++) {
+        const debug_condition* condition = &debugger->conditions[i];
+        printf(condition->kind == CONDITION_CYCLES ? "%s = %" PRIu64 "\n" : "%s = %" PRIo64 "\n",
+               CONDITION_NAMES[condition->kind], condition->value);
+    }
+}
+
+static bool check_word(cpu_debugger* debugger, uint32_t address, uint8_t flags, const char* what) {
+    address &= MEMORY_SIZE - 1;
+    if (debugger->flags[address] & flags) {
+        snprintf(debugger->reason, sizeof(debugger->reason), "%s %05" PRIo32, what, address);
+        return true;
+    }
+    return false;
+}
+
+// Looks at the instruction about to run and reports whether it hits a
+// breakpoint, a watched word or a condition. Nothing in the CPU changes.
+bool debugger_check(cpu_debugger* debugger, const PDP7_cpu* cpu) {
+    uint32_t pc = cpu->pc & (MEMORY_SIZE - 1);
+    uint32_t instruction = read_memory(cpu, pc);
+    uint32_t opcode = (instruction >> 12) & 074;
+    uint32_t address = instruction & 017777;
+    bool indirect = instruction & 020000;
+
+    for (uint32_t i = 0; i < debugger->condition_count; i++) {
+        debug_condition* condition = &debugger->conditions[i];
+        bool is_true = (condition->kind == CONDITION_AC && cpu->accumulator == condition->value) ||
+                       (condition->kind == CONDITION_LINK && cpu->link == condition->value) ||
+                       (condition->kind == CONDITION_CYCLES && cpu->cycles >= condition->value);
+        bool hit = is_true && !condition->was_true;
+        condition->was_true = is_true;
+        if (hit) {
+            snprintf(debugger->reason, sizeof(debugger->reason),
+                     condition->kind == CONDITION_CYCLES ? "condition %s = %" PRIu64 : "condition %s = %" PRIo64,
+                     CONDITION_NAMES[condition->kind], condition->value);
+            return true;
+        }
+    }
+
+    if (debugger->flagged_words == 0) {
+        return false;
+    }
+
+    if (check_word(debugger, pc, DEBUG_BREAK, "breakpoint at") ||
+        check_word(debugger, pc, DEBUG_WATCH_EXEC, "execute of")) {
+        return true;
+    }
+
+    if (opcode == OP_IOT || opcode == OP_OPR) {
+        return false;
+    }
+
+    if (indirect && check_word(debugger, resolve_address(cpu, address, false), DEBUG_WATCH_READ, "indirect read of")) {
+        return true;
+    }
+    uint32_t effective_address = resolve_address(cpu, address, indirect);
+
+    switch (opcode) {
+        case OP_DAC:
+        case OP_DZM:
+        case OP_JMS:
+            return check_word(debugger, effective_address, DEBUG_WATCH_WRITE, "write of");
+        case OP_CAL:
+        case OP_ISZ:
+            return check_word(debugger, effective_address, DEBUG_WATCH_READ, "read of") ||
+                   check_word(debugger, effective_address, DEBUG_WATCH_WRITE, "write of");
+        case OP_XCT:
+            return check_word(debugger, effective_address, DEBUG_WATCH_READ, "read of") ||
+                   check_word(debugger, effective_address, DEBUG_WATCH_EXEC, "execute of");
+        case OP_JMP:
+            return false;
+        default:
+            return check_word(debugger, effective_address, DEBUG_WATCH_READ, "read of");
+    }
+}
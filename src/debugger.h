@@ -0,0 +1,46 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-word flags
+#define DEBUG_BREAK       0x01 // Stop before executing the word
+#define DEBUG_WATCH_READ  0x02 // Stop before an instruction reads the word
+#define DEBUG_WATCH_WRITE 0x04 // Stop before an instruction writes the word
+#define DEBUG_WATCH_EXEC  0x08 // Stop before the word is executed
+
+#define DEBUG_MAX_CONDITIONS 8
+
+typedef enum {
+    CONDITION_AC,        // AC equals value
+    CONDITION_LINK,      // Link equals value
+    CONDITION_CYCLES,    // Cycle counter reached value
+} condition_kind;
+
+typedef struct {
+    condition_kind kind;
+    uint64_t value;
+    bool was_true;       // Conditions stop the CPU when they become true
+} debug_condition;
+
+typedef struct {
+    uint8_t flags[MEMORY_SIZE];
+    uint32_t flagged_words;              // Words with any flag set
+    debug_condition conditions[DEBUG_MAX_CONDITIONS];
+    uint32_t condition_count;
+    char reason[96];                     // Why the last check stopped the CPU
+} cpu_debugger;
+
+void initialize_debugger(cpu_debugger* debugger);
+void debugger_flag_range(cpu_debugger* debugger, uint32_t start, uint32_t end, uint8_t flags);
+void debugger_unflag_range(cpu_debugger* debugger, uint32_t start, uint32_t end, uint8_t flags);
+bool debugger_add_condition(cpu_debugger* debugger, condition_kind kind, uint64_t value);
+void debugger_clear(cpu_debugger* debugger);
+void debugger_print(const cpu_debugger* debugger);
+bool debugger_check(cpu_debugger* debugger, const PDP7_cpu* cpu);
+
+// With nothing set the CPU keeps running on the unchecked loop
+static inline bool debugger_active(const cpu_debugger* debugger) {
+    return debugger->flagged_words != 0 || debugger->condition_count != 0;
+}
@@ -0,0 +1,76 @@
+#include "disassembler.h"
+#include "pdp7_isa.h"
+#include "keyboard.h"
+#include "storage.h"
+#include "iot_bus.h"
+#include "host_service.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+typedef struct {
+    uint32_t word;
+    const char* name;
+} named_word;
+
+#define OPERATE_NAME(name, word, cycles, models) { OPR_##name, #name },
+#define IOT_NAME(name, word, cycles, models) { IOT_##name, #name },
+#define OPCODE_NAME(name, word, cycles, models) [OP_##name >> 2] = #name,
+
+static const named_word OPERATE_NAMES[] = {
+    { OP_OPR << 12, "NOP" },
+    PDP7_OPERATES(OPERATE_NAME)
+};
+
+static const named_word IOT_NAMES[] = {
+    { IOT_KSF, "KSF" }, { IOT_KRB, "KRB" }, { IOT_TLS, "TLS" },
+    PDP7_IOTS(IOT_NAME)
+    { IOT_DSSF, "DSSF" }, { IOT_DSCF, "DSCF" }, { IOT_DSLB, "DSLB" }, { IOT_DSLA, "DSLA" },
+    { IOT_DSLC, "DSLC" }, { IOT_DSRD, "DSRD" }, { IOT_DSWR, "DSWR" }, { IOT_DSRS, "DSRS" },
+    { IOT_HSR, "HSR" },
+};
+
+// Index 015 (EAE) has no entry
+static const char* MEMORY_REFERENCE_NAMES[16] = {
+    PDP7_OPCODES(OPCODE_NAME)
+};
+
+static const char* find_name(const named_word* names, size_t count, uint32_t instruction) {
+    for (size_t i = 0; i < count; i++) {
+        if (names[i].word == instruction) {
+            return names[i].name;
+        }
+    }
+    return NULL;
+}
+
+const char* opcode_name(uint32_t instruction) {
+    const char* name = MEMORY_REFERENCE_NAMES[(instruction >> 14) & 017];
+    return name ? name : "EAE";
+}
+
+void disassemble_instruction(uint32_t instruction, char* text, size_t size) {
+    uint32_t opcode = (instruction >> 12) & 074;
+    const char* name = NULL;
+
+    switch (opcode) {
+        case OP_OPR:
+            name = find_name(OPERATE_NAMES, sizeof(OPERATE_NAMES) / sizeof(OPERATE_NAMES[0]), instruction);
+            break;
+        case OP_IOT:
+            name = find_name(IOT_NAMES, sizeof(IOT_NAMES) / sizeof(IOT_NAMES[0]), instruction);
+            break;
+        default:
+            if (MEMORY_REFERENCE_NAMES[opcode >> 2]) {
+                snprintf(text, size, "%s%s %05" PRIo32, MEMORY_REFERENCE_NAMES[opcode >> 2],
+                         (instruction & 020000) ? " I" : "", instruction & 017777);
+                return;
+            }
+            break;
+    }
+
+    if (name) {
+        snprintf(text, size, "%s", name);
+    } else {
+        snprintf(text, size, "%06" PRIo32, instruction & 0777777);
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+const char* opcode_name(uint32_t instruction);
+void disassemble_instruction(uint32_t instruction, char* text, size_t size);
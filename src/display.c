@@ -1,4 +1,5 @@
 #include "display.h"
+#include "instrument.h"
 #include <stdio.h>
 #include <unistd.h>
 
@@ -77,43 +78,189 @@ const uint8_t FONT_MAP[64][7] = {
 
 SDL_Renderer* start_SDL_renderer(void);
 void set_pixel(int x, int y, SDL_Renderer *renderer);
-void draw_char(int x, int y, uint8_t char_code, SDL_Renderer *renderer);
-void handle_instruction(uint32_t instruction, SDL_Renderer *renderer, int *mode);
+void plot_point(display_340* display, int x, int y, bool lit);
+void plot_line(display_340* display, int x0, int y0, int x1, int y1, bool lit);
+void draw_char(int x, int y, uint8_t char_code, display_340* display);
+void handle_instruction(uint32_t instruction, display_340* display, int *mode);
 void print_display(display_340* display);
+void handle_key_event(display_340* display, SDL_Event* event);
+void open_heatmap_view(display_340* display);
+void close_heatmap_view(display_340* display);
+bool handle_heatmap_event(display_340* display, SDL_Event* event);
+void draw_heatmap_view(display_340* display);
 uint8_t int_to_char(uint8_t single);
 
 void* run_display(void* display_arg) {
     display_340* display = (display_340*) display_arg;
     
-    SDL_Event event;
     bool quit = false;
 
     while (!quit && display->running) {
-        while (SDL_PollEvent(&event) != 0) {
-            if (event.type == SDL_QUIT) {
-                quit = true;
-            }
-        }
+        quit = !display_poll_events(display);
         if (*display->io_buffer == 0) { continue; }
 
-        print_display(display);
-        SDL_RenderPresent(display->renderer);
-        *display->io_buffer = 0;
-        usleep(35000);
-        display->mode = 0;
+        display_output(display);
+        if (!display->terminal) {
+            usleep(35000); // The terminal takes words at once and rate limits its own frames
+        }
     }
 
-    SDL_DestroyRenderer(display->renderer);
-    SDL_Quit();
+    close_display(display);
     return NULL;
  }
 
-void initialize_display(display_340* display, uint32_t* io_buffer) {
+void close_display(display_340* display) {
+    if (display->terminal) {
+        destroy_terminal(display->terminal);
+        display->terminal = NULL;
+        return;
+    }
+    close_heatmap_view(display);
+    SDL_DestroyRenderer(display->renderer);
+    SDL_Quit();
+}
+
+// Handles pending window events and redraws the heatmap view when due.
+// Returns false once the window has been closed.
+bool display_poll_events(display_340* display) {
+    SDL_Event event;
+    bool open = true;
+
+    if (display->terminal) {
+        terminal_present(display->terminal);
+        return true;
+    }
+
+    while (SDL_PollEvent(&event) != 0) {
+        if (event.type == SDL_QUIT) {
+            open = false;
+        } else if (!handle_heatmap_event(display, &event)) {
+            handle_key_event(display, &event);
+        }
+    }
+    draw_heatmap_view(display);
+    return open;
+}
+
+// Draws the word waiting in io_buffer and hands the buffer back to the CPU
+void display_output(display_340* display) {
+    INSTRUMENT_START(frame_timer);
+    print_display(display);
+    if (!display->terminal) {
+        SDL_RenderPresent(display->renderer);
+    }
+    INSTRUMENT_FRAME(frame_timer);
+    if (display->metrics) {
+        atomic_fetch_add_explicit(&display->metrics->page->display_frames, 1, memory_order_relaxed);
+    }
+    *display->io_buffer = 0;
+    display->mode = 0;
+}
+
+void initialize_display(display_340* display, uint32_t* io_buffer, keyboard_device* keyboard, live_metrics* metrics, memory_heatmap* heatmap) {
     SDL_Renderer *renderer = start_SDL_renderer();
     display->running = true;
     display->io_buffer = io_buffer;   
+    display->keyboard = keyboard;
+    display->metrics = metrics;
     display->renderer = renderer;
+    display->terminal = NULL;
     display->mode = 0;
+    display->heatmap = heatmap;
+    display->heatmap_window = NULL;
+    if (heatmap) {
+        open_heatmap_view(display);
+    }
+}
+
+// The 340 on the controlling terminal instead of a window, SDL is never
+// started. Keys come from stdin through the keyboard device as headless.
+void initialize_terminal_display(display_340* display, uint32_t* io_buffer, live_metrics* metrics, bool raw_input) {
+    display->running = true;
+    display->io_buffer = io_buffer;
+    display->keyboard = NULL;
+    display->metrics = metrics;
+    display->renderer = NULL;
+    display->terminal = create_terminal(stdout, raw_input);
+    display->mode = 0;
+    display->heatmap = NULL;
+    display->heatmap_window = NULL;
+}
+
+// The heatmap gets a window of its own, one cell per word of the shown bank,
+// drawn by scaling a texture with a pixel per cell
+void open_heatmap_view(display_340* display) {
+    display->heatmap_window = SDL_CreateWindow("Memory heatmap (keys 0-3 pick the bank)", 0, 0,
+                                               HEATMAP_COLUMNS * HEATMAP_CELL_SIZE, HEATMAP_ROWS * HEATMAP_CELL_SIZE,
+                                               SDL_WINDOW_SHOWN);
+    if (display->heatmap_window == NULL) {
+        printf("Heatmap window could not be created! SDL_Error: %s\n", SDL_GetError());
+        exit(1);
+    }
+    display->heatmap_renderer = SDL_CreateRenderer(display->heatmap_window, -1, SDL_RENDERER_ACCELERATED);
+    display->heatmap_texture = display->heatmap_renderer ?
+        SDL_CreateTexture(display->heatmap_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                          HEATMAP_COLUMNS, HEATMAP_ROWS) : NULL;
+    if (display->heatmap_texture == NULL) {
+        printf("Heatmap renderer could not be created! SDL_Error: %s\n", SDL_GetError());
+        exit(1);
+    }
+    display->heatmap_window_id = SDL_GetWindowID(display->heatmap_window);
+    display->heatmap_frame = 0;
+}
+
+void close_heatmap_view(display_340* display) {
+    if (display->heatmap_window == NULL) {
+        return;
+    }
+    SDL_DestroyTexture(display->heatmap_texture);
+    SDL_DestroyRenderer(display->heatmap_renderer);
+    SDL_DestroyWindow(display->heatmap_window);
+    display->heatmap_window = NULL;
+}
+
+// Takes the events aimed at the heatmap window: digits pick the bank and
+// closing it leaves the 340 running. Returns false for everything else.
+bool handle_heatmap_event(display_340* display, SDL_Event* event) {
+    if (display->heatmap_window == NULL) {
+        return false;
+    }
+
+    if (event->type == SDL_TEXTINPUT && event->text.windowID == display->heatmap_window_id) {
+        char digit = event->text.text[0];
+        if (digit >= '0' && digit < '0' + MEMORY_SIZE / BANK_SIZE) {
+            heatmap_show_bank(display->heatmap, digit - '0');
+        }
+        return true;
+    }
+    if (event->type == SDL_KEYDOWN && event->key.windowID == display->heatmap_window_id) {
+        return true;
+    }
+    if (event->type == SDL_WINDOWEVENT && event->window.windowID == display->heatmap_window_id) {
+        if (event->window.event == SDL_WINDOWEVENT_CLOSE) {
+            close_heatmap_view(display);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Samples the counters and redraws at most every HEATMAP_FRAME_MS
+void draw_heatmap_view(display_340* display) {
+    if (display->heatmap_window == NULL) {
+        return;
+    }
+
+    uint32_t now = SDL_GetTicks();
+    if (now - display->heatmap_frame < HEATMAP_FRAME_MS) {
+        return;
+    }
+    display->heatmap_frame = now;
+
+    heatmap_sample(display->heatmap);
+    SDL_UpdateTexture(display->heatmap_texture, NULL, display->heatmap->pixels, HEATMAP_COLUMNS * sizeof(uint32_t));
+    SDL_RenderCopy(display->heatmap_renderer, display->heatmap_texture, NULL, NULL);
+    SDL_RenderPresent(display->heatmap_renderer);
 }
 
 SDL_Renderer* start_SDL_renderer(void) {
@@ -136,11 +283,45 @@ SDL_Renderer* start_SDL_renderer(void) {
     }
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
+    SDL_StartTextInput();
 
     return renderer;
 }
 
-void handle_instruction(uint32_t instruction, SDL_Renderer *renderer, int *mode) {
+void handle_key_event(display_340* display, SDL_Event* event) {
+    if (display->keyboard == NULL) {
+        return;
+    }
+
+    if (event->type == SDL_TEXTINPUT) {
+        // Printable characters, already shifted by the host layout
+        for (const char* c = event->text.text; *c != '\0'; c++) {
+            if ((uint8_t)*c < 0200) {
+                keyboard_push(display->keyboard, (uint8_t)*c);
+            }
+        }
+    } else if (event->type == SDL_KEYDOWN) {
+        // Control keys don't generate text input events
+        switch (event->key.keysym.sym) {
+            case SDLK_RETURN:
+                keyboard_push(display->keyboard, '\r');
+                break;
+            case SDLK_BACKSPACE:
+                keyboard_push(display->keyboard, 0177);
+                break;
+            case SDLK_ESCAPE:
+                keyboard_push(display->keyboard, 033);
+                break;
+            case SDLK_TAB:
+                keyboard_push(display->keyboard, '\t');
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void handle_instruction(uint32_t instruction, display_340* display, int *mode) {
     switch (*mode) {
         case 0: // Parameter mode
             *mode = (instruction >> 13) & 0x7;
@@ -152,11 +333,10 @@ void handle_instruction(uint32_t instruction, SDL_Renderer *renderer, int *mode)
             bool lit = (instruction >> 10) & 0x1;
             int coord = instruction & 0x3FF;
 
-            SDL_SetRenderDrawColor(renderer, 0, lit ? 255 : 0, 0, 255);
             if (axis == 0) {
-                SDL_RenderDrawPoint(renderer, coord, SCREEN_HEIGHT / 2);
+                plot_point(display, coord, SCREEN_HEIGHT / 2, lit);
             } else {
-                SDL_RenderDrawPoint(renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT - coord);
+                plot_point(display, SCREEN_WIDTH / 2, SCREEN_HEIGHT - coord, lit);
             }
             *mode = next_mode;
         }
@@ -189,7 +369,7 @@ void handle_instruction(uint32_t instruction, SDL_Renderer *renderer, int *mode)
                         *mode = 0;
                         break;
                     default: // Valid char
-                        draw_char(x_delta, y_delta, curr_char, renderer);
+                        draw_char(x_delta, y_delta, curr_char, display);
                         x_delta += (FONT_WIDTH + X_SEP) * FONT_SIZE;
                         if (x_delta >= SCREEN_WIDTH - FONT_SIZE * FONT_WIDTH) {
                             x_delta = 0;
@@ -212,8 +392,7 @@ void handle_instruction(uint32_t instruction, SDL_Renderer *renderer, int *mode)
             dy = neg_y ? -dy : dy;
             dx = neg_x ? -dx : dx;
 
-            SDL_SetRenderDrawColor(renderer, 0, lit ? 255 : 0, 0, 255);
-            SDL_RenderDrawLine(renderer, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, SCREEN_WIDTH / 2 + dx, SCREEN_HEIGHT / 2 - dy);
+            plot_line(display, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, SCREEN_WIDTH / 2 + dx, SCREEN_HEIGHT / 2 - dy, lit);
             if (!stay_in_mode) {
                 *mode = 0;
             }
@@ -251,7 +430,7 @@ void print_display(display_340* display) {
         instruction = (instruction << 6) | (curr_char);  
     
         if (j == 2) {
-            handle_instruction(instruction, display->renderer, &display->mode);
+            handle_instruction(instruction, display, &display->mode);
             instruction = 0;
             j = -1;
         }
@@ -263,13 +442,13 @@ void print_display(display_340* display) {
             instruction = (instruction << 6) | 0;
             remaining--;
         }
-        handle_instruction(instruction, display->renderer, &display->mode);
+        handle_instruction(instruction, display, &display->mode);
     }
 
     free(number_array);
 
     instruction = 0b011011011100000000; // \r\n\0
-    handle_instruction(instruction, display->renderer, &display->mode);
+    handle_instruction(instruction, display, &display->mode);
 }
 
 uint8_t int_to_char(uint8_t single){
@@ -285,7 +464,33 @@ void set_pixel(int x, int y, SDL_Renderer *renderer) {
     SDL_RenderDrawPoint(renderer, x, y);
 }
 
-void draw_char(int x, int y, uint8_t char_code, SDL_Renderer *renderer) {
+// Points and vectors go to the window, or to braille dots on a terminal
+void plot_point(display_340* display, int x, int y, bool lit) {
+    if (display->terminal) {
+        terminal_point(display->terminal, x, y, lit);
+        return;
+    }
+    SDL_SetRenderDrawColor(display->renderer, 0, lit ? 255 : 0, 0, 255);
+    SDL_RenderDrawPoint(display->renderer, x, y);
+}
+
+void plot_line(display_340* display, int x0, int y0, int x1, int y1, bool lit) {
+    if (display->terminal) {
+        terminal_line(display->terminal, x0, y0, x1, y1, lit);
+        return;
+    }
+    SDL_SetRenderDrawColor(display->renderer, 0, lit ? 255 : 0, 0, 255);
+    SDL_RenderDrawLine(display->renderer, x0, y0, x1, y1);
+}
+
+// A terminal shows the character itself: codes 1-26 are the letters, 32-63
+// are the ASCII characters of the same code
+void draw_char(int x, int y, uint8_t char_code, display_340* display) {
+    if (display->terminal) {
+        terminal_char(display->terminal, x, y, char_code < 32 ? 'A' + char_code - 1 : (char)char_code);
+        return;
+    }
+    SDL_Renderer* renderer = display->renderer;
     for (int row = 0; row < FONT_WIDTH; row++) {
         for (int col = 0; col < FONT_HEIGHT; col++) {
             if (FONT_MAP[char_code][row] & (1 << col)) {
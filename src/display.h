@@ -2,6 +2,10 @@
 
 #include <SDL2/SDL.h>
 #include <stdbool.h>
+#include "keyboard.h"
+#include "metrics.h"
+#include "heatmap.h"
+#include "terminal.h"
 
 #define SCREEN_WIDTH 1024
 #define SCREEN_HEIGHT 1024
@@ -9,9 +13,22 @@
 typedef struct {
     bool running;
     uint32_t* io_buffer;
+    keyboard_device* keyboard;
+    live_metrics* metrics;
     SDL_Renderer* renderer;
+    terminal_screen* terminal;         // Draws on an ANSI terminal instead, NULL for the SDL window
     int mode;
+    memory_heatmap* heatmap;           // Access counters to show, NULL without the heatmap view
+    SDL_Window* heatmap_window;        // Second window for the heatmap, NULL once closed
+    SDL_Renderer* heatmap_renderer;
+    SDL_Texture* heatmap_texture;
+    uint32_t heatmap_window_id;
+    uint32_t heatmap_frame;            // SDL_GetTicks of the last heatmap frame
 } display_340;
 
 void* run_display(void* display_arg);
-void initialize_display(display_340* display, uint32_t* io_buffer);
\ No newline at end of file
+void initialize_terminal_display(display_340* display, uint32_t* io_buffer, live_metrics* metrics, bool raw_input);
+bool display_poll_events(display_340* display);
+void display_output(display_340* display);
+void close_display(display_340* display);
+void initialize_display(display_340* display, uint32_t* io_buffer, keyboard_device* keyboard, live_metrics* metrics, memory_heatmap* heatmap);
\ No newline at end of file
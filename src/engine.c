@@ -0,0 +1,65 @@
+#include "engine.h"
+#include <string.h>
+
+// The reference engine follows the machine's model; the model engines run
+// their own interpreter whatever the machine says, so lockstep can hold one
+// model against another.
+#define MODEL_ENGINE(name, model) { #name, step_##name, run_##name##_instructions },
+
+static const cpu_engine engines[] = {
+    { "reference", perform_cycle, run_instructions },
+    PDP7_MODELS(MODEL_ENGINE)
+};
+
+static const struct {
+    const char* name;
+    uint8_t model;
+} models[] = {
+#define MODEL_NAME(name, model) { #name, model },
+    PDP7_MODELS(MODEL_NAME)
+#undef MODEL_NAME
+};
+
+#define MODEL_COUNT (sizeof(models) / sizeof(models[0]))
+
+#define ENGINE_COUNT (sizeof(engines) / sizeof(engines[0]))
+
+const cpu_engine* find_engine(const char* name) {
+    for (size_t i = 0; i < ENGINE_COUNT; i++) {
+        if (strcmp(engines[i].name, name) == 0) {
+            return &engines[i];
+        }
+    }
+    return NULL;
+}
+
+// Space separated list for usage and error messages
+const char* engine_names(void) {
+    static char names[256];
+
+    if (names[0] == '\0') {
+        for (size_t i = 0; i < ENGINE_COUNT; i++) {
+            if (i > 0) {
+                strncat(names, " ", sizeof(names) - strlen(names) - 1);
+            }
+            strncat(names, engines[i].name, sizeof(names) - strlen(names) - 1);
+        }
+    }
+    return names;
+}
+
+// MODEL_* bit for a name like "pdp9", 0 if there is no such model
+uint8_t find_model(const char* name) {
+    for (size_t i = 0; i < MODEL_COUNT; i++) {
+        if (strcmp(models[i].name, name) == 0) {
+            return models[i].model;
+        }
+    }
+    return 0;
+}
+
+const char* model_names(void) {
+#define MODEL_LIST(name, model) " " #name
+    return PDP7_MODELS(MODEL_LIST) + 1;
+#undef MODEL_LIST
+}
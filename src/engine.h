@@ -0,0 +1,18 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdint.h>
+
+// An execution engine runs PDP7_cpu state however it likes internally, but
+// must leave the same registers and memory behind as the reference
+// interpreter. The lockstep checker holds engines to that.
+typedef struct {
+    const char* name;
+    void (*step)(PDP7_cpu* cpu);                            // Executes one instruction
+    uint64_t (*run)(PDP7_cpu* cpu, uint64_t instructions);  // Up to `instructions`, stops on HLT
+} cpu_engine;
+
+const cpu_engine* find_engine(const char* name);
+const char* engine_names(void);
+uint8_t find_model(const char* name);
+const char* model_names(void);
@@ -0,0 +1,74 @@
+#include "fuzz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+pdp7_fuzzer* create_fuzzer(const char* program_file, const char* memory_file, uint32_t start_address, uint64_t cycles) {
+    pdp7_fuzzer* fuzzer = aligned_alloc(_Alignof(pdp7_fuzzer), sizeof(pdp7_fuzzer));
+    if (!fuzzer) {
+        fprintf(stderr, "Failed to allocate the fuzzer\n");
+        exit(1);
+    }
+    memset(fuzzer, 0, sizeof(pdp7_fuzzer));
+
+    // Output is dropped (no io_buffer), input only comes from fuzz data
+    initialize_cpu(&fuzzer->base, program_file, memory_file, NULL, start_address);
+    initialize_keyboard(&fuzzer->keyboard, false, false);
+    fuzzer->base.keyboard = &fuzzer->keyboard;
+
+    // The base stays as loaded, runs write to pages of their own
+    initialize_memory(&fuzzer->cpu);
+    restore_cpu(&fuzzer->cpu, &fuzzer->base);
+    share_memory(&fuzzer->cpu, &fuzzer->base);
+    fuzzer->cycles = cycles ? cycles : FUZZ_DEFAULT_CYCLES;
+
+    return fuzzer;
+}
+
+void destroy_fuzzer(pdp7_fuzzer* fuzzer) {
+    free_memory(&fuzzer->cpu);
+    free_memory(&fuzzer->base);
+    free(fuzzer);
+}
+
+void fuzz_reset(pdp7_fuzzer* fuzzer) {
+    restore_cpu(&fuzzer->cpu, &fuzzer->base);
+    initialize_keyboard(&fuzzer->keyboard, false, false);
+}
+
+// Input is a byte stream. A byte with FUZZ_KEY_FLAG set types its low seven
+// bits on the keyboard; any other byte starts a poke of FUZZ_POKE_BYTES:
+// the low seven bits and the next byte give the address, the following
+// three bytes the word. A truncated poke at the end is ignored.
+void fuzz_apply_input(pdp7_fuzzer* fuzzer, const uint8_t* data, size_t size) {
+    size_t i = 0;
+
+    while (i < size) {
+        if (data[i] & FUZZ_KEY_FLAG) {
+            keyboard_push(&fuzzer->keyboard, data[i] & 0177);
+            i++;
+            continue;
+        }
+
+        if (size - i < FUZZ_POKE_BYTES) {
+            break;
+        }
+        uint32_t address = ((uint32_t)data[i] << 8) | data[i + 1];
+        uint32_t word = ((uint32_t)data[i + 2] << 16) | ((uint32_t)data[i + 3] << 8) | data[i + 4];
+        write_memory(&fuzzer->cpu, address & (MEMORY_SIZE - 1), word & 0777777);
+        i += FUZZ_POKE_BYTES;
+    }
+}
+
+// Resets the machine, applies one input and runs it to an outcome
+fuzz_outcome fuzz_run(pdp7_fuzzer* fuzzer, const uint8_t* data, size_t size) {
+    fuzz_reset(fuzzer);
+    fuzz_apply_input(fuzzer, data, size);
+    run_cycles(&fuzzer->cpu, fuzzer->cycles);
+
+    fuzz_outcome outcome = fuzzer->cpu.trap != TRAP_NONE ? FUZZ_TRAP :
+                           !fuzzer->cpu.running ? FUZZ_HALT : FUZZ_TIMEOUT;
+    fuzzer->runs++;
+    fuzzer->outcomes[outcome]++;
+    return outcome;
+}
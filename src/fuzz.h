@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "keyboard.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define FUZZ_DEFAULT_CYCLES 100000 // Cycle budget per input
+#define FUZZ_KEY_FLAG 0x80         // Input byte is a keystroke, not the start of a poke
+#define FUZZ_POKE_BYTES 5          // 15-bit address, 18-bit word, big endian
+
+typedef enum {
+    FUZZ_HALT,       // Program ran HLT
+    FUZZ_TRAP,       // Unknown opcode, OPR or IOT, see cpu.trap
+    FUZZ_TIMEOUT,    // Cycle budget used up
+} fuzz_outcome;
+
+// One machine loaded once and reset between inputs. Only pages the last
+// input dirtied are copied back from the base, so a reset costs about as
+// much as the memory the guest actually touched.
+typedef struct {
+    PDP7_cpu base;               // Loaded image, never run
+    PDP7_cpu cpu;                // Machine under test
+    keyboard_device keyboard;
+    uint64_t cycles;             // Budget per input
+    uint64_t runs;
+    uint64_t outcomes[FUZZ_TIMEOUT + 1];
+} pdp7_fuzzer;
+
+pdp7_fuzzer* create_fuzzer(const char* program_file, const char* memory_file, uint32_t start_address, uint64_t cycles);
+void destroy_fuzzer(pdp7_fuzzer* fuzzer);
+void fuzz_reset(pdp7_fuzzer* fuzzer);
+void fuzz_apply_input(pdp7_fuzzer* fuzzer, const uint8_t* data, size_t size);
+fuzz_outcome fuzz_run(pdp7_fuzzer* fuzzer, const uint8_t* data, size_t size);
@@ -0,0 +1,496 @@
+#include "gdb_stub.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define GDB_MAILBOX_SLEEP_US 100
+
+// Framing states of the stub thread
+#define FRAME_IDLE 0
+#define FRAME_DATA 1
+#define FRAME_CHECKSUM_HIGH 2
+#define FRAME_CHECKSUM_LOW 3
+
+static const char TARGET_XML[] =
+    "<?xml version=\"1.0\"?>"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+    "<target version=\"1.0\"><feature name=\"org.pdp7.core\">"
+    "<reg name=\"ac\" bitsize=\"32\" type=\"uint32\" regnum=\"0\"/>"
+    "<reg name=\"link\" bitsize=\"32\" type=\"uint32\"/>"
+    "<reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\"/>"
+    "<reg name=\"extend\" bitsize=\"32\" type=\"uint32\"/>"
+    "</feature></target>";
+
+void* run_gdb_stub(void* stub_arg);
+void serve_client(gdb_stub* stub);
+void post_packet(gdb_stub* stub, const char* packet);
+void send_packet(int fd, const char* data);
+int hex_digit(char c);
+bool parse_hex(const char** text, uint32_t* value);
+void put_word(char* text, uint32_t value);
+bool get_word(const char* text, uint32_t* value);
+uint32_t read_register(const PDP7_cpu* cpu, uint32_t number);
+void write_register(PDP7_cpu* cpu, uint32_t number, uint32_t value);
+void read_bytes(const PDP7_cpu* cpu, uint32_t address, uint32_t length, char* reply);
+bool write_bytes(PDP7_cpu* cpu, uint32_t address, uint32_t length, const char* data);
+bool set_breakpoint(gdb_stub* stub, const char* packet);
+void query(const char* packet, char* reply);
+
+// Listens on `address`: a number is a TCP port on the loopback interface,
+// anything else the path of a Unix socket
+gdb_stub* create_gdb_stub(const char* address) {
+    gdb_stub* stub = calloc(1, sizeof(gdb_stub));
+    if (!stub) {
+        fprintf(stderr, "Failed to allocate the GDB stub\n");
+        exit(1);
+    }
+    snprintf(stub->address, sizeof(stub->address), "%s", address);
+    initialize_debugger(&stub->debugger);
+    stub->fd = -1;
+
+    bool tcp = address[0] != '\0' && strspn(address, "0123456789") == strlen(address);
+    int bound;
+
+    if (tcp) {
+        struct sockaddr_in inet = { 0 };
+        int reuse = 1;
+        inet.sin_family = AF_INET;
+        inet.sin_port = htons((uint16_t)atoi(address));
+        inet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        stub->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(stub->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        bound = bind(stub->listen_fd, (struct sockaddr*)&inet, sizeof(inet));
+    } else {
+        struct sockaddr_un local = { 0 };
+        struct stat existing;
+        local.sun_family = AF_UNIX;
+        snprintf(local.sun_path, sizeof(local.sun_path), "%s", address);
+        // A socket left behind by an earlier run, never a regular file
+        if (stat(address, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+            unlink(address);
+        }
+        stub->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        bound = bind(stub->listen_fd, (struct sockaddr*)&local, sizeof(local));
+    }
+
+    if (stub->listen_fd < 0 || bound < 0 || listen(stub->listen_fd, 1) < 0) {
+        fprintf(stderr, "Failed to listen for GDB on %s\n", address);
+        exit(1);
+    }
+
+    printf("GDB stub listening on %s%s\n", tcp ? "localhost:" : "", address);
+    if (pthread_create(&stub->thread, NULL, run_gdb_stub, stub) != 0) {
+        fprintf(stderr, "Failed to start the GDB stub thread\n");
+        exit(1);
+    }
+    return stub;
+}
+
+void destroy_gdb_stub(gdb_stub* stub) {
+    atomic_store(&stub->quit, true);
+    pthread_join(stub->thread, NULL);
+    close(stub->listen_fd);
+    if (strspn(stub->address, "0123456789") != strlen(stub->address)) {
+        unlink(stub->address);
+    }
+    free(stub);
+}
+
+// Stub thread: one client at a time, for as long as the machine runs
+void* run_gdb_stub(void* stub_arg) {
+    gdb_stub* stub = (gdb_stub*)stub_arg;
+    struct pollfd listener = { .fd = stub->listen_fd, .events = POLLIN };
+
+    while (!atomic_load(&stub->quit)) {
+        if (poll(&listener, 1, GDB_POLL_MS) <= 0) {
+            continue;
+        }
+        stub->fd = accept(stub->listen_fd, NULL, NULL);
+        if (stub->fd < 0) {
+            continue;
+        }
+
+        // GDB expects a stopped target and asks why with `?`
+        stub->state = FRAME_IDLE;
+        atomic_store(&stub->connected, true);
+        atomic_store(&stub->attach, true);
+        atomic_store(&stub->attention, true);
+
+        serve_client(stub);
+
+        close(stub->fd);
+        stub->fd = -1;
+    }
+    return NULL;
+}
+
+void serve_client(gdb_stub* stub) {
+    struct pollfd client = { .fd = stub->fd, .events = POLLIN };
+    uint8_t input[GDB_PACKET_SIZE];
+
+    while (!atomic_load(&stub->quit)) {
+        if (atomic_load_explicit(&stub->outbox_full, memory_order_acquire)) {
+            send_packet(stub->fd, stub->outbox);
+            atomic_store_explicit(&stub->outbox_full, false, memory_order_release);
+        }
+
+        if (poll(&client, 1, GDB_POLL_MS) <= 0) {
+            continue;
+        }
+
+        ssize_t length = read(stub->fd, input, sizeof(input));
+        if (length <= 0) {
+            // Hung up without detaching, the machine runs on by itself
+            post_packet(stub, "D");
+            break;
+        }
+        for (ssize_t i = 0; i < length; i++) {
+            frame_byte(stub, input[i]);
+        }
+    }
+
+    atomic_store(&stub->connected, false);
+    atomic_store(&stub->outbox_full, false);
+}
+
+// $<data>#<checksum>, acknowledged with + or -. A bare 0x03 is Ctrl-C.
+void frame_byte(gdb_stub* stub, uint8_t byte) {
+    int digit;
+
+    switch (stub->state) {
+        case FRAME_IDLE:
+            if (byte == '$') {
+                stub->state = FRAME_DATA;
+                stub->length = 0;
+                stub->checksum = 0;
+            } else if (byte == 0x03) {
+                atomic_store(&stub->interrupt, true);
+                atomic_store(&stub->attention, true);
+            }
+            break;
+        case FRAME_DATA:
+            if (byte == '#') {
+                stub->state = FRAME_CHECKSUM_HIGH;
+            } else {
+                if (stub->length < GDB_PACKET_SIZE - 1) {
+                    stub->packet[stub->length++] = (char)byte;
+                }
+                stub->checksum += byte;
+            }
+            break;
+        case FRAME_CHECKSUM_HIGH:
+            digit = hex_digit((char)byte);
+            if (digit < 0) {
+                // Not a checksum digit, the frame fails like a wrong sum
+                stub->state = FRAME_IDLE;
+                send(stub->fd, "-", 1, MSG_NOSIGNAL);
+                break;
+            }
+            stub->received = (uint8_t)(digit << 4);
+            stub->state = FRAME_CHECKSUM_LOW;
+            break;
+        case FRAME_CHECKSUM_LOW:
+            digit = hex_digit((char)byte);
+            stub->state = FRAME_IDLE;
+            if (digit < 0 || (uint8_t)(stub->received | digit) != stub->checksum) {
+                send(stub->fd, "-", 1, MSG_NOSIGNAL);
+                break;
+            }
+            send(stub->fd, "+", 1, MSG_NOSIGNAL);
+            stub->packet[stub->length] = '\0';
+            stub->packets++;
+            post_packet(stub, stub->packet);
+            break;
+    }
+}
+
+// Hands a packet to the CPU thread, which takes it at its next slice boundary
+void post_packet(gdb_stub* stub, const char* packet) {
+    while (atomic_load_explicit(&stub->inbox_full, memory_order_acquire) && !atomic_load(&stub->quit)) {
+        // The CPU may be waiting to reply before it takes the next packet
+        if (atomic_load_explicit(&stub->outbox_full, memory_order_acquire)) {
+            send_packet(stub->fd, stub->outbox);
+            atomic_store_explicit(&stub->outbox_full, false, memory_order_release);
+        }
+        usleep(GDB_MAILBOX_SLEEP_US);
+    }
+    snprintf(stub->inbox, sizeof(stub->inbox), "%s", packet);
+    atomic_store_explicit(&stub->inbox_full, true, memory_order_release);
+    atomic_store(&stub->attention, true);
+}
+
+void send_packet(int fd, const char* data) {
+    char frame[GDB_PACKET_SIZE + 4];
+    uint8_t checksum = 0;
+
+    for (const char* c = data; *c != '\0'; c++) {
+        checksum += (uint8_t)*c;
+    }
+    int length = snprintf(frame, sizeof(frame), "$%s#%02x", data, checksum);
+    send(fd, frame, (size_t)length, MSG_NOSIGNAL);
+}
+
+// CPU thread side of the mailbox
+bool gdb_receive(gdb_stub* stub, char* packet) {
+    if (!atomic_load_explicit(&stub->inbox_full, memory_order_acquire)) {
+        return false;
+    }
+    memcpy(packet, stub->inbox, GDB_PACKET_SIZE);
+    atomic_store_explicit(&stub->inbox_full, false, memory_order_release);
+    return true;
+}
+
+// Dropped when nobody is attached any more
+void gdb_send(gdb_stub* stub, const char* reply) {
+    while (atomic_load_explicit(&stub->outbox_full, memory_order_acquire)) {
+        if (!atomic_load(&stub->connected)) {
+            return;
+        }
+        usleep(GDB_MAILBOX_SLEEP_US);
+    }
+    if (!atomic_load(&stub->connected)) {
+        return;
+    }
+    snprintf(stub->outbox, sizeof(stub->outbox), "%s", reply);
+    atomic_store_explicit(&stub->outbox_full, true, memory_order_release);
+}
+
+void gdb_stop_reply(const PDP7_cpu* cpu, int signal, char* reply) {
+    sprintf(reply, "S%02x", cpu->trap != TRAP_NONE ? GDB_SIGILL : signal);
+}
+
+// Executes one packet against the stopped machine. Replies are left in
+// `reply`, empty for packets the stub does not support.
+gdb_action gdb_execute(gdb_stub* stub, PDP7_cpu* cpu, const char* packet, char* reply) {
+    const char* arguments = packet + 1;
+    uint32_t address, length, value;
+
+    reply[0] = '\0';
+
+    switch (packet[0]) {
+        case '?':
+            gdb_stop_reply(cpu, GDB_SIGTRAP, reply);
+            break;
+        case 'g':
+            for (uint32_t number = 0; number < GDB_REGISTERS; number++) {
+                put_word(reply + number * 8, read_register(cpu, number));
+            }
+            break;
+        case 'G':
+            for (uint32_t number = 0; number < GDB_REGISTERS && get_word(arguments, &value); number++) {
+                write_register(cpu, number, value);
+                arguments += 8;
+            }
+            strcpy(reply, "OK");
+            break;
+        case 'p':
+            if (!parse_hex(&arguments, &address) || address >= GDB_REGISTERS) {
+                strcpy(reply, "E01");
+                break;
+            }
+            put_word(reply, read_register(cpu, address));
+            break;
+        case 'P':
+            if (!parse_hex(&arguments, &address) || *arguments++ != '=' || address >= GDB_REGISTERS ||
+                !get_word(arguments, &value)) {
+                strcpy(reply, "E01");
+                break;
+            }
+            write_register(cpu, address, value);
+            strcpy(reply, "OK");
+            break;
+        case 'm':
+            if (!parse_hex(&arguments, &address) || *arguments++ != ',' || !parse_hex(&arguments, &length) ||
+                length > (GDB_PACKET_SIZE - 1) / 2 || address + length > MEMORY_SIZE * 4) {
+                strcpy(reply, "E01");
+                break;
+            }
+            read_bytes(cpu, address, length, reply);
+            break;
+        case 'M':
+            if (!parse_hex(&arguments, &address) || *arguments++ != ',' || !parse_hex(&arguments, &length) ||
+                *arguments++ != ':' || address + length > MEMORY_SIZE * 4 ||
+                strlen(arguments) < length * 2 || !write_bytes(cpu, address, length, arguments)) {
+                strcpy(reply, "E01");
+                break;
+            }
+            strcpy(reply, "OK");
+            break;
+        case 'c':
+        case 's':
+            // Optional resume address
+            if (parse_hex(&arguments, &address)) {
+                cpu->pc = (address / 4) & (MEMORY_SIZE - 1);
+            }
+            return packet[0] == 'c' ? GDB_CONTINUE : GDB_STEP;
+        case 'Z':
+        case 'z':
+            strcpy(reply, set_breakpoint(stub, packet) ? "OK" : "");
+            break;
+        case 'D':
+            strcpy(reply, "OK");
+            return GDB_DETACH;
+        case 'k':
+            return GDB_KILL;
+        case 'H':
+        case 'T':
+            // One thread, always alive
+            strcpy(reply, "OK");
+            break;
+        case 'q':
+            query(packet, reply);
+            break;
+    }
+    return GDB_REPLY;
+}
+
+// Z<type>,<address>,<kind> and z to remove: 0 and 1 break, 2 watches
+// writes, 3 reads and 4 both
+bool set_breakpoint(gdb_stub* stub, const char* packet) {
+    static const uint8_t FLAGS[] = {
+        DEBUG_BREAK, DEBUG_BREAK, DEBUG_WATCH_WRITE, DEBUG_WATCH_READ, DEBUG_WATCH_READ | DEBUG_WATCH_WRITE,
+    };
+    const char* arguments = packet + 1;
+    uint32_t type, address, kind;
+
+    if (!parse_hex(&arguments, &type) || type > 4 || *arguments++ != ',' || !parse_hex(&arguments, &address) ||
+        *arguments++ != ',' || !parse_hex(&arguments, &kind)) {
+        return false;
+    }
+
+    uint32_t first = address / 4;
+    uint32_t last = type < 2 ? first : (address + (kind ? kind : 1) - 1) / 4;
+    if (packet[0] == 'Z') {
+        debugger_flag_range(&stub->debugger, first, last, FLAGS[type]);
+    } else {
+        debugger_unflag_range(&stub->debugger, first, last, FLAGS[type]);
+    }
+    return true;
+}
+
+void query(const char* packet, char* reply) {
+    uint32_t offset, length;
+
+    if (strncmp(packet, "qSupported", 10) == 0) {
+        sprintf(reply, "PacketSize=%x;qXfer:features:read+", GDB_PACKET_SIZE - 1);
+    } else if (strcmp(packet, "qAttached") == 0) {
+        strcpy(reply, "1");
+    } else if (strcmp(packet, "qC") == 0) {
+        strcpy(reply, "QC1");
+    } else if (strcmp(packet, "qfThreadInfo") == 0) {
+        strcpy(reply, "m1");
+    } else if (strcmp(packet, "qsThreadInfo") == 0) {
+        strcpy(reply, "l");
+    } else if (sscanf(packet, "qXfer:features:read:target.xml:%" SCNx32 ",%" SCNx32, &offset, &length) == 2) {
+        uint32_t size = sizeof(TARGET_XML) - 1;
+        if (offset >= size) {
+            strcpy(reply, "l");
+            return;
+        }
+        if (length > GDB_PACKET_SIZE - 2) {
+            length = GDB_PACKET_SIZE - 2;
+        }
+        uint32_t left = size - offset;
+        reply[0] = left > length ? 'm' : 'l';
+        snprintf(reply + 1, (left > length ? length : left) + 1, "%s", TARGET_XML + offset);
+    }
+}
+
+// PC is a byte address like everything else GDB sees
+uint32_t read_register(const PDP7_cpu* cpu, uint32_t number) {
+    switch (number) {
+        case GDB_REGISTER_AC:
+            return cpu->accumulator;
+        case GDB_REGISTER_LINK:
+            return cpu->link;
+        case GDB_REGISTER_PC:
+            return (cpu->pc & (MEMORY_SIZE - 1)) * 4;
+        default:
+            return cpu->extend_mode;
+    }
+}
+
+void write_register(PDP7_cpu* cpu, uint32_t number, uint32_t value) {
+    switch (number) {
+        case GDB_REGISTER_AC:
+            cpu->accumulator = value & 0777777;
+            break;
+        case GDB_REGISTER_LINK:
+            cpu->link = value & 1;
+            break;
+        case GDB_REGISTER_PC:
+            cpu->pc = (value / 4) & (MEMORY_SIZE - 1);
+            break;
+        default:
+            cpu->extend_mode = value & 1;
+    }
+}
+
+void read_bytes(const PDP7_cpu* cpu, uint32_t address, uint32_t length, char* reply) {
+    for (uint32_t i = 0; i < length; i++) {
+        uint32_t byte = address + i;
+        sprintf(reply + i * 2, "%02" PRIx32, (read_memory(cpu, byte / 4) >> (8 * (byte % 4))) & 0xff);
+    }
+    reply[length * 2] = '\0';
+}
+
+// Bytes land in their word, which keeps its 18 bits
+bool write_bytes(PDP7_cpu* cpu, uint32_t address, uint32_t length, const char* data) {
+    for (uint32_t i = 0; i < length; i++) {
+        int high = hex_digit(data[i * 2]), low = hex_digit(data[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        uint32_t byte = address + i;
+        uint32_t shift = 8 * (byte % 4);
+        uint32_t word = read_memory(cpu, byte / 4) & ~(0xffu << shift);
+        write_memory(cpu, byte / 4, (word | (uint32_t)(high << 4 | low) << shift) & 0777777);
+    }
+    return true;
+}
+
+// Little-endian, as GDB reads a 32-bit register
+void put_word(char* text, uint32_t value) {
+    for (int byte = 0; byte < 4; byte++) {
+        sprintf(text + byte * 2, "%02" PRIx32, (value >> (8 * byte)) & 0xff);
+    }
+}
+
+bool get_word(const char* text, uint32_t* value) {
+    *value = 0;
+    for (int digit = 0; digit < 8; digit++) {
+        int nibble = hex_digit(text[digit]);
+        if (nibble < 0) {
+            return false;
+        }
+        *value |= (uint32_t)nibble << (8 * (digit / 2) + (digit % 2 ? 0 : 4));
+    }
+    return true;
+}
+
+int hex_digit(char c) {
+    if (isdigit((unsigned char)c)) {
+        return c - '0';
+    }
+    c = (char)tolower((unsigned char)c);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+bool parse_hex(const char** text, uint32_t* value) {
+    const char* start = *text;
+    *value = 0;
+    while (hex_digit(**text) >= 0) {
+        *value = *value << 4 | (uint32_t)hex_digit(**text);
+        (*text)++;
+    }
+    return *text != start;
+}
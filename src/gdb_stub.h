@@ -0,0 +1,74 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "debugger.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GDB_PACKET_SIZE 4096
+#define GDB_POLL_INSTRUCTIONS 4096 // Instructions run between mailbox checks
+#define GDB_POLL_MS 10             // Socket poll timeout of the stub thread
+
+// GDB numbering of the registers in a `g` packet, 32 bits each
+#define GDB_REGISTER_AC 0
+#define GDB_REGISTER_LINK 1
+#define GDB_REGISTER_PC 2
+#define GDB_REGISTER_EXTEND 3
+#define GDB_REGISTERS 4
+
+// Signals in stop replies
+#define GDB_SIGINT 2    // Interrupted by the client
+#define GDB_SIGILL 4    // The machine trapped on a word it cannot execute
+#define GDB_SIGTRAP 5   // Breakpoint, watchpoint, step or HLT
+
+// What the CPU thread does after executing a packet
+typedef enum {
+    GDB_REPLY,      // Send the reply and stay stopped
+    GDB_CONTINUE,   // Resume, the stop reply comes later
+    GDB_STEP,       // One instruction, then a stop reply
+    GDB_DETACH,     // Send the reply, drop breakpoints and run on unobserved
+    GDB_KILL,       // Stop the machine for good
+} gdb_action;
+
+// GDB remote protocol stub. The stub thread owns the socket: it accepts
+// one client at a time, frames and acknowledges packets and turns a
+// Ctrl-C into `interrupt`. Packets are executed on the CPU thread, which
+// looks at the mailbox only between slices of GDB_POLL_INSTRUCTIONS (or
+// while stopped), so an attached debugger costs the run loop nothing per
+// instruction. Guest memory is byte addressed for GDB: word N is the four
+// little-endian bytes at 4N.
+typedef struct gdb_stub {
+    int listen_fd;
+    int fd;                          // Connected client, -1 while nobody is attached
+    char address[108];               // Socket path, or the TCP port
+    pthread_t thread;
+    cpu_debugger debugger;           // Breakpoints and watchpoints, CPU thread only
+
+    char inbox[GDB_PACKET_SIZE];     // Packet waiting for the CPU thread
+    char outbox[GDB_PACKET_SIZE];    // Reply waiting for the stub thread
+    atomic_bool inbox_full;
+    atomic_bool outbox_full;
+    atomic_bool attention;           // cpu->attention during the session
+    atomic_bool attach;              // A client connected, stop quietly
+    atomic_bool interrupt;           // The client sent Ctrl-C
+    atomic_bool connected;
+    atomic_bool quit;
+
+    // Stub thread framing state
+    char packet[GDB_PACKET_SIZE];
+    uint32_t length;
+    int state;
+    uint8_t checksum;                // Sum of the packet's bytes so far
+    uint8_t received;                // Checksum sent by the client
+    uint64_t packets;                // Packets received over the stub's life
+} gdb_stub;
+
+gdb_stub* create_gdb_stub(const char* address);
+void destroy_gdb_stub(gdb_stub* stub);
+gdb_action gdb_execute(gdb_stub* stub, PDP7_cpu* cpu, const char* packet, char* reply);
+void gdb_stop_reply(const PDP7_cpu* cpu, int signal, char* reply);
+void frame_byte(gdb_stub* stub, uint8_t byte);
+bool gdb_receive(gdb_stub* stub, char* packet);
+void gdb_send(gdb_stub* stub, const char* reply);
@@ -0,0 +1,95 @@
+#include "heatmap.h"
+#include "pdp7_isa.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+uint8_t heat_intensity(float heat);
+
+memory_heatmap* create_heatmap(void) {
+    memory_heatmap* heatmap = calloc(1, sizeof(memory_heatmap));
+    if (!heatmap) {
+        fprintf(stderr, "Failed to allocate the memory heatmap\n");
+        exit(1);
+    }
+    return heatmap;
+}
+
+void destroy_heatmap(memory_heatmap* heatmap) {
+    free(heatmap);
+}
+
+// Called after decode, before execute, so memory_address is still the
+// effective address of this instruction and not of an XCT target
+void heatmap_record(memory_heatmap* heatmap, const PDP7_cpu* cpu, uint32_t pc, uint32_t instruction) {
+    uint32_t opcode = (instruction >> 12) & 074;
+
+    heatmap_count(heatmap, HEAT_EXECUTE, pc);
+    if (opcode == OP_IOT || opcode == OP_OPR) {
+        return;
+    }
+
+    if (instruction & 020000) {
+        heatmap_count(heatmap, HEAT_READ, resolve_address(cpu, instruction & 017777, false));
+    }
+
+    switch (opcode) {
+        case OP_DAC:
+        case OP_DZM:
+        case OP_JMS:
+            heatmap_count(heatmap, HEAT_WRITE, cpu->memory_address);
+            break;
+        case OP_CAL:
+        case OP_ISZ:
+            heatmap_count(heatmap, HEAT_READ, cpu->memory_address);
+            heatmap_count(heatmap, HEAT_WRITE, cpu->memory_address);
+            break;
+        case OP_XCT:
+            heatmap_count(heatmap, HEAT_EXECUTE, cpu->memory_address);
+            break;
+        case OP_JMP:
+            break;
+        default:
+            heatmap_count(heatmap, HEAT_READ, cpu->memory_address);
+            break;
+    }
+}
+
+uint8_t heat_intensity(float heat) {
+    return (uint8_t)(255.0f * heat / (heat + HEATMAP_HALF_HEAT));
+}
+
+// Switches the view to another bank, dropping what piled up there while it
+// was not shown so it starts cold
+void heatmap_show_bank(memory_heatmap* heatmap, uint32_t bank) {
+    uint32_t base = (bank * BANK_SIZE) & (MEMORY_SIZE - 1);
+
+    heatmap->bank = base / BANK_SIZE;
+    for (int kind = 0; kind < HEAT_KINDS; kind++) {
+        for (uint32_t address = base; address < base + BANK_SIZE; address++) {
+            heatmap->sampled[kind][address] = atomic_load_explicit(&heatmap->counts[kind][address], memory_order_relaxed);
+            heatmap->heat[kind][address] = 0.0f;
+        }
+    }
+}
+
+// One frame: folds the accesses since the last sample into the heat of the
+// shown bank and redraws its pixels
+void heatmap_sample(memory_heatmap* heatmap) {
+    uint32_t base = (heatmap->bank * BANK_SIZE) & (MEMORY_SIZE - 1);
+
+    for (uint32_t cell = 0; cell < BANK_SIZE; cell++) {
+        uint32_t address = base + cell;
+        uint8_t intensity[HEAT_KINDS];
+
+        for (int kind = 0; kind < HEAT_KINDS; kind++) {
+            uint32_t count = atomic_load_explicit(&heatmap->counts[kind][address], memory_order_relaxed);
+            float heat = heatmap->heat[kind][address] * HEATMAP_DECAY + (uint32_t)(count - heatmap->sampled[kind][address]);
+            heatmap->sampled[kind][address] = count;
+            heatmap->heat[kind][address] = heat;
+            intensity[kind] = heat_intensity(heat);
+        }
+
+        heatmap->pixels[cell] = 0xff000000u | (uint32_t)intensity[HEAT_WRITE] << 16 |
+                                (uint32_t)intensity[HEAT_EXECUTE] << 8 | intensity[HEAT_READ];
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define HEATMAP_COLUMNS 128
+#define HEATMAP_ROWS 64           // 128x64 cells, one word each, shows one 8K bank
+#define HEATMAP_CELL_SIZE 6       // Pixels per cell side in the window
+#define HEATMAP_FRAME_MS 33       // Sampling and redraw interval
+#define HEATMAP_DECAY 0.85f       // Heat kept from one frame to the next
+#define HEATMAP_HALF_HEAT 16.0f   // Heat shown at half intensity
+
+typedef enum {
+    HEAT_READ,
+    HEAT_WRITE,
+    HEAT_EXECUTE,
+    HEAT_KINDS,
+} heat_kind;
+
+// Access counters are bumped by the CPU thread only and sampled by the
+// display thread, which turns the difference since its last sample into
+// decaying per-word heat. Nothing is ever reset, counters just wrap.
+typedef struct memory_heatmap {
+    _Atomic uint32_t counts[HEAT_KINDS][MEMORY_SIZE];
+
+    // Display thread side
+    uint32_t sampled[HEAT_KINDS][MEMORY_SIZE];
+    float heat[HEAT_KINDS][MEMORY_SIZE];
+    uint32_t pixels[HEATMAP_ROWS * HEATMAP_COLUMNS]; // ARGB, red write, green execute, blue read
+    uint32_t bank;                                   // Bank shown in pixels
+} memory_heatmap;
+
+memory_heatmap* create_heatmap(void);
+void destroy_heatmap(memory_heatmap* heatmap);
+void heatmap_record(memory_heatmap* heatmap, const PDP7_cpu* cpu, uint32_t pc, uint32_t instruction);
+void heatmap_show_bank(memory_heatmap* heatmap, uint32_t bank);
+void heatmap_sample(memory_heatmap* heatmap);
+
+// A plain increment: the counter has a single writer, the atomics only make
+// the sampler's concurrent read well defined
+static inline void heatmap_count(memory_heatmap* heatmap, heat_kind kind, uint32_t address) {
+    _Atomic uint32_t* count = &heatmap->counts[kind][address & (MEMORY_SIZE - 1)];
+    atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1, memory_order_relaxed);
+}
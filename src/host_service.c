@@ -0,0 +1,150 @@
+#include "host_service.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool host_service_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction);
+uint32_t host_service_run(host_service* host, PDP7_cpu* cpu, uint32_t operation, uint32_t address, uint32_t length);
+
+// Output goes to stdout when `output_file` is NULL or "-"
+host_service* create_host_service(const char* output_file, const char* input_file) {
+    host_service* host = calloc(1, sizeof(host_service));
+    if (host) {
+        host->words = malloc(MEMORY_SIZE * sizeof(uint32_t));
+        host->text = malloc(MEMORY_SIZE * 7);
+    }
+    if (!host || !host->words || !host->text) {
+        fprintf(stderr, "Failed to allocate the host service\n");
+        exit(1);
+    }
+
+    host->output = stdout;
+    if (output_file && strcmp(output_file, "-") != 0) {
+        host->output = fopen(output_file, "wb");
+        if (!host->output) {
+            fprintf(stderr, "Failed to open host output %s\n", output_file);
+            exit(1);
+        }
+    }
+    if (input_file) {
+        host->input = fopen(input_file, "rb");
+        if (!host->input) {
+            fprintf(stderr, "Failed to open host input %s\n", input_file);
+            exit(1);
+        }
+    }
+
+    initialize_iot_bus(&host->bus);
+    iot_attach(&host->bus, IOT_CODE_HOST, "host", NULL, host_service_pulse, host, 0);
+    return host;
+}
+
+void destroy_host_service(host_service* host) {
+    if (host->output != stdout) {
+        fclose(host->output);
+    } else {
+        fflush(stdout);
+    }
+    if (host->input) {
+        fclose(host->input);
+    }
+    free(host->words);
+    free(host->text);
+    free(host);
+}
+
+// The machine's bus becomes the host's, which keeps the standard devices
+void attach_host_service(host_service* host, PDP7_cpu* cpu) {
+    cpu->bus = &host->bus;
+}
+
+bool host_service_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    return host_service_iot(device, cpu, instruction);
+}
+
+// HSR: reads the descriptor at AC and runs it as one host call
+bool host_service_iot(host_service* host, PDP7_cpu* cpu, uint32_t instruction) {
+    if (instruction != IOT_HSR) {
+        return false;
+    }
+
+    uint32_t descriptor = cpu->accumulator & (MEMORY_SIZE - 1);
+    uint32_t operation = read_memory(cpu, descriptor + HOST_DESCRIPTOR_OPERATION);
+    uint32_t address = read_memory(cpu, (descriptor + HOST_DESCRIPTOR_ADDRESS) & (MEMORY_SIZE - 1));
+    uint32_t length = read_memory(cpu, (descriptor + HOST_DESCRIPTOR_LENGTH) & (MEMORY_SIZE - 1));
+
+    uint32_t count = length > MEMORY_SIZE ? HOST_ERROR :
+                     host_service_run(host, cpu, operation, address & (MEMORY_SIZE - 1), length);
+    cpu->accumulator = count;
+
+    // Words cross the data channel, one stolen cycle each
+    if (count != HOST_ERROR) {
+        cpu->cycles += count;
+        if (cpu->metrics) {
+            cpu->metrics->io_words += count;
+        }
+    }
+    return true;
+}
+
+// Words transferred, or HOST_ERROR. Ranges move a page at a time like the
+// data channel.
+uint32_t host_service_run(host_service* host, PDP7_cpu* cpu, uint32_t operation, uint32_t address, uint32_t length) {
+    size_t count;
+
+    switch (operation) {
+        case HOST_WRITE_OCTAL: {
+            read_memory_range(cpu, address, host->words, length);
+            char* text = host->text;
+            for (uint32_t i = 0; i < length; i++) {
+                uint32_t word = host->words[i];
+                for (int digit = 5; digit >= 0; digit--) {
+                    text[digit] = '0' + (word & 07);
+                    word >>= 3;
+                }
+                text[6] = '\n';
+                text += 7;
+            }
+            count = fwrite(host->text, 7, length, host->output);
+            break;
+        }
+        case HOST_WRITE_TEXT:
+            read_memory_range(cpu, address, host->words, length);
+            for (uint32_t i = 0; i < length; i++) {
+                host->text[i] = (char)(host->words[i] & 0377);
+            }
+            count = fwrite(host->text, 1, length, host->output);
+            break;
+        case HOST_READ_TEXT:
+            if (!host->input) {
+                return HOST_ERROR;
+            }
+            count = fread(host->text, 1, length, host->input);
+            for (size_t i = 0; i < count; i++) {
+                host->words[i] = (uint8_t)host->text[i];
+            }
+            write_memory_range(cpu, address, host->words, count);
+            break;
+        case HOST_READ_WORDS:
+            if (!host->input) {
+                return HOST_ERROR;
+            }
+            count = fread(host->words, sizeof(uint32_t), length, host->input);
+            for (size_t i = 0; i < count; i++) {
+                host->words[i] &= 0777777;
+            }
+            write_memory_range(cpu, address, host->words, count);
+            break;
+        case HOST_RESULT:
+            host->result = read_memory(cpu, address);
+            host->has_result = true;
+            return 1;
+        default:
+            return HOST_ERROR;
+    }
+
+    if (ferror(host->output) || (host->input && ferror(host->input))) {
+        return HOST_ERROR;
+    }
+    return count;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "iot_bus.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Paravirtual device of this emulator, not of the real machine: one IOT
+// hands the host a whole memory range instead of a word at a time
+#define IOT_CODE_HOST 050
+#define IOT_HSR 0705004 // Run the descriptor AC points at, AC gets the result
+
+// Descriptor, three words: operation, buffer address, length in words
+#define HOST_DESCRIPTOR_OPERATION 0
+#define HOST_DESCRIPTOR_ADDRESS 1
+#define HOST_DESCRIPTOR_LENGTH 2
+
+// Operations
+#define HOST_WRITE_OCTAL 1  // Buffer to the output, one octal word per line
+#define HOST_WRITE_TEXT 2   // Buffer to the output, the low eight bits of each word as a character
+#define HOST_READ_TEXT 3    // Input bytes into the buffer, one per word
+#define HOST_READ_WORDS 4   // Input host words into the buffer (the block storage file format)
+#define HOST_RESULT 5       // The buffer's first word is the run's result
+
+// AC after HSR: the words transferred, or this for a bad descriptor or a
+// failed host call
+#define HOST_ERROR 0400000
+
+typedef struct host_service {
+    iot_bus bus;             // The standard devices plus this one
+    FILE* output;            // stdout or the -O file
+    FILE* input;             // The -I file, NULL without one
+    uint32_t* words;         // MEMORY_SIZE words staged between memory and the host
+    char* text;              // Formatted output, up to seven characters per word
+    uint32_t result;
+    bool has_result;
+} host_service;
+
+host_service* create_host_service(const char* output_file, const char* input_file);
+void destroy_host_service(host_service* host);
+void attach_host_service(host_service* host, PDP7_cpu* cpu);
+bool host_service_iot(host_service* host, PDP7_cpu* cpu, uint32_t instruction);
@@ -0,0 +1,178 @@
+#include "instrument.h"
+#include "disassembler.h"
+
+#ifdef PDP7_INSTRUMENT
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#ifdef PDP7_INSTRUMENT_PERF
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define INSTRUMENT_OPCODES 16
+#define INSTRUMENT_SUBTYPES 128 // OPR and IOT words seen, open addressing
+
+typedef struct {
+    uint32_t word;
+    uint64_t count;
+    uint64_t ticks;
+} instrument_bucket;
+
+static instrument_bucket opcodes[INSTRUMENT_OPCODES];
+static instrument_bucket subtypes[INSTRUMENT_SUBTYPES];
+static uint64_t frames, frame_ticks, frame_max;
+static uint64_t run_ticks, run_ns, timer_overhead;
+static uint64_t run_start_ticks, run_start_ns;
+static int64_t host_instructions = -1;
+
+#ifdef PDP7_INSTRUMENT_PERF
+static int perf_fd = -1;
+#endif
+
+static uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+void instrument_instruction(uint32_t instruction, uint64_t elapsed) {
+    uint32_t opcode = (instruction >> 14) & 017;
+    opcodes[opcode].count++;
+    opcodes[opcode].ticks += elapsed;
+
+    if (opcode != 016 && opcode != 017) {
+        return;
+    }
+
+    // OPR and IOT are timed per microcoded word as well
+    uint32_t slot = (instruction * 2654435761u) >> 25;
+    for (int probe = 0; probe < INSTRUMENT_SUBTYPES; probe++) {
+        instrument_bucket* bucket = &subtypes[(slot + probe) & (INSTRUMENT_SUBTYPES - 1)];
+        if (bucket->count == 0 || bucket->word == instruction) {
+            bucket->word = instruction;
+            bucket->count++;
+            bucket->ticks += elapsed;
+            return;
+        }
+    }
+}
+
+void instrument_frame(uint64_t elapsed) {
+    frames++;
+    frame_ticks += elapsed;
+    if (elapsed > frame_max) {
+        frame_max = elapsed;
+    }
+}
+
+void instrument_run_begin(void) {
+    // Cost of an empty start/stop pair, subtracted from every sample
+    timer_overhead = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+        uint64_t start = instrument_now();
+        uint64_t elapsed = instrument_now() - start;
+        if (elapsed < timer_overhead) {
+            timer_overhead = elapsed;
+        }
+    }
+
+#ifdef PDP7_INSTRUMENT_PERF
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    perf_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (perf_fd < 0) {
+        fprintf(stderr, "perf_event_open failed, host instruction counts disabled\n");
+    } else {
+        ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+
+    run_start_ns = monotonic_ns();
+    run_start_ticks = instrument_now();
+}
+
+void instrument_run_end(void) {
+    run_ticks = instrument_now() - run_start_ticks;
+    run_ns = monotonic_ns() - run_start_ns;
+
+#ifdef PDP7_INSTRUMENT_PERF
+    if (perf_fd >= 0) {
+        ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(perf_fd, &host_instructions, sizeof(host_instructions)) != sizeof(host_instructions)) {
+            host_instructions = -1;
+        }
+        close(perf_fd);
+        perf_fd = -1;
+    }
+#endif
+}
+
+static double ticks_to_ns(uint64_t ticks) {
+    return run_ticks ? (double)ticks * run_ns / run_ticks : 0.0;
+}
+
+static void print_bucket(const char* name, const instrument_bucket* bucket, uint64_t total_ticks) {
+    uint64_t ticks = bucket->ticks - bucket->count * timer_overhead;
+    if (ticks > bucket->ticks) {
+        ticks = 0;
+    }
+
+    fprintf(stderr, "%-8s %12" PRIu64 " %14" PRIu64 " %10.2f %7.2f%%\n",
+            name, bucket->count, ticks, ticks_to_ns(ticks) / bucket->count,
+            total_ticks ? 100.0 * bucket->ticks / total_ticks : 0.0);
+}
+
+void instrument_report(void) {
+    uint64_t total_count = 0, total_ticks = 0;
+    for (int opcode = 0; opcode < INSTRUMENT_OPCODES; opcode++) {
+        total_count += opcodes[opcode].count;
+        total_ticks += opcodes[opcode].ticks;
+    }
+
+    fprintf(stderr, "\nHost instrumentation (timer overhead %" PRIu64 " ticks, subtracted)\n", timer_overhead);
+    fprintf(stderr, "%-8s %12s %14s %10s %8s\n", "Opcode", "Count", "Ticks", "ns/instr", "Share");
+    for (int opcode = 0; opcode < INSTRUMENT_OPCODES; opcode++) {
+        if (opcodes[opcode].count != 0) {
+            print_bucket(opcode_name((uint32_t)opcode << 14), &opcodes[opcode], total_ticks);
+        }
+    }
+
+    fprintf(stderr, "\n%-8s %12s %14s %10s %8s\n", "OPR/IOT", "Count", "Ticks", "ns/instr", "Share");
+    for (int i = 0; i < INSTRUMENT_SUBTYPES; i++) {
+        if (subtypes[i].count != 0) {
+            char name[16];
+            snprintf(name, sizeof(name), "%06" PRIo32, subtypes[i].word);
+            print_bucket(name, &subtypes[i], total_ticks);
+        }
+    }
+
+    if (total_count != 0) {
+        fprintf(stderr, "\nGuest instructions: %" PRIu64 ", run time %.3f ms, %.2f ns per instruction\n",
+                total_count, run_ns / 1e6, (double)run_ns / total_count);
+        if (host_instructions >= 0) {
+            fprintf(stderr, "Host instructions: %" PRId64 ", %.2f per guest instruction\n",
+                    host_instructions, (double)host_instructions / total_count);
+        }
+    }
+
+    if (frames != 0) {
+        fprintf(stderr, "Display frames: %" PRIu64 ", mean %.3f ms, max %.3f ms\n",
+                frames, ticks_to_ns(frame_ticks) / frames / 1e6, ticks_to_ns(frame_max) / 1e6);
+    }
+}
+
+#endif
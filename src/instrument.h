@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+
+// Host-side instrumentation of the interpreter and renderer. Build with
+// `make INSTRUMENT=1` (and `PERF=1` for host instruction counts); otherwise
+// every INSTRUMENT_* macro expands to nothing.
+#ifdef PDP7_INSTRUMENT
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t instrument_now(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+static inline uint64_t instrument_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+#endif
+
+void instrument_instruction(uint32_t instruction, uint64_t elapsed);
+void instrument_frame(uint64_t elapsed);
+void instrument_run_begin(void);
+void instrument_run_end(void);
+void instrument_report(void);
+
+#define INSTRUMENT_START(timer) uint64_t timer = instrument_now()
+#define INSTRUMENT_INSTRUCTION(timer, instruction) instrument_instruction(instruction, instrument_now() - timer)
+#define INSTRUMENT_FRAME(timer) instrument_frame(instrument_now() - timer)
+#define INSTRUMENT_RUN_BEGIN() instrument_run_begin()
+#define INSTRUMENT_RUN_END() instrument_run_end()
+#define INSTRUMENT_REPORT() instrument_report()
+
+#else
+
+#define INSTRUMENT_START(timer)
+#define INSTRUMENT_INSTRUCTION(timer, instruction)
+#define INSTRUMENT_FRAME(timer)
+#define INSTRUMENT_RUN_BEGIN()
+#define INSTRUMENT_RUN_END()
+#define INSTRUMENT_REPORT()
+
+#endif
@@ -0,0 +1,147 @@
+#include "iot_bus.h"
+#include "keyboard.h"
+#include "storage.h"
+#include "serial.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define OUTPUT_POLL_SPINS 65536   // TLS spin iterations between attention checks
+
+bool keyboard_device_flag(void* device, PDP7_cpu* cpu);
+bool keyboard_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction);
+bool output_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction);
+bool storage_device_flag(void* device, PDP7_cpu* cpu);
+bool storage_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction);
+
+// IOTs charge no cycles of their own, as before the bus
+const iot_bus standard_iot_bus = {
+    .devices = {
+        [IOT_CODE_KEYBOARD] = { "keyboard", keyboard_device_flag, keyboard_device_pulse, NULL, 0 },
+        [IOT_CODE_OUTPUT] = { "output", NULL, output_device_pulse, NULL, 0 },
+        [IOT_CODE_STORAGE] = { "storage", storage_device_flag, storage_device_pulse, NULL, 0 },
+        [IOT_CODE_STORAGE + 1] = { "storage", NULL, storage_device_pulse, NULL, 0 },
+        [IOT_CODE_STORAGE + 2] = { "storage", NULL, storage_device_pulse, NULL, 0 },
+    },
+};
+
+// A bus with the standard devices, for a machine to add its own to
+void initialize_iot_bus(iot_bus* bus) {
+    *bus = standard_iot_bus;
+}
+
+void iot_attach(iot_bus* bus, uint32_t code, const char* name, iot_flag flag, iot_pulse pulse, void* device,
+                uint32_t cycles) {
+    if (code >= IOT_DEVICES || code == IOT_CODE_MEMORY) {
+        fprintf(stderr, "Device code %o is not available for %s\n", code, name);
+        exit(1);
+    }
+    bus->devices[code] = (iot_device){ name, flag, pulse, device, cycles };
+}
+
+// KSF: a word on the serial line, else a key. Never blocks the host.
+bool keyboard_device_flag(void* device, PDP7_cpu* cpu) {
+    (void)device;
+    if (cpu->line_in) {
+        return serial_flag(cpu->line_in, cpu->cycles);
+    }
+    if (cpu->keyboard && keyboard_flag(cpu->keyboard, cpu->cycles)) {
+        return true;
+    }
+    if (cpu->keyboard && cpu->keyboard->replay_over) {
+        // The replayed session stopped while the guest waited for a key
+        cpu->running = false;
+    }
+    return false;
+}
+
+// KRB
+bool keyboard_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    (void)device;
+    if (instruction != IOT_KRB) {
+        return false;
+    }
+    if (cpu->line_in) {
+        cpu->accumulator = serial_read(cpu->line_in, cpu->cycles);
+    } else {
+        cpu->accumulator = cpu->keyboard ? keyboard_read(cpu->keyboard, cpu->cycles) : 0;
+    }
+    if (cpu->metrics) {
+        cpu->metrics->io_words++;
+    }
+    return true;
+}
+
+// TLS
+bool output_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    (void)device;
+    if (instruction != IOT_TLS) {
+        return false;
+    }
+    if (cpu->line_out) {
+        if (!serial_send(cpu->line_out, cpu, cpu->accumulator)) {
+            // Interrupted while the line was full, TLS runs again
+            cpu->pc = wrap_pc(cpu->pc - 1);
+        } else if (cpu->metrics) {
+            cpu->metrics->io_words++;
+        }
+        return true;
+    }
+    if (cpu->io_buffer == NULL) {
+        // No display behind this machine, the word is dropped
+        return true;
+    }
+    if (!wait_for_output(cpu)) {
+        // Interrupted, TLS (or the XCT of it) runs again
+        cpu->pc = wrap_pc(cpu->pc - 1);
+        return true;
+    }
+    if (cpu->metrics) {
+        cpu->metrics->io_words++;
+    }
+    *cpu->io_buffer = cpu->accumulator;
+    return true;
+}
+
+// DSSF
+bool storage_device_flag(void* device, PDP7_cpu* cpu) {
+    (void)device;
+    return cpu->storage && cpu->storage->flag;
+}
+
+// Block storage, ignored when no device is attached
+bool storage_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    (void)device;
+    return !cpu->storage || storage_iot(cpu->storage, cpu, instruction);
+}
+
+// Spins until the display has taken the previous word. Gives up, returning
+// false, when another thread raises the attention flag.
+bool wait_for_output(PDP7_cpu* cpu) {
+    volatile uint32_t* io_buffer = cpu->io_buffer;
+    if (*io_buffer == 0) {
+        return true;
+    }
+
+    if (cpu->metrics) {
+        metrics_wait_begin(cpu->metrics);
+    }
+
+    bool done = true;
+    for (uint32_t spins = 1; *io_buffer != 0; spins++) {
+        if (spins % OUTPUT_POLL_SPINS == 0) {
+            if (cpu->metrics) {
+                metrics_wait_update(cpu->metrics, cpu);
+            }
+            if (cpu->attention && atomic_load_explicit(cpu->attention, memory_order_relaxed)) {
+                done = false;
+                break;
+            }
+        }
+    }
+
+    if (cpu->metrics) {
+        metrics_wait_end(cpu->metrics);
+    }
+    return done;
+}
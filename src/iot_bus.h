@@ -0,0 +1,72 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// An IOT word is 70 <device code> <pulses>: six bits select one of 64
+// devices, the low three bits are the IOP1/IOP2/IOP4 pulses it receives
+#define IOT_DEVICES 64
+#define IOT_DEVICE_CODE(instruction) (((instruction) >> 6) & 077)
+#define IOT_IOP1 01    // Tests the device flag: skip when it is set
+#define IOT_IOP2 02
+#define IOT_IOP4 04
+#define IOT_PULSES 07
+
+// Device codes of the standard machine
+#define IOT_CODE_KEYBOARD 003
+#define IOT_CODE_OUTPUT 004   // Display, or the serial line of a networked machine
+#define IOT_CODE_STORAGE 060  // Through 062
+#define IOT_CODE_MEMORY 077   // Memory extension control, handled by the CPU itself
+
+#define IOT_TLS 0700406 // Send AC to the display or serial line
+
+typedef bool (*iot_flag)(void* device, PDP7_cpu* cpu);
+typedef bool (*iot_pulse)(void* device, PDP7_cpu* cpu, uint32_t instruction);
+
+// One device code. `flag` answers IOP1 (the skip is the bus's job), and
+// `pulse` gets the word whenever any other pulse, or no flag, is left; it
+// returns false for a word it does not implement, which traps. `cycles`
+// is charged for every IOT to the device.
+typedef struct {
+    const char* name;
+    iot_flag flag;
+    iot_pulse pulse;
+    void* device;                // Handed to flag and pulse, NULL for the standard devices
+    uint32_t cycles;
+} iot_device;
+
+typedef struct iot_bus {
+    iot_device devices[IOT_DEVICES];
+} iot_bus;
+
+// The keyboard, output and storage devices, reading what is attached
+// from the CPU. Every machine starts on it.
+extern const iot_bus standard_iot_bus;
+
+void initialize_iot_bus(iot_bus* bus);
+void iot_attach(iot_bus* bus, uint32_t code, const char* name, iot_flag flag, iot_pulse pulse, void* device,
+                uint32_t cycles);
+bool wait_for_output(PDP7_cpu* cpu);
+
+// Constant time whatever the number of devices: one table index
+static inline bool iot_dispatch(const iot_bus* bus, PDP7_cpu* cpu, uint32_t instruction) {
+    const iot_device* slot = &bus->devices[IOT_DEVICE_CODE(instruction)];
+    uint32_t pulses = instruction & IOT_PULSES;
+
+    if ((pulses & IOT_IOP1) && slot->flag) {
+        if (slot->flag(slot->device, cpu)) {
+            cpu->pc = wrap_pc(cpu->pc + 1);
+        }
+        pulses &= ~IOT_IOP1;
+    } else if (!slot->pulse) {
+        return false;
+    }
+
+    if ((pulses || !slot->flag) && (!slot->pulse || !slot->pulse(slot->device, cpu, instruction))) {
+        return false;
+    }
+
+    cpu->cycles += slot->cycles;
+    return true;
+}
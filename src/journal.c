@@ -0,0 +1,106 @@
+#include "journal.h"
+#include <stdlib.h>
+#include <string.h>
+
+void write_varint(FILE* file, uint64_t value);
+bool read_varint(FILE* file, uint64_t* value);
+
+// Opens a journal to record into, or to replay with its first keystroke
+// already read ahead
+input_journal* open_journal(const char* filename, bool replay) {
+    input_journal* journal = calloc(1, sizeof(input_journal));
+    if (!journal) {
+        fprintf(stderr, "Failed to allocate the input journal\n");
+        exit(1);
+    }
+
+    journal->file = fopen(filename, replay ? "rb" : "wb");
+    if (!journal->file) {
+        fprintf(stderr, "Failed to open journal %s\n", filename);
+        exit(1);
+    }
+    journal->replaying = replay;
+    journal->end_cycles = UINT64_MAX;
+
+    if (!replay) {
+        fwrite(JOURNAL_MAGIC, 1, JOURNAL_MAGIC_SIZE, journal->file);
+        return journal;
+    }
+
+    char magic[JOURNAL_MAGIC_SIZE];
+    if (fread(magic, 1, JOURNAL_MAGIC_SIZE, journal->file) != JOURNAL_MAGIC_SIZE ||
+        memcmp(magic, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE) != 0) {
+        fprintf(stderr, "%s is not an input journal\n", filename);
+        exit(1);
+    }
+    journal_advance(journal);
+    return journal;
+}
+
+// A recording gets its end record, the cycle the machine stopped at
+void close_journal(input_journal* journal, uint64_t cycles) {
+    if (!journal->replaying) {
+        write_varint(journal->file, (cycles - journal->last_cycles) << 1 | 1);
+    }
+    fclose(journal->file);
+    free(journal);
+}
+
+void journal_record(input_journal* journal, uint64_t cycles, uint8_t character) {
+    write_varint(journal->file, (cycles - journal->last_cycles) << 1);
+    fputc(character, journal->file);
+    journal->last_cycles = cycles;
+    journal->events++;
+}
+
+// Reads the next keystroke ahead. A journal cut short, without its end
+// record, just runs out of keys.
+void journal_advance(input_journal* journal) {
+    uint64_t value;
+    int character;
+
+    journal->pending = false;
+    if (journal->ended || !read_varint(journal->file, &value)) {
+        journal->ended = true;
+        return;
+    }
+
+    journal->last_cycles += value >> 1;
+    if (value & 1) {
+        journal->ended = true;
+        journal->end_cycles = journal->last_cycles;
+        return;
+    }
+    if ((character = fgetc(journal->file)) == EOF) {
+        journal->ended = true;
+        return;
+    }
+
+    journal->pending = true;
+    journal->next_cycles = journal->last_cycles;
+    journal->next_character = (uint8_t)character;
+    journal->events++;
+}
+
+void write_varint(FILE* file, uint64_t value) {
+    while (value >= 0x80) {
+        fputc((int)(value & 0x7f) | 0x80, file);
+        value >>= 7;
+    }
+    fputc((int)value, file);
+}
+
+bool read_varint(FILE* file, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
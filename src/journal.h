@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define JOURNAL_MAGIC "PDP7JNL1"
+#define JOURNAL_MAGIC_SIZE 8
+
+// Binary journal of the keystrokes a guest saw. After the magic, each
+// event is a LEB128 varint of (cycle delta << 1 | end) followed, unless
+// it is the end record, by the character. The cycle is the one at which
+// the guest first saw the key, so replay makes it visible at exactly that
+// point. The end record holds the cycle the session stopped at.
+typedef struct input_journal {
+    FILE* file;
+    bool replaying;
+    uint64_t last_cycles;        // Cycle of the previous event, deltas are from here
+    uint64_t events;             // Keystrokes written or read so far
+
+    // Replay lookahead
+    bool pending;                // next_cycles/next_character hold an unread keystroke
+    bool ended;                  // No keystrokes left
+    uint64_t next_cycles;
+    uint8_t next_character;
+    uint64_t end_cycles;         // Where the recorded session stopped, UINT64_MAX if unknown
+} input_journal;
+
+input_journal* open_journal(const char* filename, bool replay);
+void close_journal(input_journal* journal, uint64_t cycles);
+void journal_record(input_journal* journal, uint64_t cycles, uint8_t character);
+void journal_advance(input_journal* journal);
+
+// True while a replayed keystroke is due by `cycles`
+static inline bool journal_due(const input_journal* journal, uint64_t cycles) {
+    return journal->pending && journal->next_cycles <= cycles;
+}
+
+// The replayed session has nothing more to give and stopped by `cycles`
+static inline bool journal_over(const input_journal* journal, uint64_t cycles) {
+    return journal->ended && cycles >= journal->end_cycles;
+}
@@ -0,0 +1,100 @@
+#include "keyboard.h"
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+void keyboard_poll_stdin(keyboard_device* keyboard, uint64_t cycles);
+void keyboard_replay(keyboard_device* keyboard, uint64_t cycles);
+
+void initialize_keyboard(keyboard_device* keyboard, bool poll_stdin, bool from_console) {
+    atomic_store(&keyboard->head, 0);
+    atomic_store(&keyboard->tail, 0);
+    keyboard->buffer = 0;
+    keyboard->poll_stdin = poll_stdin;
+    keyboard->from_console = from_console;
+    keyboard->stdin_eof = false;
+    keyboard->last_poll = 0;
+    keyboard->record = NULL;
+    keyboard->replay = NULL;
+    keyboard->recorded = 0;
+    keyboard->replay_over = false;
+}
+
+bool keyboard_push(keyboard_device* keyboard, uint8_t character) {
+    uint32_t head = atomic_load_explicit(&keyboard->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&keyboard->tail, memory_order_acquire);
+
+    if (head - tail == KEYBOARD_BUFFER_SIZE) {
+        return false; // Full, the keystroke is dropped like on a real overrun
+    }
+
+    keyboard->ring[head & (KEYBOARD_BUFFER_SIZE - 1)] = character;
+    atomic_store_explicit(&keyboard->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool keyboard_flag(keyboard_device* keyboard, uint64_t cycles) {
+    uint32_t tail = atomic_load_explicit(&keyboard->tail, memory_order_relaxed);
+
+    if (keyboard->replay) {
+        keyboard_replay(keyboard, cycles);
+    } else if (atomic_load_explicit(&keyboard->head, memory_order_acquire) == tail && keyboard->poll_stdin) {
+        keyboard_poll_stdin(keyboard, cycles);
+    }
+
+    bool flag = atomic_load_explicit(&keyboard->head, memory_order_acquire) != tail;
+    if (flag && keyboard->record && keyboard->recorded == tail) {
+        journal_record(keyboard->record, cycles, keyboard->ring[tail & (KEYBOARD_BUFFER_SIZE - 1)]);
+        keyboard->recorded++;
+    }
+    return flag;
+}
+
+uint8_t keyboard_read(keyboard_device* keyboard, uint64_t cycles) {
+    if (keyboard_flag(keyboard, cycles)) {
+        uint32_t tail = atomic_load_explicit(&keyboard->tail, memory_order_relaxed);
+        keyboard->buffer = keyboard->ring[tail & (KEYBOARD_BUFFER_SIZE - 1)];
+        atomic_store_explicit(&keyboard->tail, tail + 1, memory_order_release);
+    }
+
+    return keyboard->buffer;
+}
+
+// Drains whatever stdin already holds without waiting. Polls are rate limited
+// by guest cycles so a KSF wait loop doesn't turn into a syscall loop.
+void keyboard_poll_stdin(keyboard_device* keyboard, uint64_t cycles) {
+    if (keyboard->stdin_eof || (keyboard->last_poll != 0 && cycles - keyboard->last_poll < KEYBOARD_POLL_CYCLES)) {
+        return;
+    }
+    keyboard->last_poll = cycles;
+
+    int flags = fcntl(STDIN_FILENO, F_GETFL);
+    fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+
+    int character;
+    while ((character = getchar()) != EOF) {
+        if (character == '\n') {
+            character = '\r'; // Teletype return
+        }
+        if (!keyboard_push(keyboard, (uint8_t)character)) {
+            ungetc(character, stdin);
+            break;
+        }
+    }
+
+    if (feof(stdin)) {
+        keyboard->stdin_eof = true;
+    }
+    clearerr(stdin);
+
+    fcntl(STDIN_FILENO, F_SETFL, flags);
+}
+
+// Moves the journal's keystrokes due by now into the ring, the way the
+// recorded session's keys had arrived by the time the guest looked
+void keyboard_replay(keyboard_device* keyboard, uint64_t cycles) {
+    while (journal_due(keyboard->replay, cycles) && keyboard_push(keyboard, keyboard->replay->next_character)) {
+        journal_advance(keyboard->replay);
+    }
+    keyboard->replay_over = journal_over(keyboard->replay, cycles);
+}
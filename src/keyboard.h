@@ -0,0 +1,36 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "journal.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define KEYBOARD_BUFFER_SIZE 64 // Must be a power of two
+#define KEYBOARD_POLL_CYCLES 1000 // Minimum cycles between stdin polls
+
+// Keyboard I/O instructions in octal (device code 03)
+#define IOT_KSF 0700301 // Skip if keyboard flag
+#define IOT_KRB 0700312 // Read keyboard buffer
+
+// Single-producer single-consumer ring: the display thread (or the CPU
+// thread itself when polling stdin) pushes, the CPU thread pops
+typedef struct keyboard_device {
+    uint8_t ring[KEYBOARD_BUFFER_SIZE];
+    _Atomic uint32_t head;   // Next slot to write (producer)
+    _Atomic uint32_t tail;   // Next slot to read (consumer)
+    uint8_t buffer;          // Keyboard buffer, keeps the last character read
+    bool poll_stdin;         // Read characters from stdin instead of SDL events
+    bool from_console;       // Fed by console `k` commands on the CPU thread
+    bool stdin_eof;          // Stdin is exhausted, stop polling it
+    uint64_t last_poll;      // Cycle count of the last stdin poll
+    input_journal* record;   // Logs each key when the guest first sees it (NULL when not recording)
+    input_journal* replay;   // Sole source of keys when replaying (NULL otherwise)
+    uint32_t recorded;       // Ring position of the next key to log
+    bool replay_over;        // The replayed session stopped here, so should the machine
+} keyboard_device;
+
+void initialize_keyboard(keyboard_device* keyboard, bool poll_stdin, bool from_console);
+bool keyboard_push(keyboard_device* keyboard, uint8_t character);
+bool keyboard_flag(keyboard_device* keyboard, uint64_t cycles);
+uint8_t keyboard_read(keyboard_device* keyboard, uint64_t cycles);
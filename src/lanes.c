@@ -0,0 +1,634 @@
+#include "lanes.h"
+#include "iot_bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Vectors are passed by value only between functions in this file, so
+// their calling convention differing by target ISA does not matter
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+typedef int64_t lane_wide_mask __attribute__((vector_size(PDP7_LANES * sizeof(int64_t))));
+
+// The interpreter's model check for a whole group
+#define REQUIRE_LANES_MODEL(name, kind) \
+    if (!MODEL_HAS(lanes->model, name)) { \
+        trap_group(lanes, group, kind, pc, instruction); \
+        return; \
+    }
+
+void extract_lane_registers(const cpu_lanes* lanes, uint32_t lane, PDP7_cpu* cpu);
+void insert_lane_registers(cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu);
+void copy_lane_pages(cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu);
+bool lanes_running_in(lane_word mask);
+void trap_group(cpu_lanes* lanes, lane_word group, cpu_trap_kind kind, uint32_t pc, uint32_t instruction);
+void execute_target(cpu_lanes* lanes, lane_word group, uint32_t pc, uint32_t instruction, uint32_t depth);
+void execute_xct(cpu_lanes* lanes, lane_word group, uint32_t pc, uint32_t instruction, lane_word targets, uint32_t depth);
+void step_scalar(cpu_lanes* lanes, lane_word group, uint32_t instruction);
+void load_scalar(cpu_lanes* lanes, uint32_t lane);
+void store_scalar(cpu_lanes* lanes, uint32_t lane);
+bool vector_iot(uint32_t instruction);
+
+static inline lane_word lane_broadcast(uint32_t word) {
+    return (lane_word){ 0 } + word;
+}
+
+// `yes` in the lanes whose mask is all ones, `no` elsewhere
+static inline lane_word lane_select(lane_word mask, lane_word yes, lane_word no) {
+    return (yes & mask) | (no & ~mask);
+}
+
+static inline lane_cycles widen_mask(lane_word mask) {
+    return (lane_cycles)__builtin_convertvector((lane_mask)mask, lane_wide_mask);
+}
+
+static inline void charge_group(cpu_lanes* lanes, lane_word group, uint64_t cycles) {
+    lanes->cycles += widen_mask(group) & cycles;
+}
+
+// Smallest word across the lanes: the vector against itself rotated by
+// half, then a quarter, ... each a single permute
+static inline uint32_t lane_lowest(lane_word words) {
+    lane_word index;
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        index[lane] = lane;
+    }
+    for (uint32_t width = PDP7_LANES / 2; width > 0; width /= 2) {
+        lane_word rotated = __builtin_shuffle(words, (index + width) & (PDP7_LANES - 1));
+        words = lane_select((lane_word)(rotated < words), rotated, words);
+    }
+    return words[0];
+}
+
+// Direct operands are at one address in every lane, a single vector.
+// Indirect ones are gathered lane by lane.
+static inline lane_word load_operand(const cpu_lanes* lanes, lane_word address, bool uniform) {
+    if (uniform) {
+        return lanes->memory[address[0]];
+    }
+    lane_word word;
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        word[lane] = lanes->memory[address[lane]][lane];
+    }
+    return word;
+}
+
+static inline void store_operand(cpu_lanes* lanes, lane_word address, bool uniform, lane_word word, lane_word group) {
+    if (uniform) {
+        lane_word* words = &lanes->memory[address[0]];
+        *words = lane_select(group, word, *words);
+        lanes->stale[address[0] / MEMORY_PAGE_WORDS] |= group;
+        return;
+    }
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        if (group[lane]) {
+            lanes->memory[address[lane]][lane] = word[lane];
+            lanes->stale[address[lane] / MEMORY_PAGE_WORDS][lane] = UINT32_MAX;
+        }
+    }
+}
+
+cpu_lanes* create_lanes(const PDP7_cpu* image, uint32_t count) {
+    if (count == 0 || count > PDP7_LANES) {
+        fprintf(stderr, "A lane group holds 1 to %d machines, not %u\n", PDP7_LANES, count);
+        exit(1);
+    }
+
+    // Vector registers need the vector's alignment, more than calloc's
+    cpu_lanes* lanes = aligned_alloc(_Alignof(cpu_lanes), sizeof(cpu_lanes));
+    lane_word* memory = aligned_alloc(sizeof(lane_word), MEMORY_SIZE * sizeof(lane_word));
+    if (!lanes || !memory) {
+        fprintf(stderr, "Failed to allocate %u lanes\n", count);
+        exit(1);
+    }
+
+    memset(lanes, 0, sizeof(cpu_lanes));
+    lanes->memory = memory;
+    lanes->lanes = count;
+    initialize_memory(&lanes->scalar);
+    lanes->scalar.bus = &standard_iot_bus;
+    reset_lanes(lanes, image);
+
+    return lanes;
+}
+
+void destroy_lanes(cpu_lanes* lanes) {
+    free_memory(&lanes->scalar);
+    free(lanes->memory);
+    free(lanes);
+}
+
+// Every lane becomes a copy of `image`, registers and memory
+void reset_lanes(cpu_lanes* lanes, const PDP7_cpu* image) {
+    for (uint32_t address = 0; address < MEMORY_SIZE; address++) {
+        lanes->memory[address] = lane_broadcast(read_memory(image, address));
+    }
+    // `scalar` catches up when a lane next needs it, only pages it does not
+    // share with the image can differ
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        lanes->stale[page] = lane_broadcast(image->pages[page] == lanes->scalar.pages[page] ? 0 : UINT32_MAX);
+    }
+
+    lanes->accumulator = lane_broadcast(image->accumulator);
+    lanes->link = lane_broadcast(image->link);
+    lanes->extend_mode = lane_broadcast(image->extend_mode);
+    lanes->pc = lane_broadcast(image->pc);
+    lanes->output = lane_broadcast(0);
+    lanes->cycles = (lane_cycles){ 0 } + image->cycles;
+    lanes->retired = (lane_cycles){ 0 };
+    lanes->program_start_address = image->program_start_address;
+    lanes->model = image->model;
+    lanes->scalar.model = image->model;
+
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        lanes->running[lane] = lane < lanes->lanes && image->running ? UINT32_MAX : 0;
+        lanes->trap[lane] = image->trap;
+        lanes->trap_pc[lane] = image->trap_pc;
+        lanes->trap_instruction[lane] = image->trap_instruction;
+    }
+}
+
+uint32_t lane_read(const cpu_lanes* lanes, uint32_t lane, uint32_t address) {
+    return lanes->memory[address & (MEMORY_SIZE - 1)][lane];
+}
+
+void lane_write(cpu_lanes* lanes, uint32_t lane, uint32_t address, uint32_t word) {
+    address &= MEMORY_SIZE - 1;
+    lanes->memory[address][lane] = word;
+    lanes->stale[address / MEMORY_PAGE_WORDS][lane] = UINT32_MAX;
+}
+
+// One lane as a machine: registers and memory, attachments are left as
+// they are. `cpu` must have initialized memory; untouched pages stay shared.
+void extract_lane(const cpu_lanes* lanes, uint32_t lane, PDP7_cpu* cpu) {
+    extract_lane_registers(lanes, lane, cpu);
+    for (uint32_t address = 0; address < MEMORY_SIZE; address++) {
+        uint32_t word = lanes->memory[address][lane];
+        if (word != 0 || read_memory(cpu, address) != 0) {
+            write_memory(cpu, address, word);
+        }
+    }
+    memset(cpu->dirty, 0, sizeof(cpu->dirty));
+}
+
+void extract_lane_registers(const cpu_lanes* lanes, uint32_t lane, PDP7_cpu* cpu) {
+    cpu->accumulator = lanes->accumulator[lane];
+    cpu->link = lanes->link[lane];
+    cpu->extend_mode = lanes->extend_mode[lane];
+    cpu->pc = lanes->pc[lane];
+    cpu->cycles = lanes->cycles[lane];
+    cpu->running = lanes->running[lane] != 0;
+    cpu->trap = lanes->trap[lane];
+    cpu->trap_pc = lanes->trap_pc[lane];
+    cpu->trap_instruction = lanes->trap_instruction[lane];
+    cpu->program_start_address = lanes->program_start_address;
+    cpu->model = lanes->model;
+    cpu->xct_depth = 0;
+}
+
+void insert_lane(cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu) {
+    insert_lane_registers(lanes, lane, cpu);
+    copy_lane_pages(lanes, lane, cpu);
+}
+
+void insert_lane_registers(cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu) {
+    lanes->accumulator[lane] = cpu->accumulator;
+    lanes->link[lane] = cpu->link;
+    lanes->extend_mode[lane] = cpu->extend_mode;
+    lanes->pc[lane] = cpu->pc;
+    lanes->cycles[lane] = cpu->cycles;
+    lanes->running[lane] = cpu->running && lane < lanes->lanes ? UINT32_MAX : 0;
+    lanes->trap[lane] = cpu->trap;
+    lanes->trap_pc[lane] = cpu->trap_pc;
+    lanes->trap_instruction[lane] = cpu->trap_instruction;
+}
+
+void copy_lane_pages(cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu) {
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        for (uint32_t word = 0; word < MEMORY_PAGE_WORDS; word++) {
+            lanes->memory[page * MEMORY_PAGE_WORDS + word][lane] = cpu->pages[page][word];
+        }
+        lanes->stale[page][lane] = UINT32_MAX;
+    }
+}
+
+bool lanes_running(const cpu_lanes* lanes) {
+    return lanes_running_in(lanes->running);
+}
+
+bool lanes_running_in(lane_word mask) {
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        if (mask[lane]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The IOTs a lane has without devices
+bool vector_iot(uint32_t instruction) {
+    return instruction == IOT_SEM || instruction == IOT_EEM || instruction == IOT_LEM || instruction == IOT_TLS;
+}
+
+// One word for every lane in `group`, whose PCs are already past `pc`.
+// Mirrors execute_model case by case, quirks included, so lanes end where
+// the interpreter would. XCT targets come back here with their XCT's `pc`.
+static inline __attribute__((always_inline)) void dispatch_group(cpu_lanes* lanes, lane_word group, uint32_t pc, uint32_t instruction, uint32_t depth) {
+    uint32_t opcode = (instruction >> 12) & 074;
+    if (opcode == OP_IOT && !vector_iot(instruction)) {
+        step_scalar(lanes, group, instruction);
+        return;
+    }
+
+    // Decode, once for the group
+    uint32_t next = wrap_pc(pc + 1);
+    uint32_t bank = next & BANK_MASK;
+    uint32_t direct = bank | (instruction & (BANK_SIZE - 1));
+    bool uniform = !(instruction & 020000);
+    lane_word address = lane_broadcast(direct);
+    if (!uniform) {
+        lane_word pointer = lanes->memory[direct];
+        lane_word extend = (lane_word)(lanes->extend_mode != 0);
+        address = lane_select(extend, pointer & (MEMORY_SIZE - 1), bank | (pointer & (BANK_SIZE - 1)));
+        charge_group(lanes, group, 1);
+    }
+    lane_word operand = load_operand(lanes, address, uniform);
+
+    lane_word accumulator = lanes->accumulator;
+    lane_word link = lanes->link;
+    lane_word counter = lanes->pc;
+    lane_word sum;
+
+    switch (opcode) {
+        case OP_CAL:
+            REQUIRE_LANES_MODEL(CAL, TRAP_OPCODE);
+            store_operand(lanes, address, uniform, counter, group);
+            accumulator = load_operand(lanes, address, uniform);
+            counter = address + 1;
+            charge_group(lanes, group, CYCLES_CAL);
+            break;
+        case OP_DAC:
+            REQUIRE_LANES_MODEL(DAC, TRAP_OPCODE);
+            store_operand(lanes, address, uniform, accumulator, group);
+            charge_group(lanes, group, CYCLES_DAC);
+            break;
+        case OP_JMS:
+            REQUIRE_LANES_MODEL(JMS, TRAP_OPCODE);
+            store_operand(lanes, address, uniform, counter + (link << 17) + (lanes->extend_mode << 16), group);
+            counter = address + 1 + lanes->program_start_address;
+            charge_group(lanes, group, CYCLES_JMS);
+            break;
+        case OP_DZM:
+            REQUIRE_LANES_MODEL(DZM, TRAP_OPCODE);
+            store_operand(lanes, address, uniform, lane_broadcast(0), group);
+            charge_group(lanes, group, CYCLES_DZM);
+            break;
+        case OP_LAC:
+            REQUIRE_LANES_MODEL(LAC, TRAP_OPCODE);
+            accumulator = operand;
+            charge_group(lanes, group, CYCLES_LAC);
+            break;
+        case OP_XOR:
+            REQUIRE_LANES_MODEL(XOR, TRAP_OPCODE);
+            accumulator ^= operand;
+            charge_group(lanes, group, CYCLES_XOR);
+            break;
+        case OP_ADD:
+            REQUIRE_LANES_MODEL(ADD, TRAP_OPCODE);
+            sum = accumulator + operand;
+            link = (lane_word)((sum >> 18) != 0) & 1;
+            accumulator = (sum + link) & 0777777;
+            accumulator &= ~(lane_word)(accumulator == 0777777);
+            charge_group(lanes, group, CYCLES_ADD);
+            break;
+        case OP_TAD:
+            REQUIRE_LANES_MODEL(TAD, TRAP_OPCODE);
+            sum = accumulator + operand;
+            link = (lane_word)((sum >> 18) != 0) & 1;
+            accumulator = sum & 0777777;
+            charge_group(lanes, group, CYCLES_TAD);
+            break;
+        case OP_XCT:
+            REQUIRE_LANES_MODEL(XCT, TRAP_OPCODE);
+            execute_xct(lanes, group, pc, instruction, operand, depth);
+            return;
+        case OP_ISZ:
+            REQUIRE_LANES_MODEL(ISZ, TRAP_OPCODE);
+            store_operand(lanes, address, uniform, operand + 1, group);
+            counter += (lane_word)(operand + 1 == 0) & 1;
+            charge_group(lanes, group, CYCLES_ISZ);
+            break;
+        case OP_AND:
+            REQUIRE_LANES_MODEL(AND, TRAP_OPCODE);
+            accumulator &= operand;
+            charge_group(lanes, group, CYCLES_AND);
+            break;
+        case OP_SAD:
+            REQUIRE_LANES_MODEL(SAD, TRAP_OPCODE);
+            counter += (lane_word)(accumulator != operand) & 1;
+            charge_group(lanes, group, CYCLES_SAD);
+            break;
+        case OP_JMP:
+            REQUIRE_LANES_MODEL(JMP, TRAP_OPCODE);
+            counter = address + lanes->program_start_address;
+            charge_group(lanes, group, CYCLES_JMP);
+            break;
+        case OP_IOT:
+            REQUIRE_LANES_MODEL(IOT, TRAP_OPCODE);
+            switch (instruction) {
+                case IOT_SEM:
+                    REQUIRE_LANES_MODEL(SEM, TRAP_IOT);
+                    counter += lanes->extend_mode;
+                    break;
+                case IOT_EEM:
+                    REQUIRE_LANES_MODEL(EEM, TRAP_IOT);
+                    lanes->extend_mode = lane_select(group, lane_broadcast(1), lanes->extend_mode);
+                    break;
+                case IOT_LEM:
+                    REQUIRE_LANES_MODEL(LEM, TRAP_IOT);
+                    lanes->extend_mode = lane_select(group, lane_broadcast(0), lanes->extend_mode);
+                    break;
+                default:
+                    // TLS with nothing attached: the word is dropped
+                    lanes->output = lane_select(group, accumulator, lanes->output);
+            }
+            break;
+        case OP_OPR:
+            REQUIRE_LANES_MODEL(OPR, TRAP_OPCODE);
+            switch (instruction) {
+                case OP_OPR:
+                    charge_group(lanes, group, CYCLES_OPR);
+                    break;
+                case OPR_CMA:
+                    REQUIRE_LANES_MODEL(CMA, TRAP_OPERATE);
+                    accumulator = ~accumulator & 0777777;
+                    charge_group(lanes, group, CYCLES_CMA);
+                    break;
+                case OPR_CML:
+                    REQUIRE_LANES_MODEL(CML, TRAP_OPERATE);
+                    link ^= 1;
+                    charge_group(lanes, group, CYCLES_CML);
+                    break;
+                case OPR_OAS:
+                    REQUIRE_LANES_MODEL(OAS, TRAP_OPERATE);
+                    accumulator |= operand;
+                    charge_group(lanes, group, CYCLES_OAS);
+                    break;
+                case OPR_LAS:
+                    REQUIRE_LANES_MODEL(LAS, TRAP_OPERATE);
+                    accumulator = operand;
+                    charge_group(lanes, group, CYCLES_LAS);
+                    break;
+                case OPR_RAL:
+                    REQUIRE_LANES_MODEL(RAL, TRAP_OPERATE);
+                    sum = (accumulator << 1) | link;
+                    link = (sum >> 18) & 1;
+                    accumulator = sum & 0x3FFFF;
+                    charge_group(lanes, group, CYCLES_RAL);
+                    break;
+                case OPR_RCL:
+                    REQUIRE_LANES_MODEL(RCL, TRAP_OPERATE);
+                    link = lane_broadcast(0);
+                    accumulator = (accumulator << 1) & 0x3FFFF;
+                    charge_group(lanes, group, CYCLES_RCL);
+                    break;
+                case OPR_RTL:
+                    REQUIRE_LANES_MODEL(RTL, TRAP_OPERATE);
+                    sum = (accumulator << 2) | (link << 1);
+                    link = (sum >> 18) & 1;
+                    accumulator = sum & 0x3FFFF;
+                    charge_group(lanes, group, CYCLES_RTL);
+                    break;
+                case OPR_RAR:
+                    REQUIRE_LANES_MODEL(RAR, TRAP_OPERATE);
+                    sum = (link << 18) | accumulator;
+                    link = sum & 1;
+                    accumulator = (sum >> 1) & 0x3FFFF;
+                    charge_group(lanes, group, CYCLES_RAR);
+                    break;
+                case OPR_RCR:
+                    REQUIRE_LANES_MODEL(RCR, TRAP_OPERATE);
+                    link = lane_broadcast(0);
+                    accumulator = (accumulator >> 1) & 0x3FFFF;
+                    charge_group(lanes, group, CYCLES_RCR);
+                    break;
+                case OPR_RTR:
+                    REQUIRE_LANES_MODEL(RTR, TRAP_OPERATE);
+                    sum = (link << 19) | (accumulator << 1);
+                    link = (sum >> 18) & 1;
+                    accumulator = (sum >> 2) & 0x3FFFF;
+                    charge_group(lanes, group, CYCLES_RTR);
+                    break;
+                case OPR_HLT:
+                    REQUIRE_LANES_MODEL(HLT, TRAP_OPERATE);
+                    lanes->running &= ~group;
+                    charge_group(lanes, group, CYCLES_HLT);
+                    break;
+                case OPR_SZA:
+                    REQUIRE_LANES_MODEL(SZA, TRAP_OPERATE);
+                    counter += (lane_word)(accumulator == 0) & 1;
+                    charge_group(lanes, group, CYCLES_SZA);
+                    break;
+                case OPR_SNA:
+                    REQUIRE_LANES_MODEL(SNA, TRAP_OPERATE);
+                    counter += (lane_word)(accumulator != 0) & 1;
+                    charge_group(lanes, group, CYCLES_SNA);
+                    break;
+                case OPR_SPA:
+                    REQUIRE_LANES_MODEL(SPA, TRAP_OPERATE);
+                    counter += (lane_word)((accumulator & 0x20000) == 0) & 1;
+                    charge_group(lanes, group, CYCLES_SPA);
+                    break;
+                case OPR_SMA:
+                    REQUIRE_LANES_MODEL(SMA, TRAP_OPERATE);
+                    counter += (lane_word)((accumulator & 0x20000) != 0) & 1;
+                    charge_group(lanes, group, CYCLES_SMA);
+                    break;
+                case OPR_SZL:
+                    REQUIRE_LANES_MODEL(SZL, TRAP_OPERATE);
+                    counter += link ^ 1;
+                    charge_group(lanes, group, CYCLES_SZL);
+                    break;
+                case OPR_SNL:
+                    REQUIRE_LANES_MODEL(SNL, TRAP_OPERATE);
+                    counter += link;
+                    charge_group(lanes, group, CYCLES_SNL);
+                    break;
+                case OPR_SKP:
+                    REQUIRE_LANES_MODEL(SKP, TRAP_OPERATE);
+                    counter += 1;
+                    charge_group(lanes, group, CYCLES_SKP);
+                    break;
+                case OPR_CLL:
+                    REQUIRE_LANES_MODEL(CLL, TRAP_OPERATE);
+                    link = lane_broadcast(0);
+                    charge_group(lanes, group, CYCLES_CLL);
+                    break;
+                case OPR_STL:
+                    REQUIRE_LANES_MODEL(STL, TRAP_OPERATE);
+                    link = lane_broadcast(1);
+                    charge_group(lanes, group, CYCLES_STL);
+                    break;
+                case OPR_CLA:
+                    REQUIRE_LANES_MODEL(CLA, TRAP_OPERATE);
+                    accumulator = lane_broadcast(0);
+                    charge_group(lanes, group, CYCLES_CLA);
+                    break;
+                case OPR_CLC:
+                    REQUIRE_LANES_MODEL(CLC, TRAP_OPERATE);
+                    accumulator = lane_broadcast(0x3FFFF);
+                    charge_group(lanes, group, CYCLES_CLC);
+                    break;
+                case OPR_GLK:
+                    REQUIRE_LANES_MODEL(GLK, TRAP_OPERATE);
+                    accumulator = (accumulator & 0x1FFFF) | (link << 17);
+                    charge_group(lanes, group, CYCLES_GLK);
+                    break;
+                default:
+                    trap_group(lanes, group, TRAP_OPERATE, pc, instruction);
+                    return;
+            }
+            break;
+        default:
+            trap_group(lanes, group, TRAP_OPCODE, pc, instruction);
+            return;
+    }
+
+    lanes->accumulator = lane_select(group, accumulator, lanes->accumulator);
+    lanes->link = lane_select(group, link, lanes->link);
+    lanes->pc = lane_select(group, counter & (MEMORY_SIZE - 1), lanes->pc);
+}
+
+// Fetch, once for the group, then the word
+static inline __attribute__((always_inline)) void execute_group(cpu_lanes* lanes, lane_word group, uint32_t pc, uint32_t instruction) {
+    lanes->groups++;
+    lanes->retired -= widen_mask(group);
+    lanes->pc = lane_select(group, lane_broadcast(wrap_pc(pc + 1)), lanes->pc);
+    dispatch_group(lanes, group, pc, instruction, 0);
+}
+
+// Runs every lane until it halts, traps or has used `budget` more cycles.
+// Returns the instructions executed, summed over the lanes.
+uint64_t run_lanes(cpu_lanes* lanes, uint64_t budget) {
+    lane_cycles end = lanes->cycles + budget;
+    lane_cycles retired = lanes->retired;
+
+    for (;;) {
+        lane_word active = lanes->running & (lane_word)__builtin_convertvector(lanes->cycles < end, lane_mask);
+
+        // The lane furthest back in the program goes first, which lets
+        // lanes that left a loop at different times meet again after it
+        uint32_t pc = lane_lowest(lane_select(active, lanes->pc, lane_broadcast(UINT32_MAX)));
+        lane_word group = active & (lane_word)(lanes->pc == pc);
+        if (pc == UINT32_MAX && !lanes_running_in(group)) {
+            break;
+        }
+
+        lane_word words = lanes->memory[pc & (MEMORY_SIZE - 1)];
+        uint32_t leader = 0;
+        while (!group[leader]) {
+            leader++;
+        }
+        uint32_t instruction = words[leader];
+        group &= (lane_word)(words == instruction);
+        execute_group(lanes, group, pc, instruction);
+    }
+
+    uint64_t instructions = 0;
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        instructions += lanes->retired[lane] - retired[lane];
+    }
+    return instructions;
+}
+
+void trap_group(cpu_lanes* lanes, lane_word group, cpu_trap_kind kind, uint32_t pc, uint32_t instruction) {
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        if (group[lane]) {
+            lanes->trap[lane] = kind;
+            lanes->trap_pc[lane] = pc;
+            lanes->trap_instruction[lane] = instruction;
+        }
+    }
+    lanes->running &= ~group;
+}
+
+// An out of line copy of the dispatch for XCT targets
+void execute_target(cpu_lanes* lanes, lane_word group, uint32_t pc, uint32_t instruction, uint32_t depth) {
+    dispatch_group(lanes, group, pc, instruction, depth);
+}
+
+// XCT with `targets` the words it executes: the lanes sharing a target run
+// it together, then every lane pays for the XCT. A chain deeper than
+// XCT_MAX_DEPTH traps like the interpreter's.
+void execute_xct(cpu_lanes* lanes, lane_word group, uint32_t pc, uint32_t instruction, lane_word targets, uint32_t depth) {
+    if (depth == XCT_MAX_DEPTH) {
+        trap_group(lanes, group, TRAP_XCT_LOOP, pc, instruction);
+        return;
+    }
+
+    lane_word remaining = group;
+    while (lanes_running_in(remaining)) {
+        uint32_t leader = 0;
+        while (!remaining[leader]) {
+            leader++;
+        }
+        uint32_t target = targets[leader];
+        lane_word same = remaining & (lane_word)(targets == target);
+        execute_target(lanes, same, pc, target, depth + 1);
+        remaining &= ~same;
+    }
+    charge_group(lanes, group, CYCLES_XCT);
+}
+
+// Device IOTs are rare in sweep programs, so they take the reference
+// interpreter one lane at a time. The PC is already past the word, which
+// may be an XCT target, so `scalar` decodes and executes it directly.
+void step_scalar(cpu_lanes* lanes, lane_word group, uint32_t instruction) {
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        if (group[lane]) {
+            load_scalar(lanes, lane);
+            decode_instruction(&lanes->scalar, instruction);
+            execute_instruction(&lanes->scalar, instruction);
+            store_scalar(lanes, lane);
+            lanes->scalar_instructions++;
+        }
+    }
+}
+
+// `scalar` becomes the lane: its registers, and the pages stale for it.
+// A page that changes no longer matches the lanes that matched the old one.
+void load_scalar(cpu_lanes* lanes, uint32_t lane) {
+    uint32_t words[MEMORY_PAGE_WORDS];
+
+    extract_lane_registers(lanes, lane, &lanes->scalar);
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (!lanes->stale[page][lane]) {
+            continue;
+        }
+        for (uint32_t word = 0; word < MEMORY_PAGE_WORDS; word++) {
+            words[word] = lanes->memory[page * MEMORY_PAGE_WORDS + word][lane];
+        }
+        if (memcmp(words, lanes->scalar.pages[page], sizeof(words)) != 0) {
+            write_memory_range(&lanes->scalar, page * MEMORY_PAGE_WORDS, words, MEMORY_PAGE_WORDS);
+            lanes->stale[page] = lane_broadcast(UINT32_MAX);
+        }
+        lanes->stale[page][lane] = 0;
+    }
+    memset(lanes->scalar.dirty, 0, sizeof(lanes->scalar.dirty));
+}
+
+// The lane takes back `scalar`'s registers and the pages the step wrote
+void store_scalar(cpu_lanes* lanes, uint32_t lane) {
+    insert_lane_registers(lanes, lane, &lanes->scalar);
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (!lanes->scalar.dirty[page]) {
+            continue;
+        }
+        for (uint32_t word = 0; word < MEMORY_PAGE_WORDS; word++) {
+            lanes->memory[page * MEMORY_PAGE_WORDS + word][lane] = lanes->scalar.pages[page][word];
+        }
+        lanes->stale[page] = lane_broadcast(UINT32_MAX);
+        lanes->stale[page][lane] = 0;
+    }
+    memset(lanes->scalar.dirty, 0, sizeof(lanes->scalar.dirty));
+}
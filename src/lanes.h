@@ -0,0 +1,62 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Machines per group: one AVX-512 vector of 32-bit words, two AVX2 ones.
+// The vector types below are GCC vector extensions, so the compiler picks
+// whatever the target has (make NATIVE=1), down to plain scalar code.
+#ifndef PDP7_LANES
+#define PDP7_LANES 16
+#endif
+
+typedef uint32_t lane_word __attribute__((vector_size(PDP7_LANES * sizeof(uint32_t))));
+typedef int32_t lane_mask __attribute__((vector_size(PDP7_LANES * sizeof(int32_t))));
+typedef uint64_t lane_cycles __attribute__((vector_size(PDP7_LANES * sizeof(uint64_t))));
+
+// Copies of one program run side by side, one per vector lane, for sweeps
+// over different data. Registers and memory are laid out per lane: word A
+// of every lane is the one vector memory[A]. Each step picks the lowest PC
+// among the running lanes and executes its word once for every lane at
+// that PC with the same word there, so fetch, decode and dispatch are paid
+// per group instead of per machine; lanes that went elsewhere are masked
+// off and rejoin when their PCs meet again.
+//
+// Lanes have no devices: TLS drops the word (keeping the last one in
+// `output`). XCT dispatches its target words again for the lanes sharing
+// each one. Device IOTs run on `scalar` through the reference interpreter
+// one lane at a time; `stale` marks the pages where a lane may differ from
+// `scalar`, so only those are copied over before the step and only the
+// pages it wrote come back.
+typedef struct {
+    lane_word accumulator;
+    lane_word link;                  // 0 or 1
+    lane_word extend_mode;           // 0 or 1
+    lane_word pc;
+    lane_word running;               // All ones while the lane runs
+    lane_word output;                // Last word each lane sent with TLS
+    lane_cycles cycles;
+    lane_cycles retired;             // Instructions each lane executed
+    lane_word* memory;               // MEMORY_SIZE vectors, memory[address][lane]
+    uint32_t lanes;                  // Lanes in use, the rest never run
+    uint32_t program_start_address;
+    uint8_t model;
+    cpu_trap_kind trap[PDP7_LANES];
+    uint32_t trap_pc[PDP7_LANES];
+    uint32_t trap_instruction[PDP7_LANES];
+    lane_word stale[MEMORY_PAGES];   // All ones where the lane's page may differ from `scalar`'s
+    PDP7_cpu scalar;                 // One lane at a time, for device IOTs
+    uint64_t groups;                 // Words dispatched, however many lanes shared each
+    uint64_t scalar_instructions;    // Instructions run on `scalar`, summed over the lanes
+} cpu_lanes;
+
+cpu_lanes* create_lanes(const PDP7_cpu* image, uint32_t count);
+void destroy_lanes(cpu_lanes* lanes);
+void reset_lanes(cpu_lanes* lanes, const PDP7_cpu* image);
+uint32_t lane_read(const cpu_lanes* lanes, uint32_t lane, uint32_t address);
+void lane_write(cpu_lanes* lanes, uint32_t lane, uint32_t address, uint32_t word);
+void extract_lane(const cpu_lanes* lanes, uint32_t lane, PDP7_cpu* cpu);
+void insert_lane(cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu);
+bool lanes_running(const cpu_lanes* lanes);
+uint64_t run_lanes(cpu_lanes* lanes, uint64_t budget);
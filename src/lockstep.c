@@ -0,0 +1,211 @@
+#include "lockstep.h"
+#include "disassembler.h"
+#include "iot_bus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define LOCKSTEP_HASH_PRIME 0x100000001b3ULL
+
+void detach_devices(PDP7_cpu* cpu);
+void save_checkpoint(lockstep_checker* checker, const PDP7_cpu* cpu);
+bool states_match(const PDP7_cpu* reference, const PDP7_cpu* shadow, int32_t* address);
+void replay_interval(lockstep_checker* checker, uint64_t count);
+
+lockstep_checker* create_lockstep(const cpu_engine* engine, uint64_t interval, const PDP7_cpu* cpu) {
+    lockstep_checker* checker = aligned_alloc(_Alignof(lockstep_checker), sizeof(lockstep_checker));
+    if (!checker) {
+        fprintf(stderr, "Failed to allocate the lockstep checker\n");
+        exit(1);
+    }
+    memset(checker, 0, sizeof(lockstep_checker));
+
+    checker->engine = engine;
+    checker->interval = interval ? interval : LOCKSTEP_DEFAULT_INTERVAL;
+    initialize_memory(&checker->shadow);
+    initialize_memory(&checker->checkpoint);
+    copy_cpu(&checker->shadow, cpu);
+    detach_devices(&checker->shadow);
+    copy_cpu(&checker->checkpoint, &checker->shadow);
+
+    return checker;
+}
+
+void destroy_lockstep(lockstep_checker* checker) {
+    free_memory(&checker->shadow);
+    free_memory(&checker->checkpoint);
+    free(checker);
+}
+
+// Copies never share the live machine's devices; their output is dropped
+// and they see no input.
+void detach_devices(PDP7_cpu* cpu) {
+    cpu->io_buffer = NULL;
+    cpu->storage = NULL;
+    cpu->keyboard = NULL;
+    cpu->profiler = NULL;
+    cpu->trace = NULL;
+    cpu->metrics = NULL;
+    cpu->lockstep = NULL;
+    cpu->heatmap = NULL;
+    cpu->line_in = NULL;
+    cpu->line_out = NULL;
+    cpu->attention = NULL;
+    cpu->bus = &standard_iot_bus;
+}
+
+// FNV-1a over the registers and every page written since the dirty flags
+// were cleared, chained onto the previous interval's hash
+uint64_t lockstep_hash(uint64_t hash, const PDP7_cpu* cpu) {
+    uint64_t registers[] = { cpu->accumulator, cpu->link, cpu->extend_mode, cpu->pc, cpu->cycles, cpu->running, cpu->trap };
+
+    for (size_t i = 0; i < sizeof(registers) / sizeof(registers[0]); i++) {
+        hash = (hash ^ registers[i]) * LOCKSTEP_HASH_PRIME;
+    }
+
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (!cpu->dirty[page]) {
+            continue;
+        }
+        hash = (hash ^ page) * LOCKSTEP_HASH_PRIME;
+        const uint32_t* words = cpu->pages[page];
+        for (uint32_t i = 0; i < MEMORY_PAGE_WORDS; i++) {
+            hash = (hash ^ words[i]) * LOCKSTEP_HASH_PRIME;
+        }
+    }
+    return hash;
+}
+
+// Runs one interval on both machines and compares. Returns false, with the
+// live machine stopped, once they disagree.
+bool lockstep_run(lockstep_checker* checker, PDP7_cpu* cpu) {
+    PDP7_cpu* shadow = &checker->shadow;
+
+    memset(cpu->dirty, 0, sizeof(cpu->dirty));
+    memset(shadow->dirty, 0, sizeof(shadow->dirty));
+
+    uint64_t executed = run_instructions(cpu, checker->interval);
+    checker->engine->run(shadow, executed);
+
+    checker->reference_hash = lockstep_hash(checker->reference_hash, cpu);
+    checker->engine_hash = lockstep_hash(checker->engine_hash, shadow);
+
+    if (checker->reference_hash == checker->engine_hash) {
+        save_checkpoint(checker, cpu);
+        checker->instructions += executed;
+        checker->checkpoints++;
+        return true;
+    }
+
+    checker->diverged = true;
+    replay_interval(checker, executed);
+    cpu->running = false;
+    return false;
+}
+
+// Brings the checkpoint up to the live machine, registers plus the pages
+// written this interval
+void save_checkpoint(lockstep_checker* checker, const PDP7_cpu* cpu) {
+    PDP7_cpu* checkpoint = &checker->checkpoint;
+
+    checkpoint->accumulator = cpu->accumulator;
+    checkpoint->memory_address = cpu->memory_address;
+    checkpoint->memory_buffer = cpu->memory_buffer;
+    checkpoint->pc = cpu->pc;
+    checkpoint->ir = cpu->ir;
+    checkpoint->link = cpu->link;
+    checkpoint->extend_mode = cpu->extend_mode;
+    checkpoint->cycles = cpu->cycles;
+    checkpoint->running = cpu->running;
+    checkpoint->trap = cpu->trap;
+
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (cpu->dirty[page]) {
+            copy_page(checkpoint, cpu, page);
+        }
+    }
+}
+
+// Compares registers and the pages either side wrote. `address` gets the
+// first differing word, or -1 when only registers differ.
+bool states_match(const PDP7_cpu* reference, const PDP7_cpu* shadow, int32_t* address) {
+    *address = -1;
+
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (!reference->dirty[page] && !shadow->dirty[page]) {
+            continue;
+        }
+        for (uint32_t word = page * MEMORY_PAGE_WORDS; word < (page + 1) * MEMORY_PAGE_WORDS; word++) {
+            if (read_memory(reference, word) != read_memory(shadow, word)) {
+                *address = (int32_t)word;
+                return false;
+            }
+        }
+    }
+
+    return reference->accumulator == shadow->accumulator && reference->link == shadow->link &&
+           reference->extend_mode == shadow->extend_mode &&
+           reference->pc == shadow->pc && reference->cycles == shadow->cycles &&
+           reference->running == shadow->running && reference->trap == shadow->trap;
+}
+
+// Reruns the failed interval from the checkpoint on two device-less copies,
+// comparing after every instruction. Uses up the checkpoint.
+void replay_interval(lockstep_checker* checker, uint64_t count) {
+    PDP7_cpu* reference = &checker->checkpoint;
+    PDP7_cpu* shadow = &checker->shadow;
+    int32_t address;
+
+    copy_cpu(shadow, reference);
+    for (uint64_t i = 0; i < count && reference->running; i++) {
+        memset(reference->dirty, 0, sizeof(reference->dirty));
+        memset(shadow->dirty, 0, sizeof(shadow->dirty));
+
+        uint32_t pc = reference->pc;
+        uint32_t instruction = read_memory(reference, pc);
+        perform_cycle(reference);
+        checker->engine->step(shadow);
+
+        if (!states_match(reference, shadow, &address)) {
+            checker->reproduced = true;
+            checker->divergence_index = checker->instructions + i;
+            checker->divergence_pc = pc;
+            checker->divergence_instruction = instruction;
+            return;
+        }
+    }
+}
+
+void lockstep_report(const lockstep_checker* checker) {
+    const PDP7_cpu* reference = &checker->checkpoint;
+    const PDP7_cpu* shadow = &checker->shadow;
+
+    if (!checker->diverged) {
+        printf("Lockstep: engine %s matched over %" PRIu64 " instructions (%" PRIu64 " checkpoints)\n",
+               checker->engine->name, checker->instructions, checker->checkpoints);
+        return;
+    }
+
+    if (!checker->reproduced) {
+        printf("Lockstep: engine %s diverged after instruction %" PRIu64 " but not on replay without devices\n",
+               checker->engine->name, checker->instructions);
+        return;
+    }
+
+    char text[32];
+    int32_t address;
+    disassemble_instruction(checker->divergence_instruction, text, sizeof(text));
+    printf("Lockstep: engine %s diverged at instruction %" PRIu64 ", PC %05" PRIo32 ": %06" PRIo32 " %s\n",
+           checker->engine->name, checker->divergence_index, checker->divergence_pc,
+           checker->divergence_instruction, text);
+    printf("  reference AC %06" PRIo32 " L %d PC %05" PRIo32 " cycles %" PRIu64 "\n",
+           reference->accumulator, reference->link, reference->pc, reference->cycles);
+    printf("  %-9s AC %06" PRIo32 " L %d PC %05" PRIo32 " cycles %" PRIu64 "\n", checker->engine->name,
+           shadow->accumulator, shadow->link, shadow->pc, shadow->cycles);
+
+    if (!states_match(reference, shadow, &address) && address >= 0) {
+        printf("  memory %05" PRIo32 ": reference %06" PRIo32 ", %s %06" PRIo32 "\n", (uint32_t)address,
+               read_memory(reference, address), checker->engine->name, read_memory(shadow, address));
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "engine.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LOCKSTEP_DEFAULT_INTERVAL 4096 // Instructions between state hashes
+
+// Runs an alternative engine on a shadow copy of the machine next to the
+// live (reference) one. Every interval both fold their registers and the
+// pages they wrote into a rolling hash; on a mismatch the interval is
+// replayed from the last agreed checkpoint one instruction at a time.
+typedef struct lockstep_checker {
+    const cpu_engine* engine;
+    uint64_t interval;
+    PDP7_cpu shadow;             // Machine run by the engine, no devices attached
+    PDP7_cpu checkpoint;         // Last state both agreed on
+    uint64_t reference_hash;
+    uint64_t engine_hash;
+    uint64_t instructions;       // Instructions checked so far
+    uint64_t checkpoints;        // Intervals that matched
+    bool diverged;
+    bool reproduced;             // Replay found the differing instruction
+    uint64_t divergence_index;   // Instruction number of the first difference
+    uint32_t divergence_pc;
+    uint32_t divergence_instruction;
+} lockstep_checker;
+
+lockstep_checker* create_lockstep(const cpu_engine* engine, uint64_t interval, const PDP7_cpu* cpu);
+void destroy_lockstep(lockstep_checker* checker);
+bool lockstep_run(lockstep_checker* checker, PDP7_cpu* cpu);
+uint64_t lockstep_hash(uint64_t hash, const PDP7_cpu* cpu);
+void lockstep_report(const lockstep_checker* checker);
@@ -1,40 +1,132 @@
 #include "pdp7.h"
+#include "network.h"
+#include "engine.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 
 int main(int argc, char *argv[]) {
-    bool headless = false;
-    bool debug = false;
-    bool use_display = false;
-    uint32_t start_address = INSTRUCTION_START;
-
-    char *program_file = NULL;
-    char *memory_file = NULL;
+    const char* network_file = NULL;
+    PDP7_options options = {
+        .program_file = NULL,
+        .memory_file = NULL,
+        .storage_file = NULL,
+        .profile_file = NULL,
+        .trace_file = NULL,
+        .metrics_name = NULL,
+        .lockstep_engine = NULL,
+        .record_file = NULL,
+        .replay_file = NULL,
+        .gdb_address = NULL,
+        .host_output_file = NULL,
+        .host_input_file = NULL,
+        .lockstep_interval = LOCKSTEP_DEFAULT_INTERVAL,
+        .start_address = INSTRUCTION_START,
+        .model = MODEL_PDP7,
+        .use_display = false,
+        .terminal_display = false,
+        .debug = false,
+        .headless = false,
+        .trace_stream = false,
+        .heatmap = false,
+        .deterministic = false,
+    };
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-d") == 0) {
-            debug = true;
+            options.debug = true;
         } else if (strcmp(argv[i], "-h") == 0) {
-            headless = true;
+            options.headless = true;
         } else if (strcmp(argv[i], "-t") == 0) {
-            use_display = true;
+            options.use_display = true;
+        } else if (strcmp(argv[i], "-A") == 0) {
+            options.use_display = true;
+            options.terminal_display = true;
         } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
-            program_file = argv[++i];
+            options.program_file = argv[++i];
         } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
-            memory_file = argv[++i];
+            options.memory_file = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            options.storage_file = argv[++i];
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            options.profile_file = argv[++i];
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            options.trace_file = argv[++i];
+        } else if (strcmp(argv[i], "-F") == 0) {
+            options.trace_stream = true;
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            options.metrics_name = argv[++i];
+        } else if (strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+            // -L <engine>[:<interval>]
+            char* interval = strchr(argv[++i], ':');
+            if (interval) {
+                *interval++ = '\0';
+                options.lockstep_interval = strtoull(interval, NULL, 10);
+            }
+            options.lockstep_engine = argv[i];
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            options.record_file = argv[++i];
+        } else if (strcmp(argv[i], "-Y") == 0 && i + 1 < argc) {
+            options.replay_file = argv[++i];
+        } else if (strcmp(argv[i], "-G") == 0 && i + 1 < argc) {
+            options.gdb_address = argv[++i];
+        } else if (strcmp(argv[i], "-O") == 0 && i + 1 < argc) {
+            options.host_output_file = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc) {
+            options.host_input_file = argv[++i];
+        } else if (strcmp(argv[i], "-D") == 0) {
+            options.deterministic = true;
+        } else if (strcmp(argv[i], "-H") == 0) {
+            options.heatmap = true;
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc) {
+            options.model = find_model(argv[++i]);
+            if (!options.model) {
+                fprintf(stderr, "Unknown model %s, available: %s\n", argv[i], model_names());
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc) {
+            network_file = argv[++i];
         } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
-            start_address = strtol(argv[++i], NULL, 8);
+            options.start_address = strtol(argv[++i], NULL, 8);
         } else {
-            fprintf(stderr, "Usage: %s [-d] [-t] [-h] [-p <program file>] [-m <memory file>] [-a <start address>]\n", argv[0]);
+            fprintf(stderr, "Usage: %s [-d] [-t] [-A] [-h] [-D] [-p <program file>] [-m <memory file>] [-b <storage file>] [-P <profile report>] [-T <trace file> [-F]] [-S <metrics name>] [-H] [-L <engine>[:<interval>]] [-R <journal to record>] [-Y <journal to replay>] [-G <socket path or port>] [-O <host output>] [-I <host input>] [-M <model>] [-N <topology file>] [-a <start address>]\n", argv[0]);
             return EXIT_FAILURE;
         }
     }
 
+    if (options.lockstep_engine && !options.headless) {
+        fprintf(stderr, "Lockstep runs (-L) are headless only, add -h\n");
+        return EXIT_FAILURE;
+    }
+
+    if (options.deterministic && (!options.headless || options.lockstep_engine)) {
+        fprintf(stderr, "Deterministic runs (-D) are headless only (-h) and cannot be combined with -L\n");
+        return EXIT_FAILURE;
+    }
+
+    if (options.gdb_address && (!options.headless || options.deterministic || options.lockstep_engine)) {
+        fprintf(stderr, "The GDB stub (-G) serves headless runs (-h) and cannot be combined with -D or -L\n");
+        return EXIT_FAILURE;
+    }
+
+    if (options.heatmap && (!options.use_display || options.terminal_display)) {
+        fprintf(stderr, "The memory heatmap (-H) is a display window, add -t\n");
+        return EXIT_FAILURE;
+    }
+
+    // Several machines wired by serial lines, always headless
+    if (network_file) {
+        pdp7_network* network = load_network(network_file);
+        run_network(network);
+        bool trapped = network_report(network);
+        destroy_network(network);
+        return trapped ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
     PDP7 pdp7_minicomputer;
 
-    run_pdp7(&pdp7_minicomputer, program_file, memory_file, start_address, use_display, debug, headless);
+    run_pdp7(&pdp7_minicomputer, &options);
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "pdp7_cpu.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define MEMORY_ARENA_BYTES (MEMORY_SIZE * sizeof(uint32_t))
+#define MEMORY_PAGE_BYTES (MEMORY_PAGE_WORDS * sizeof(uint32_t))
+
+// Every unallocated page points here, so reading untouched memory costs no
+// storage and no branch. It is never written: write_memory allocates first.
+uint32_t memory_zero_page[MEMORY_PAGE_WORDS];
+
+// Points the whole page table at the zero page. Whatever the table held
+// before is not freed, use free_memory for that.
+void initialize_memory(PDP7_cpu* cpu) {
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        cpu->pages[page] = memory_zero_page;
+    }
+    memset(cpu->dirty, 0, sizeof(cpu->dirty));
+    cpu->memory = NULL;
+}
+
+void free_memory(PDP7_cpu* cpu) {
+    if (cpu->memory) {
+        munmap(cpu->memory, MEMORY_ARENA_BYTES);
+    }
+    initialize_memory(cpu);
+}
+
+// Gives a page storage of its own, holding the words it showed before
+// (zeros, or a shared image's). Every page has its slot in one page-aligned
+// arena per machine; the host only commits the slots that get written, so
+// the arena costs about as much as the pages in use.
+uint32_t* allocate_page(PDP7_cpu* cpu, uint32_t page) {
+    if (!cpu->memory) {
+        void* arena = mmap(NULL, MEMORY_ARENA_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (arena == MAP_FAILED) {
+            fprintf(stderr, "Failed to allocate memory page %o\n", page);
+            exit(1);
+        }
+        cpu->memory = arena;
+    }
+
+    uint32_t* words = cpu->memory + page * MEMORY_PAGE_WORDS;
+    if (cpu->pages[page] != words) {
+        memcpy(words, cpu->pages[page], MEMORY_PAGE_BYTES);
+        cpu->pages[page] = words;
+    }
+    return words;
+}
+
+// Makes one page of `destination` hold the same words as `source`, sharing
+// nothing. Pages still untouched in the source go back to the zero page.
+void copy_page(PDP7_cpu* destination, const PDP7_cpu* source, uint32_t page) {
+    if (source->pages[page] == memory_zero_page) {
+        destination->pages[page] = memory_zero_page;
+        return;
+    }
+
+    uint32_t* words = page_is_private(destination, page) ? destination->pages[page] : allocate_page(destination, page);
+    memcpy(words, source->pages[page], MEMORY_PAGE_BYTES);
+}
+
+// Points every page of `cpu` at `image`'s words instead of copying them, so
+// machines started from one loaded program keep a single copy of it. A
+// store copies the page into cpu's own arena first. `image` must not be
+// written or freed while anything shares it.
+void share_memory(PDP7_cpu* cpu, const PDP7_cpu* image) {
+    memcpy(cpu->pages, image->pages, sizeof(cpu->pages));
+    memset(cpu->dirty, 0, sizeof(cpu->dirty));
+}
+
+void copy_memory(PDP7_cpu* destination, const PDP7_cpu* source) {
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        copy_page(destination, source, page);
+    }
+    memcpy(destination->dirty, source->dirty, sizeof(destination->dirty));
+}
+
+// Struct assignment for machines: registers and attachments are copied,
+// memory goes into the destination's own (already initialized) pages.
+void copy_cpu(PDP7_cpu* destination, const PDP7_cpu* source) {
+    uint32_t* pages[MEMORY_PAGES];
+    uint32_t* memory = destination->memory;
+
+    memcpy(pages, destination->pages, sizeof(pages));
+    *destination = *source;
+    memcpy(destination->pages, pages, sizeof(pages));
+    destination->memory = memory;
+    copy_memory(destination, source);
+}
+
+// Puts a machine sharing `base`'s memory back to base's state: registers
+// and attachments wholesale, and the pages dirtied since shared again.
+void restore_cpu(PDP7_cpu* cpu, const PDP7_cpu* base) {
+    uint32_t* pages[MEMORY_PAGES];
+    uint8_t dirty[MEMORY_PAGES];
+    uint32_t* memory = cpu->memory;
+
+    memcpy(pages, cpu->pages, sizeof(pages));
+    memcpy(dirty, cpu->dirty, sizeof(dirty));
+    *cpu = *base;
+    memcpy(cpu->pages, pages, sizeof(pages));
+    cpu->memory = memory;
+
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (dirty[page]) {
+            cpu->pages[page] = base->pages[page];
+        }
+    }
+    memset(cpu->dirty, 0, sizeof(cpu->dirty));
+}
+
+uint32_t allocated_pages(const PDP7_cpu* cpu) {
+    uint32_t count = 0;
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        count += page_is_private(cpu, page);
+    }
+    return count;
+}
+
+// Copies `count` words out of memory a page at a time, wrapping around the
+// top of memory
+void read_memory_range(const PDP7_cpu* cpu, uint32_t address, uint32_t* words, uint32_t count) {
+    address &= MEMORY_SIZE - 1;
+    while (count > 0) {
+        uint32_t offset = address % MEMORY_PAGE_WORDS;
+        uint32_t chunk = MEMORY_PAGE_WORDS - offset < count ? MEMORY_PAGE_WORDS - offset : count;
+        memcpy(words, cpu->pages[address / MEMORY_PAGE_WORDS] + offset, chunk * sizeof(uint32_t));
+        words += chunk;
+        count -= chunk;
+        address = (address + chunk) & (MEMORY_SIZE - 1);
+    }
+}
+
+// The store side: each page is made private and marked dirty once
+void write_memory_range(PDP7_cpu* cpu, uint32_t address, const uint32_t* words, uint32_t count) {
+    address &= MEMORY_SIZE - 1;
+    while (count > 0) {
+        uint32_t page = address / MEMORY_PAGE_WORDS;
+        uint32_t offset = address % MEMORY_PAGE_WORDS;
+        uint32_t chunk = MEMORY_PAGE_WORDS - offset < count ? MEMORY_PAGE_WORDS - offset : count;
+        uint32_t* page_words = page_is_private(cpu, page) ? cpu->pages[page] : allocate_page(cpu, page);
+        memcpy(page_words + offset, words, chunk * sizeof(uint32_t));
+        cpu->dirty[page] = 1;
+        words += chunk;
+        count -= chunk;
+        address = (address + chunk) & (MEMORY_SIZE - 1);
+    }
+}
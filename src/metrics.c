@@ -0,0 +1,112 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+live_metrics* create_metrics(const char* name) {
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, sizeof(metrics_page)) < 0) {
+        printf("Failed to create metrics segment %s\n", name);
+        exit(1);
+    }
+
+    void* page = mmap(NULL, sizeof(metrics_page), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    live_metrics* metrics = calloc(1, sizeof(live_metrics));
+    if (page == MAP_FAILED || !metrics) {
+        printf("Failed to map metrics segment %s\n", name);
+        exit(1);
+    }
+
+    metrics->page = (metrics_page*)page;
+    snprintf(metrics->name, sizeof(metrics->name), "%s", name);
+    metrics->next_publish = METRICS_PUBLISH_INTERVAL;
+    metrics->last_time_ns = monotonic_ns();
+
+    metrics->page->version = METRICS_VERSION;
+    metrics->page->pid = getpid();
+    metrics->page->running = 1;
+    metrics->page->timestamp_ns = metrics->last_time_ns;
+
+    return metrics;
+}
+
+void destroy_metrics(live_metrics* metrics) {
+    munmap(metrics->page, sizeof(metrics_page));
+    shm_unlink(metrics->name);
+    free(metrics);
+}
+
+// Seqlock writer side, only ever called from the CPU thread
+void metrics_publish(live_metrics* metrics, const PDP7_cpu* cpu) {
+    metrics_page* page = metrics->page;
+    uint64_t now = monotonic_ns();
+    uint64_t elapsed = now - metrics->last_time_ns;
+    uint32_t sequence = atomic_load_explicit(&page->sequence, memory_order_relaxed);
+
+    atomic_store_explicit(&page->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    page->running = cpu->running;
+    page->timestamp_ns = now;
+    page->instructions = metrics->instructions;
+    page->cycles = cpu->cycles;
+    if (elapsed > 0) {
+        page->instructions_per_second = (metrics->instructions - metrics->last_instructions) * 1e9 / elapsed;
+    }
+    memcpy(page->opcode_count, metrics->opcode_count, sizeof(page->opcode_count));
+    page->io_words = metrics->io_words;
+    page->output_wait_ns = metrics->output_wait_ns;
+
+    atomic_store_explicit(&page->sequence, sequence + 2, memory_order_release);
+
+    metrics->last_instructions = metrics->instructions;
+    metrics->last_time_ns = now;
+    metrics->next_publish = metrics->instructions + METRICS_PUBLISH_INTERVAL;
+}
+
+// Time the CPU spends blocked in TLS. Updates during a long wait also
+// publish, so readers can see the machine is waiting on the display.
+void metrics_wait_begin(live_metrics* metrics) {
+    metrics->wait_mark_ns = monotonic_ns();
+}
+
+void metrics_wait_update(live_metrics* metrics, const PDP7_cpu* cpu) {
+    uint64_t now = monotonic_ns();
+    metrics->output_wait_ns += now - metrics->wait_mark_ns;
+    metrics->wait_mark_ns = now;
+    metrics_publish(metrics, cpu);
+}
+
+void metrics_wait_end(live_metrics* metrics) {
+    metrics->output_wait_ns += monotonic_ns() - metrics->wait_mark_ns;
+}
+
+// Seqlock reader side, returns false if the writer kept the page busy
+bool metrics_read(const metrics_page* page, metrics_page* snapshot) {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        uint32_t before = atomic_load_explicit(&page->sequence, memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        memcpy(snapshot, page, sizeof(metrics_page));
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&page->sequence, memory_order_relaxed) == before) {
+            snapshot->display_frames = atomic_load_explicit(&page->display_frames, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
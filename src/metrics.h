@@ -0,0 +1,55 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define METRICS_VERSION 1
+#define METRICS_OPCODES 16
+#define METRICS_PUBLISH_INTERVAL 65536 // Instructions between publications
+
+// Layout of the shared memory segment. Everything but the atomics is
+// guarded by `sequence` (odd while the CPU thread is writing).
+typedef struct {
+    _Atomic uint32_t sequence;
+    uint32_t version;
+    int32_t pid;
+    uint32_t running;
+    uint64_t timestamp_ns;           // CLOCK_MONOTONIC of the last publication
+    uint64_t instructions;
+    uint64_t cycles;
+    double instructions_per_second;  // Over the last publication interval
+    uint64_t opcode_count[METRICS_OPCODES];
+    uint64_t io_words;               // Words moved by TLS, KRB and the data channel
+    uint64_t output_wait_ns;         // Time spent spinning in TLS for the display
+    _Atomic uint64_t display_frames; // Written by the display thread
+} metrics_page;
+
+typedef struct live_metrics {
+    metrics_page* page;
+    char name[64];
+    uint64_t instructions;
+    uint64_t opcode_count[METRICS_OPCODES];
+    uint64_t io_words;
+    uint64_t output_wait_ns;
+    uint64_t next_publish;
+    uint64_t last_instructions;
+    uint64_t last_time_ns;
+    uint64_t wait_mark_ns;
+} live_metrics;
+
+live_metrics* create_metrics(const char* name);
+void destroy_metrics(live_metrics* metrics);
+void metrics_publish(live_metrics* metrics, const PDP7_cpu* cpu);
+void metrics_wait_begin(live_metrics* metrics);
+void metrics_wait_update(live_metrics* metrics, const PDP7_cpu* cpu);
+void metrics_wait_end(live_metrics* metrics);
+bool metrics_read(const metrics_page* page, metrics_page* snapshot);
+
+static inline void metrics_instruction(live_metrics* metrics, uint32_t instruction, const PDP7_cpu* cpu) {
+    metrics->opcode_count[(instruction >> 14) & 017]++;
+    if (++metrics->instructions == metrics->next_publish) {
+        metrics_publish(metrics, cpu);
+    }
+}
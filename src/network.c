@@ -0,0 +1,332 @@
+#define _GNU_SOURCE
+#include "network.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sched.h>
+#include <unistd.h>
+
+#define NETWORK_LINE_SIZE 512
+
+static const char* OUTCOME_NAMES[] = { "halted", "trapped", "drained", "cycle limit" };
+
+void parse_machine(pdp7_network* network, const char* filename, int line_number);
+void parse_line(pdp7_network* network, const char* filename, int line_number);
+const PDP7_cpu* load_image(pdp7_network* network, const char* program_file, const char* memory_file,
+                           uint32_t start_address, const char* filename, int line_number);
+void* run_machine(void* arg);
+void pin_to_core(int core);
+
+// Topology file, one statement per line, `//` starts a comment:
+//   machine <name> <program> [<memory>] [start=<octal>] [cycles=<n>] [storage=<file>]
+//   line <from> <to> [baud=<n>]
+// A line carries the words <from> sends with TLS to <to>'s KSF/KRB. Each
+// machine has at most one line in and one line out.
+pdp7_network* load_network(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        fprintf(stderr, "Failed to open topology %s\n", filename);
+        exit(1);
+    }
+
+    pdp7_network* network = aligned_alloc(_Alignof(pdp7_network), sizeof(pdp7_network));
+    if (!network) {
+        fprintf(stderr, "Failed to allocate the network\n");
+        exit(1);
+    }
+    memset(network, 0, sizeof(pdp7_network));
+
+    char text[NETWORK_LINE_SIZE];
+    int line_number = 0;
+    while (fgets(text, sizeof(text), file)) {
+        line_number++;
+        char* comment = strstr(text, "//");
+        if (comment) {
+            *comment = '\0';
+        }
+
+        char* keyword = strtok(text, " \t\r\n");
+        if (!keyword) {
+            continue;
+        }
+        if (strcmp(keyword, "machine") == 0) {
+            parse_machine(network, filename, line_number);
+        } else if (strcmp(keyword, "line") == 0) {
+            parse_line(network, filename, line_number);
+        } else {
+            fprintf(stderr, "%s:%d: unknown statement %s\n", filename, line_number, keyword);
+            exit(1);
+        }
+    }
+    fclose(file);
+
+    if (network->machine_count == 0) {
+        fprintf(stderr, "%s: no machines\n", filename);
+        exit(1);
+    }
+
+    // Lines are wired once all of them are parsed, the array no longer moves
+    for (uint32_t i = 0; i < network->line_count; i++) {
+        network_line* line = &network->lines[i];
+        network->machines[line->from].pdp7.cpu.line_out = &line->line;
+        network->machines[line->to].pdp7.cpu.line_in = &line->line;
+    }
+
+    return network;
+}
+
+// Continues the strtok of a `machine` statement, loading the machine
+void parse_machine(pdp7_network* network, const char* filename, int line_number) {
+    const char* name = strtok(NULL, " \t\r\n");
+    const char* program_file = strtok(NULL, " \t\r\n");
+    const char* memory_file = NULL;
+    const char* storage_file = NULL;
+    uint32_t start_address = INSTRUCTION_START;
+    uint64_t cycle_limit = 0;
+
+    if (!name || !program_file) {
+        fprintf(stderr, "%s:%d: expected machine <name> <program> [<memory>] [options]\n", filename, line_number);
+        exit(1);
+    }
+    if (network->machine_count == NETWORK_MAX_MACHINES) {
+        fprintf(stderr, "%s:%d: more than %d machines\n", filename, line_number, NETWORK_MAX_MACHINES);
+        exit(1);
+    }
+    if (strlen(name) >= NETWORK_NAME_SIZE || find_machine(network, name)) {
+        fprintf(stderr, "%s:%d: bad or duplicate machine name %s\n", filename, line_number, name);
+        exit(1);
+    }
+
+    const char* token;
+    while ((token = strtok(NULL, " \t\r\n"))) {
+        if (strncmp(token, "start=", 6) == 0) {
+            start_address = strtol(token + 6, NULL, 8);
+        } else if (strncmp(token, "cycles=", 7) == 0) {
+            cycle_limit = strtoull(token + 7, NULL, 10);
+        } else if (strncmp(token, "storage=", 8) == 0) {
+            storage_file = token + 8;
+        } else if (!memory_file && !strchr(token, '=')) {
+            memory_file = token;
+        } else {
+            fprintf(stderr, "%s:%d: unknown machine option %s\n", filename, line_number, token);
+            exit(1);
+        }
+    }
+
+    network_machine* machine = &network->machines[network->machine_count++];
+    strcpy(machine->name, name);
+    machine->cycle_limit = cycle_limit;
+    machine->core = -1;
+
+    // No display or keyboard: TLS goes to the line out, or nowhere
+    PDP7* pdp7 = &machine->pdp7;
+    initialize_cpu(&pdp7->cpu, NULL, NULL, NULL, start_address);
+    share_memory(&pdp7->cpu, load_image(network, program_file, memory_file, start_address, filename, line_number));
+    if (storage_file) {
+        initialize_storage(&pdp7->storage, storage_file);
+        pdp7->cpu.storage = &pdp7->storage;
+        machine->has_storage = true;
+    }
+}
+
+void parse_line(pdp7_network* network, const char* filename, int line_number) {
+    const char* from_name = strtok(NULL, " \t\r\n");
+    const char* to_name = strtok(NULL, " \t\r\n");
+    uint32_t baud = 0;
+
+    if (!from_name || !to_name) {
+        fprintf(stderr, "%s:%d: expected line <from> <to> [baud=<n>]\n", filename, line_number);
+        exit(1);
+    }
+    if (network->line_count == NETWORK_MAX_LINES) {
+        fprintf(stderr, "%s:%d: more than %d lines\n", filename, line_number, NETWORK_MAX_LINES);
+        exit(1);
+    }
+
+    const char* token;
+    while ((token = strtok(NULL, " \t\r\n"))) {
+        if (strncmp(token, "baud=", 5) == 0) {
+            baud = strtoul(token + 5, NULL, 10);
+        } else {
+            fprintf(stderr, "%s:%d: unknown line option %s\n", filename, line_number, token);
+            exit(1);
+        }
+    }
+
+    network_machine* from = find_machine(network, from_name);
+    network_machine* to = find_machine(network, to_name);
+    if (!from || !to) {
+        fprintf(stderr, "%s:%d: unknown machine %s\n", filename, line_number, from ? to_name : from_name);
+        exit(1);
+    }
+
+    for (uint32_t i = 0; i < network->line_count; i++) {
+        network_line* other = &network->lines[i];
+        if (&network->machines[other->from] == from || &network->machines[other->to] == to) {
+            fprintf(stderr, "%s:%d: %s already has a line out or %s a line in\n", filename, line_number,
+                    from_name, to_name);
+            exit(1);
+        }
+    }
+
+    network_line* line = &network->lines[network->line_count++];
+    line->from = (uint32_t)(from - network->machines);
+    line->to = (uint32_t)(to - network->machines);
+    line->baud = baud;
+    initialize_serial(&line->line, baud);
+}
+
+// Loads a program once for all the machines that run it
+const PDP7_cpu* load_image(pdp7_network* network, const char* program_file, const char* memory_file,
+                           uint32_t start_address, const char* filename, int line_number) {
+    if (!memory_file) {
+        memory_file = "";
+    }
+    for (uint32_t i = 0; i < network->image_count; i++) {
+        network_image* image = &network->images[i];
+        if (strcmp(image->program_file, program_file) == 0 && strcmp(image->memory_file, memory_file) == 0 &&
+            image->start_address == start_address) {
+            return &image->cpu;
+        }
+    }
+
+    if (strlen(program_file) >= NETWORK_PATH_SIZE || strlen(memory_file) >= NETWORK_PATH_SIZE) {
+        fprintf(stderr, "%s:%d: file name too long\n", filename, line_number);
+        exit(1);
+    }
+    network_image* image = &network->images[network->image_count++];
+    strcpy(image->program_file, program_file);
+    strcpy(image->memory_file, memory_file);
+    image->start_address = start_address;
+    initialize_cpu(&image->cpu, program_file, *memory_file ? memory_file : NULL, NULL, start_address);
+    return &image->cpu;
+}
+
+network_machine* find_machine(pdp7_network* network, const char* name) {
+    for (uint32_t i = 0; i < network->machine_count; i++) {
+        if (strcmp(network->machines[i].name, name) == 0) {
+            return &network->machines[i];
+        }
+    }
+    return NULL;
+}
+
+void destroy_network(pdp7_network* network) {
+    for (uint32_t i = 0; i < network->machine_count; i++) {
+        network_machine* machine = &network->machines[i];
+        if (machine->has_storage) {
+            close_storage(&machine->pdp7.storage);
+        }
+        free_memory(&machine->pdp7.cpu);
+    }
+    // The machines shared the images' pages until now
+    for (uint32_t i = 0; i < network->image_count; i++) {
+        free_memory(&network->images[i].cpu);
+    }
+    free(network);
+}
+
+// Runs every machine on its own thread, spread over the host cores, and
+// waits until all of them have stopped
+void run_network(pdp7_network* network) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (uint32_t i = 0; i < network->machine_count; i++) {
+        network_machine* machine = &network->machines[i];
+        machine->core = cores > 1 ? (int)(i % cores) : -1;
+        pthread_create(&machine->thread, NULL, run_machine, machine);
+    }
+
+    for (uint32_t i = 0; i < network->machine_count; i++) {
+        pthread_join(network->machines[i].thread, NULL);
+    }
+}
+
+void pin_to_core(int core) {
+    if (core < 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // Best effort, unpinned still works
+}
+
+// One machine's thread. Runs in slices until it halts or traps, hits its
+// cycle limit, or its input line has closed and it has had
+// NETWORK_DRAIN_CYCLES to finish with the last word. Closing both of its
+// lines on the way out lets its neighbours wind down too.
+void* run_machine(void* arg) {
+    network_machine* machine = arg;
+    PDP7_cpu* cpu = &machine->pdp7.cpu;
+    uint64_t drain_end = UINT64_MAX;
+
+    pin_to_core(machine->core);
+
+    machine->outcome = MACHINE_HALTED;
+    while (cpu->running) {
+        uint64_t budget = NETWORK_SLICE_CYCLES;
+        if (machine->cycle_limit) {
+            if (cpu->cycles >= machine->cycle_limit) {
+                machine->outcome = MACHINE_LIMITED;
+                break;
+            }
+            if (machine->cycle_limit - cpu->cycles < budget) {
+                budget = machine->cycle_limit - cpu->cycles;
+            }
+        }
+
+        run_cycles(cpu, budget);
+
+        if (drain_end == UINT64_MAX && cpu->line_in && serial_drained(cpu->line_in)) {
+            drain_end = cpu->cycles + NETWORK_DRAIN_CYCLES;
+        }
+        if (cpu->running && cpu->cycles >= drain_end) {
+            machine->outcome = MACHINE_DRAINED;
+            break;
+        }
+    }
+
+    if (cpu->trap != TRAP_NONE) {
+        machine->outcome = MACHINE_TRAPPED;
+    }
+
+    if (cpu->line_in) {
+        serial_close(cpu->line_in);
+    }
+    if (cpu->line_out) {
+        serial_close(cpu->line_out);
+    }
+    return NULL;
+}
+
+// Prints how each machine ended and what each line carried. Returns true
+// if any machine trapped.
+bool network_report(const pdp7_network* network) {
+    bool trapped = false;
+
+    for (uint32_t i = 0; i < network->machine_count; i++) {
+        const network_machine* machine = &network->machines[i];
+        const PDP7_cpu* cpu = &machine->pdp7.cpu;
+        printf("Machine %s: %s after %" PRIu64 " cycles, PC %05" PRIo32 " AC %06" PRIo32 "\n", machine->name,
+               OUTCOME_NAMES[machine->outcome], cpu->cycles, cpu->pc, cpu->accumulator);
+        if (machine->outcome == MACHINE_TRAPPED) {
+            print_trap(cpu);
+            trapped = true;
+        }
+    }
+
+    for (uint32_t i = 0; i < network->line_count; i++) {
+        const network_line* line = &network->lines[i];
+        printf("Line %s -> %s: %" PRIu64 " words", network->machines[line->from].name,
+               network->machines[line->to].name, line->line.words);
+        if (line->baud) {
+            printf(" at %" PRIu32 " baud\n", line->baud);
+        } else {
+            printf(", unlimited speed\n");
+        }
+    }
+
+    return trapped;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "pdp7.h"
+#include "serial.h"
+#include <pthread.h>
+
+#define NETWORK_MAX_MACHINES 16
+#define NETWORK_MAX_LINES 16
+#define NETWORK_NAME_SIZE 32
+#define NETWORK_PATH_SIZE 256
+#define NETWORK_SLICE_CYCLES 10000 // Cycles each machine runs between checks
+#define NETWORK_DRAIN_CYCLES 100000 // Cycles a machine keeps running once its input is gone
+
+// Why a machine of the network stopped
+typedef enum {
+    MACHINE_HALTED,
+    MACHINE_TRAPPED,
+    MACHINE_DRAINED,   // Its input line closed and it was left waiting
+    MACHINE_LIMITED,   // Ran out of its cycle limit
+} machine_outcome;
+
+typedef struct {
+    char name[NETWORK_NAME_SIZE];
+    PDP7 pdp7;
+    bool has_storage;
+    uint64_t cycle_limit;          // 0 runs until halted or drained
+    machine_outcome outcome;
+    int core;                      // Host core the machine's thread is pinned to, -1 if not pinned
+    pthread_t thread;
+} network_machine;
+
+// A loaded program, shared read-only by every machine started from the same
+// files and start address
+typedef struct {
+    char program_file[NETWORK_PATH_SIZE];
+    char memory_file[NETWORK_PATH_SIZE];   // Empty for none
+    uint32_t start_address;
+    PDP7_cpu cpu;
+} network_image;
+
+typedef struct {
+    serial_line line;
+    uint32_t from;                 // Sending machine
+    uint32_t to;                   // Receiving machine
+    uint32_t baud;                 // 0 for unlimited speed
+} network_line;
+
+// Machines wired together by serial lines: one machine's TLS output is the
+// next one's KSF/KRB input. Each machine runs on its own thread.
+typedef struct {
+    network_machine machines[NETWORK_MAX_MACHINES];
+    network_line lines[NETWORK_MAX_LINES];
+    network_image images[NETWORK_MAX_MACHINES];
+    uint32_t machine_count;
+    uint32_t line_count;
+    uint32_t image_count;
+} pdp7_network;
+
+pdp7_network* load_network(const char* filename);
+void destroy_network(pdp7_network* network);
+void run_network(pdp7_network* network);
+bool network_report(const pdp7_network* network);
+network_machine* find_machine(pdp7_network* network, const char* name);
@@ -1,12 +1,18 @@
 #include "pdp7.h"
+#include "instrument.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 
-uint32_t io_buffer = 0;
+void run_pdp7(PDP7 *pdp7, PDP7_options *options) {
+    const char *program_file = options->program_file;
+    const char *memory_file = options->memory_file;
+    uint32_t start_address = options->start_address;
+    bool use_display = options->use_display;
+    bool debug = options->debug;
+    bool headless = options->headless;
 
-void run_pdp7(PDP7 *pdp7, const char *program_file, const char *memory_file, uint32_t start_address, bool use_display, bool debug, bool headless) {
     printf("PDP-7 Minicomputer Emulator\n");
     printf("---------------------------\n\n");
 
@@ -62,21 +68,150 @@ void run_pdp7(PDP7 *pdp7, const char *program_file, const char *memory_file, uin
 
     pthread_t threads[2]; 
 
-    if (use_display) {
-        initialize_display(&pdp7->display, &io_buffer);
+    live_metrics* metrics = NULL;
+    if (options->metrics_name) {
+        metrics = create_metrics(options->metrics_name);
+    }
+
+    memory_heatmap* heatmap = NULL;
+    if (options->heatmap) {
+        heatmap = create_heatmap();
+    }
+
+    // Keystrokes come from the display window when there is one. Otherwise
+    // headless runs read stdin and interactive ones take console `k` lines.
+    // Replay makes the journal the only source of keys
+    bool replay = options->replay_file != NULL;
+    bool window = use_display && !options->terminal_display;
+    initialize_keyboard(&pdp7->keyboard, !window && headless && !replay, !window && !headless && !replay);
+    if (replay) {
+        pdp7->keyboard.replay = open_journal(options->replay_file, true);
+    }
+    if (options->record_file) {
+        pdp7->keyboard.record = open_journal(options->record_file, false);
+    }
+
+    pdp7->io_buffer = 0;
+    if (use_display && options->terminal_display) {
+        initialize_terminal_display(&pdp7->display, &pdp7->io_buffer, metrics, headless);
+    } else if (use_display) {
+        initialize_display(&pdp7->display, &pdp7->io_buffer, replay ? NULL : &pdp7->keyboard, metrics, heatmap);
+    }
+    if (use_display && !options->deterministic) {
         pthread_create(&threads[0], NULL, run_display, &pdp7->display);
     }
 
-    initialize_cpu(&pdp7->cpu, program_file, memory_file, &io_buffer, start_address);
+    initialize_cpu(&pdp7->cpu, program_file, memory_file, &pdp7->io_buffer, start_address);
+    pdp7->cpu.model = options->model;
+    pdp7->cpu.keyboard = &pdp7->keyboard;
+    pdp7->cpu.metrics = metrics;
+    pdp7->cpu.heatmap = heatmap;
 
-    PDP7_cpu_options cpu_options = { .cpu = pdp7->cpu, .debug = debug, .headless = headless };
+    if (options->profile_file) {
+        pdp7->cpu.profiler = create_profiler(options->profile_file, start_address);
+        if (program_file) {
+            profiler_load_labels(pdp7->cpu.profiler, program_file, start_address);
+        }
+        if (memory_file) {
+            profiler_load_labels(pdp7->cpu.profiler, memory_file, 0);
+        }
+    }
 
-    pthread_create(&threads[1], NULL, run_cpu, &cpu_options);
-    pthread_join(threads[1], NULL);
+    if (options->trace_file) {
+        pdp7->cpu.trace = create_trace(options->trace_file, TRACE_DEFAULT_RECORDS, options->trace_stream);
+    }
 
-    if (use_display) {
+    if (options->storage_file) {
+        initialize_storage(&pdp7->storage, options->storage_file);
+        pdp7->cpu.storage = &pdp7->storage;
+    }
+
+    pdp7->host = NULL;
+    if (options->host_output_file || options->host_input_file) {
+        pdp7->host = create_host_service(options->host_output_file, options->host_input_file);
+        attach_host_service(pdp7->host, &pdp7->cpu);
+    }
+
+    // Attached last so the shadow copy starts from the fully loaded machine
+    if (options->lockstep_engine) {
+        const cpu_engine* engine = find_engine(options->lockstep_engine);
+        if (!engine) {
+            fprintf(stderr, "Unknown engine %s, available: %s\n", options->lockstep_engine, engine_names());
+            exit(1);
+        }
+        pdp7->cpu.lockstep = create_lockstep(engine, options->lockstep_interval, &pdp7->cpu);
+    }
+
+    PDP7_cpu_options cpu_options = { .cpu = &pdp7->cpu, .debug = debug, .headless = headless };
+    if (options->gdb_address) {
+        cpu_options.gdb = create_gdb_stub(options->gdb_address);
+    }
+
+    if (options->deterministic) {
+        // CPU and devices share this thread, stepped at cycle points
+        cpu_scheduler scheduler;
+        initialize_scheduler(&scheduler, &pdp7->cpu, use_display ? &pdp7->display : NULL, stdout);
+        INSTRUMENT_RUN_BEGIN();
+        run_scheduler(&scheduler, debug);
+        report_halt(&pdp7->cpu);
+    } else {
+        pthread_create(&threads[1], NULL, run_cpu, &cpu_options);
+        pthread_join(threads[1], NULL);
+    }
+    bool trapped = pdp7->cpu.trap != TRAP_NONE;
+    if (cpu_options.gdb) {
+        destroy_gdb_stub(cpu_options.gdb);
+    }
+    if (pdp7->keyboard.record) {
+        close_journal(pdp7->keyboard.record, pdp7->cpu.cycles);
+    }
+    if (pdp7->keyboard.replay) {
+        close_journal(pdp7->keyboard.replay, pdp7->cpu.cycles);
+    }
+    free_memory(&pdp7->cpu);
+
+    if (use_display && options->deterministic) {
+        close_display(&pdp7->display);
+    } else if (use_display) {
         pdp7->display.running = false;
         pthread_join(threads[0], NULL);
     }
+
+    if (options->storage_file) {
+        close_storage(&pdp7->storage);
+    }
+
+    if (pdp7->host) {
+        if (pdp7->host->has_result) {
+            printf("Result: %06o\n", pdp7->host->result);
+        }
+        destroy_host_service(pdp7->host);
+    }
+
+    if (pdp7->cpu.profiler) {
+        destroy_profiler(pdp7->cpu.profiler);
+    }
+
+    if (pdp7->cpu.trace) {
+        destroy_trace(pdp7->cpu.trace);
+    }
+
+    if (pdp7->cpu.lockstep) {
+        destroy_lockstep(pdp7->cpu.lockstep);
+    }
+
+    if (metrics) {
+        destroy_metrics(metrics);
+    }
+
+    if (heatmap) {
+        destroy_heatmap(heatmap);
+    }
+
+    INSTRUMENT_REPORT();
+
+    if (trapped) {
+        exit(1);
+    }
 }
 
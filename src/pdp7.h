@@ -2,6 +2,16 @@
 
 #include "pdp7_cpu.h"
 #include "display.h"
+#include "storage.h"
+#include "keyboard.h"
+#include "profiler.h"
+#include "trace.h"
+#include "metrics.h"
+#include "lockstep.h"
+#include "heatmap.h"
+#include "scheduler.h"
+#include "gdb_stub.h"
+#include "host_service.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,6 +20,35 @@
 typedef struct {
     PDP7_cpu cpu;
     display_340 display;
+    block_storage storage;
+    keyboard_device keyboard;
+    host_service* host;        // NULL unless -O or -I
+    uint32_t io_buffer;        // Word TLS hands to the display
 } PDP7;
 
-void run_pdp7(PDP7 *pdp7, const char *program_file, const char *memory_file, uint32_t start_address, bool use_display, bool debug, bool headless);
\ No newline at end of file
+typedef struct {
+    const char* program_file;
+    const char* memory_file;
+    const char* storage_file;
+    const char* profile_file;
+    const char* trace_file;
+    const char* metrics_name;
+    const char* lockstep_engine;
+    const char* record_file;
+    const char* replay_file;
+    const char* gdb_address;     // Unix socket path or TCP port of the GDB stub
+    const char* host_output_file; // Host service output, "-" for stdout
+    const char* host_input_file;
+    uint64_t lockstep_interval;
+    uint32_t start_address;
+    uint8_t model;               // MODEL_* bit of the machine to emulate
+    bool use_display;
+    bool terminal_display;
+    bool debug;
+    bool headless;
+    bool trace_stream;
+    bool heatmap;
+    bool deterministic;
+} PDP7_options;
+
+void run_pdp7(PDP7 *pdp7, PDP7_options *options);
\ No newline at end of file
@@ -1,165 +1,423 @@
 #include "pdp7_cpu.h"
+#include "pdp7_isa.h"
+#include "storage.h"
+#include "keyboard.h"
+#include "profiler.h"
+#include "trace.h"
+#include "debugger.h"
+#include "metrics.h"
+#include "lockstep.h"
+#include "serial.h"
+#include "iot_bus.h"
+#include "heatmap.h"
+#include "console.h"
+#include "gdb_stub.h"
+#include "instrument.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
-
-// PDP-7 Opcodes in octal
-#define OP_CAL  000 // Call subroutine and load accumulator
-#define OP_DAC  004 // Deposit accumulator into memory
-#define OP_JMS  010 // Jump to subroutine
-#define OP_DZM  014 // Deposit zero into memory
-#define OP_LAC  020 // Load accumulator from memory
-#define OP_XOR  024 // Exclusive OR
-#define OP_ADD  030 // Add to accumulator
-#define OP_TAD  034 // Two's complement add to accumulator
-#define OP_XCT  040 // Execute instruction
-#define OP_ISZ  044 // Increment and skip if zero
-#define OP_AND  050 // Logical AND with accumulator
-#define OP_SAD  054 // Skip on accumulator different
-#define OP_JMP  060 // Jump
-#define OP_IOT  070 // Input/Output Transfer
-#define OP_OPR  074 // Operate
-#define OP_EAE  077 // Extended arithmetic element (stubbed)
-
-// Operate instructions
-#define OPR_CMA  0740001 // Complement AC
-#define OPR_CML  0740002 // Complement link
-#define OPR_OAS  0740004 // Inclusive OR AC switches
-#define OPR_LAS  0750004 // Load AC from switches
-#define OPR_RAL  0740010 // Rotate AC + link left one place
-#define OPR_RCL  0744010 // Clear link, then rotate left one place
-#define OPR_RTL  0742010 // Rotate AC left twice
-#define OPR_RAR  0740020 // Rotate AC + link right one place
-#define OPR_RCR  0744020 // Clear link, then rotate right one place
-#define OPR_RTR  0742020 // Rotate AC right twice
-#define OPR_HLT  0740040 // Halt
-#define OPR_SZA  0740200 // Skip on zero AC
-#define OPR_SNA  0741200 // Skip on non-zero AC
-#define OPR_SPA  0741100 // Skip on positive AC
-#define OPR_SMA  0740100 // Skip on negative AC
-#define OPR_SZL  0741400 // Skip on zero link
-#define OPR_SNL  0740400 // Skip on non-zero link
-#define OPR_SKP  0471000 // Skip unconditionally
-#define OPR_CLL  0744000 // Clear link
-#define OPR_STL  0744002 // Set the link
-#define OPR_CLA  0750000 // Clear AC
-#define OPR_CLC  0750001 // Clear and complement AC
-#define OPR_GLK  0750020 // Get link
-
-// I/O Instructions
-#define IOT_KRB 0700312
-#define IOT_TLS 0700406
-
-uint32_t program_start_address;
+#include <pthread.h>
+#include <unistd.h>
+
+#define CONSOLE_IDLE_SLEEP_US 100 // Poll interval while paused or halted
+
+// First thing in every instruction's case: one the model lacks traps as if
+// the word were unknown. `model` is a constant in each specialized
+// interpreter, so the check compiles away.
+#define REQUIRE_MODEL(name, kind) \
+    if (!MODEL_HAS(model, name)) { \
+        cpu_trap(cpu, kind, instruction); \
+        break; \
+    }
 
 void load_memory_from_file(PDP7_cpu *cpu, const char *filename, uint32_t start_address);
 void perform_cycle(PDP7_cpu *cpu);
+uint64_t run_cycles(PDP7_cpu *cpu, uint64_t budget);
+uint64_t run_instructions(PDP7_cpu *cpu, uint64_t count);
 void decode_instruction(PDP7_cpu *cpu, uint32_t instruction);
 void execute_instruction(PDP7_cpu* cpu, uint32_t instruction);
 void print_cpu_state(const PDP7_cpu *cpu);
 void print_memory(const PDP7_cpu *cpu, uint32_t start, uint32_t end);
+void cpu_trap(PDP7_cpu *cpu, cpu_trap_kind kind, uint32_t instruction);
+void print_trap(const PDP7_cpu *cpu);
+void report_halt(PDP7_cpu *cpu);
+void run_console_session(PDP7_cpu_options *cpu_options);
+void run_gdb_session(PDP7_cpu_options *cpu_options);
+bool run_slice(PDP7_cpu_options *cpu_options, cpu_debugger *debugger, uint32_t budget, bool *step_off);
+bool console_command(PDP7_cpu_options *cpu_options, cpu_debugger *debugger, const char *command, bool *paused, bool *step_off);
+bool debugger_command(cpu_debugger *debugger, const char *command);
 uint32_t get_effective_address(PDP7_cpu *cpu, uint32_t address, bool indirect);
+uint32_t resolve_address(const PDP7_cpu *cpu, uint32_t address, bool indirect);
+
+// Hands a word to `model`'s interpreter, XCT uses it to stay on that model
+static inline __attribute__((always_inline)) void execute_nested(PDP7_cpu* cpu, uint32_t instruction, const unsigned model) {
+    switch (model) {
+        case MODEL_PDP4:
+            execute_pdp4(cpu, instruction);
+            break;
+        case MODEL_PDP9:
+            execute_pdp9(cpu, instruction);
+            break;
+        default:
+            execute_pdp7(cpu, instruction);
+    }
+}
 
 void* run_cpu(void* arg) {
     PDP7_cpu_options* cpu_options = (PDP7_cpu_options*)arg;
 
-    PDP7_cpu* cpu = &cpu_options->cpu;
+    PDP7_cpu* cpu = cpu_options->cpu;
+
+    INSTRUMENT_RUN_BEGIN();
 
     if (!cpu_options->headless) {
-        print_cpu_state(cpu);
-        printf("Commands: [n]ext, [c]ontinue, [m]emory, [q]uit\n");
-
-        char command[10];
-        while (1) {
-            printf("> ");
-            if (fgets(command, sizeof(command), stdin)) {
-                command[strcspn(command, "\r\n")] = '\0';
-                if (strcmp(command, "n") == 0) {
+        run_console_session(cpu_options);
+    } else if (cpu_options->gdb) {
+        run_gdb_session(cpu_options);
+        report_halt(cpu);
+    } else {
+        if (cpu->lockstep) {
+            // Batches checked against the other engine, a divergence stops the machine
+            while (cpu->running) {
+                lockstep_run(cpu->lockstep, cpu);
+            }
+        }
+
+        if (!cpu_options->debug) {
+            // The model's own loop, no per-instruction dispatch
+            run_instructions(cpu, UINT64_MAX);
+        }
+
+        while (cpu->running) {
+            perform_cycle(cpu);
+            print_cpu_state(cpu);
+        }
+
+        report_halt(cpu);
+
+        printf("Press any key to quit.\n");
+        getchar();
+    }
+
+    return NULL;
+}
+
+void report_halt(PDP7_cpu* cpu) {
+    INSTRUMENT_RUN_END();
+
+    if (cpu->metrics) {
+        metrics_publish(cpu->metrics, cpu);
+    }
+
+    print_trap(cpu);
+    printf("CPU halted\n");
+    printf("Total cycles: %lu\n", cpu->cycles);
+
+    if (cpu->profiler) {
+        profiler_write_report(cpu->profiler);
+    }
+
+    if (cpu->trace) {
+        trace_dump(cpu->trace);
+    }
+
+    if (cpu->lockstep) {
+        lockstep_report(cpu->lockstep);
+    }
+}
+
+// Interactive session. The console thread reads stdin and queues command
+// lines, this (CPU) thread runs the machine in slices and drains the queue
+// in between, so commands land within one slice without the interpreter
+// loop checking anything per instruction.
+void run_console_session(PDP7_cpu_options* cpu_options) {
+    PDP7_cpu* cpu = cpu_options->cpu;
+    console_queue queue;
+    cpu_debugger debugger;
+    pthread_t console_thread;
+    char command[CONSOLE_LINE_SIZE];
+    bool paused = true;
+    bool halted = false;
+    bool step_off = false;
+    bool quit = false;
+
+    initialize_console_queue(&queue);
+    initialize_debugger(&debugger);
+    cpu->attention = &queue.attention;
+
+    print_cpu_state(cpu);
+    printf("Commands: [n]ext, [c]ontinue, [p]ause, [r]egisters, [m]emory, [e]xamine/deposit, [d]ebug, [k]eys, [b]reak, [w]atch, [i]nfo, [x] clear, [q]uit\n");
+    if (pthread_create(&console_thread, NULL, run_console, &queue) != 0) {
+        fprintf(stderr, "Failed to start the console thread\n");
+        exit(1);
+    }
+
+    while (!quit) {
+        if (paused || !cpu->running) {
+            if (console_pop(&queue, command)) {
+                quit = console_command(cpu_options, &debugger, command, &paused, &step_off);
+            } else {
+                usleep(CONSOLE_IDLE_SLEEP_US);
+            }
+        } else {
+            if (run_slice(cpu_options, &debugger, CONSOLE_POLL_INSTRUCTIONS, &step_off)) {
+                paused = true;
+            }
+            atomic_store_explicit(&queue.attention, false, memory_order_relaxed);
+            while (!quit && console_pop(&queue, command)) {
+                quit = console_command(cpu_options, &debugger, command, &paused, &step_off);
+            }
+        }
+
+        if (!cpu->running && !halted) {
+            halted = true;
+            report_halt(cpu);
+        }
+    }
+
+    if (!halted) {
+        cpu->running = false;
+        report_halt(cpu);
+    }
+
+    pthread_join(console_thread, NULL);
+    cpu->attention = NULL;
+}
+
+// Headless run a GDB client can attach to and detach from. The machine
+// runs free in slices; between them the CPU thread executes whatever the
+// stub thread received, and while stopped it does nothing else. Returns
+// when the machine halts with nobody attached, or the client kills it.
+void run_gdb_session(PDP7_cpu_options* cpu_options) {
+    PDP7_cpu* cpu = cpu_options->cpu;
+    gdb_stub* stub = cpu_options->gdb;
+    char packet[GDB_PACKET_SIZE];
+    char reply[GDB_PACKET_SIZE];
+    bool stopped = false;
+    bool step_off = false;
+
+    cpu->attention = &stub->attention;
+
+    for (;;) {
+        if (atomic_exchange(&stub->attach, false)) {
+            stopped = true;
+        }
+        if (atomic_exchange(&stub->interrupt, false) && !stopped) {
+            stopped = true;
+            gdb_stop_reply(cpu, GDB_SIGINT, reply);
+            gdb_send(stub, reply);
+        }
+
+        if (gdb_receive(stub, packet)) {
+            gdb_action action = gdb_execute(stub, cpu, packet, reply);
+            if (action == GDB_KILL) {
+                cpu->running = false;
+                break;
+            }
+            if (action == GDB_STEP) {
+                if (cpu->running) {
                     perform_cycle(cpu);
-                    print_cpu_state(cpu);
-                } else if (strcmp(command, "c") == 0) {
-                    while (cpu->running) {
-                        perform_cycle(cpu);
-                        if (cpu_options->debug) {
-                            print_cpu_state(cpu);
-                        }
-                    }
-                    break;
-                } else if (strcmp(command, "m") == 0) {
-                    uint32_t start, end;
-                    printf("Enter start address: ");
-                    scanf("%o", &start);
-                    printf("Enter end address: ");
-                    scanf("%o", &end);
-                    while (getchar() != '\n');
-                    print_memory(cpu, start, end);
-                } else if (strcmp(command, "q") == 0) {
-                    cpu->running = 0;
+                }
+                gdb_stop_reply(cpu, GDB_SIGTRAP, reply);
+            }
+            if (action != GDB_CONTINUE) {
+                gdb_send(stub, reply);
+            }
+            if (action == GDB_DETACH) {
+                debugger_clear(&stub->debugger);
+                if (!cpu->running) {
                     break;
-                } else {
-                    printf("Unknown command. Please enter [n], [c], [m], [l], or [q].\n");
                 }
             }
+            if (action != GDB_REPLY) {
+                stopped = action == GDB_STEP;
+                // Resuming on a breakpoint runs the word it stopped before
+                step_off = action == GDB_CONTINUE;
+            }
+            continue;
         }
-    } else {
-        while (cpu->running) {
+
+        if (!cpu->running) {
+            if (!atomic_load(&stub->connected)) {
+                break;
+            }
+            if (!stopped) {
+                // HLT or a trap, the client can still look at the machine
+                stopped = true;
+                gdb_stop_reply(cpu, GDB_SIGTRAP, reply);
+                gdb_send(stub, reply);
+            }
+        }
+
+        if (stopped || !cpu->running) {
+            usleep(CONSOLE_IDLE_SLEEP_US);
+            continue;
+        }
+
+        if (run_slice(cpu_options, &stub->debugger, GDB_POLL_INSTRUCTIONS, &step_off)) {
+            stopped = true;
+            gdb_stop_reply(cpu, GDB_SIGTRAP, reply);
+            gdb_send(stub, reply);
+        }
+        atomic_store_explicit(&stub->attention, false, memory_order_relaxed);
+    }
+
+    cpu->attention = NULL;
+}
+
+// Runs up to `budget` instructions. When anything is set in the debugger
+// each one is checked first and true is returned on a hit; otherwise the
+// loop is unchecked. `step_off` lets the instruction we stopped on run.
+bool run_slice(PDP7_cpu_options* cpu_options, cpu_debugger* debugger, uint32_t budget, bool* step_off) {
+    PDP7_cpu* cpu = cpu_options->cpu;
+
+    if (!debugger_active(debugger)) {
+        for (uint32_t n = 0; n < budget && cpu->running; n++) {
             perform_cycle(cpu);
             if (cpu_options->debug) {
                 print_cpu_state(cpu);
             }
         }
+        return false;
     }
 
-    printf("CPU halted\n");
-    printf("Total cycles: %lu\n", cpu->cycles);
+    for (uint32_t n = 0; n < budget && cpu->running; n++) {
+        if (!*step_off && debugger_check(debugger, cpu)) {
+            printf("Stopped on %s\n", debugger->reason);
+            print_cpu_state(cpu);
+            return true;
+        }
+        *step_off = false;
 
-    if (cpu_options->headless) {
-        printf("Press any key to quit.\n");
-        getchar();
-    } else {
-        printf("Commands: [m]emory, [q]uit\n");
-        char command[10];
-        while (1) {
-            printf("> ");
-            if (fgets(command, sizeof(command), stdin)) {
-                command[strcspn(command, "\r\n")] = '\0';
-                if (strcmp(command, "m") == 0) {
-                    uint32_t start, end;
-                    printf("Enter start address: ");
-                    scanf("%o", &start);
-                    printf("Enter end address: ");
-                    scanf("%o", &end);
-                    while (getchar() != '\n');
-                    print_memory(cpu, start, end);
-                } else if (strcmp(command, "q") == 0) {
-                    cpu->running = 0;
-                    break;
-                } else {
-                    printf("Unknown command. Please enter [m] or [q].\n");
-                }
+        perform_cycle(cpu);
+        if (cpu_options->debug) {
+            print_cpu_state(cpu);
+        }
+    }
+    return false;
+}
+
+// Executes one console line on the CPU thread, returns true on quit
+bool console_command(PDP7_cpu_options* cpu_options, cpu_debugger* debugger, const char* command, bool* paused, bool* step_off) {
+    PDP7_cpu* cpu = cpu_options->cpu;
+    uint32_t start, end;
+
+    if (strcmp(command, "n") == 0) {
+        if (cpu->running) {
+            *paused = true;
+            perform_cycle(cpu);
+        }
+        print_cpu_state(cpu);
+    } else if (strcmp(command, "c") == 0) {
+        *paused = false;
+        *step_off = true;
+    } else if (strcmp(command, "p") == 0) {
+        *paused = true;
+        print_cpu_state(cpu);
+    } else if (strcmp(command, "r") == 0) {
+        print_cpu_state(cpu);
+    } else if (sscanf(command, "m %o %o", &start, &end) == 2) {
+        print_memory(cpu, start, end);
+    } else if (sscanf(command, "e %o %o", &start, &end) == 2) {
+        write_memory(cpu, start & (MEMORY_SIZE - 1), end & 0777777);
+    } else if (sscanf(command, "e %o", &start) == 1) {
+        print_memory(cpu, start, start);
+    } else if (strcmp(command, "d") == 0) {
+        cpu_options->debug = !cpu_options->debug;
+        printf("Debug mode %s\n", cpu_options->debug ? "enabled" : "disabled");
+    } else if (strncmp(command, "k ", 2) == 0) {
+        if (cpu->keyboard && cpu->keyboard->from_console) {
+            for (const char* c = command + 2; *c != '\0'; c++) {
+                keyboard_push(cpu->keyboard, (uint8_t)*c);
             }
+            keyboard_push(cpu->keyboard, '\r');
+        } else {
+            printf("Type into the display window instead\n");
         }
+    } else if (debugger_command(debugger, command)) {
+        return false;
+    } else if (strcmp(command, "q") == 0) {
+        return true;
+    } else {
+        printf("Unknown command. Please enter [n], [c], [p], [r], [m], [e], [d], [k], [b], [w], [i], [x], or [q].\n");
     }
+    return false;
+}
 
-    return NULL;
+// Breakpoint commands of the console:
+//   b <addr>             break before executing addr
+//   b ac|link <value>    break when AC or link becomes value (octal)
+//   b cycles <count>     break when the cycle counter reaches count
+//   w <r|w|x> <start> [<end>]  watch reads, writes or executes of a range
+//   i                    list everything set
+//   x                    clear everything
+bool debugger_command(cpu_debugger* debugger, const char* command) {
+    char kind[16];
+    uint32_t start, end;
+    uint64_t value;
+
+    if (strcmp(command, "i") == 0) {
+        debugger_print(debugger);
+    } else if (strcmp(command, "x") == 0) {
+        debugger_clear(debugger);
+        printf("Breakpoints and watchpoints cleared\n");
+    } else if (sscanf(command, "b ac %" SCNo64, &value) == 1 ||
+               sscanf(command, "b link %" SCNo64, &value) == 1 ||
+               sscanf(command, "b cycles %" SCNu64, &value) == 1) {
+        condition_kind condition = command[2] == 'a' ? CONDITION_AC :
+                                   command[2] == 'l' ? CONDITION_LINK : CONDITION_CYCLES;
+        if (!debugger_add_condition(debugger, condition, value)) {
+            printf("Too many conditions\n");
+        }
+    } else if (sscanf(command, "b %o", &start) == 1) {
+        debugger_flag_range(debugger, start, start, DEBUG_BREAK);
+    } else if (sscanf(command, "w %15s %o %o", kind, &start, &end) >= 2) {
+        uint8_t flags = (strchr(kind, 'r') ? DEBUG_WATCH_READ : 0) |
+                        (strchr(kind, 'w') ? DEBUG_WATCH_WRITE : 0) |
+                        (strchr(kind, 'x') ? DEBUG_WATCH_EXEC : 0);
+        if (sscanf(command, "w %15s %o %o", kind, &start, &end) == 2) {
+            end = start;
+        }
+        debugger_flag_range(debugger, start, end, flags);
+    } else {
+        return false;
+    }
+    return true;
 }
 
 void initialize_cpu(PDP7_cpu *cpu, const char* program_file, const char* memory_file, uint32_t* io_buffer, uint32_t start_address) {
-    *io_buffer = 0;
-    program_start_address = start_address;
-    cpu->accumulator = 0;
-    for (int i = 0; i < MEMORY_SIZE; ++i) {
-        cpu->memory[i] = 0;
+    if (io_buffer) {
+        *io_buffer = 0;
     }
+    cpu->program_start_address = start_address;
+    cpu->accumulator = 0;
+    initialize_memory(cpu);
     cpu->memory_address = 0;
     cpu->memory_buffer = 0;
-    cpu->pc = start_address;
+    cpu->pc = wrap_pc(start_address);
     cpu->ir = 0;
+    cpu->xct_depth = 0;
+    cpu->model = MODEL_PDP7;
+    cpu->bus = &standard_iot_bus;
     cpu->io_buffer = io_buffer;
+    cpu->storage = NULL;
+    cpu->keyboard = NULL;
+    cpu->profiler = NULL;
+    cpu->trace = NULL;
+    cpu->metrics = NULL;
+    cpu->lockstep = NULL;
+    cpu->heatmap = NULL;
+    cpu->line_in = NULL;
+    cpu->line_out = NULL;
+    cpu->attention = NULL;
     cpu->link = 0;
+    cpu->extend_mode = false;
     cpu->cycles = 0;
     cpu->running = true;
+    cpu->trap = TRAP_NONE;
+    cpu->trap_pc = 0;
+    cpu->trap_instruction = 0;
 
     if (program_file) {
         load_memory_from_file(cpu, program_file, start_address);
@@ -168,6 +426,9 @@ void initialize_cpu(PDP7_cpu *cpu, const char* program_file, const char* memory_
     if (memory_file) {
         load_memory_from_file(cpu, memory_file, 0);
     }
+
+    // The loaded image is the baseline, only later stores count as dirty
+    memset(cpu->dirty, 0, sizeof(cpu->dirty));
 }
 
 void load_memory_from_file(PDP7_cpu *cpu, const char *filename, uint32_t start_address) {
@@ -198,7 +459,7 @@ void load_memory_from_file(PDP7_cpu *cpu, const char *filename, uint32_t start_a
                 fclose(file);
                 exit(EXIT_FAILURE);
             }
-            cpu->memory[start_address + address] = word;
+            write_memory(cpu, start_address + address, word);
         } else {
             fprintf(stderr, "Invalid format in file %s: %s\n", filename, line);
             fclose(file);
@@ -212,19 +473,124 @@ void load_memory_from_file(PDP7_cpu *cpu, const char *filename, uint32_t start_a
 uint32_t get_effective_address(PDP7_cpu* cpu, uint32_t address, bool indirect) {
     if (indirect) {
         cpu->cycles++;
-        // Pointer indirection handling
-        return cpu->memory[address & 017777];
-    } else {
-        return address;
     }
+    return resolve_address(cpu, address, indirect);
 }
 
-void perform_cycle(PDP7_cpu* cpu) {
-    uint32_t instruction = cpu->memory[cpu->pc++];
+// Direct addresses stay in the bank the PC is in. Pointers fetched for
+// indirect addressing are 13 bits in that bank too, or the full 15 bits in
+// extend mode.
+uint32_t resolve_address(const PDP7_cpu* cpu, uint32_t address, bool indirect) {
+    uint32_t bank = cpu->pc & BANK_MASK;
+    uint32_t direct = bank | (address & (BANK_SIZE - 1));
+    if (!indirect) {
+        return direct;
+    }
+
+    uint32_t pointer = read_memory(cpu, direct);
+    return cpu->extend_mode ? pointer & (MEMORY_SIZE - 1) : bank | (pointer & (BANK_SIZE - 1));
+}
+
+// One instruction with every hook, the body of each model's loops
+static inline __attribute__((always_inline)) void cycle_model(PDP7_cpu* cpu, const unsigned model) {
+    uint32_t pc = cpu->pc;
+    uint64_t cycles = cpu->cycles;
+    uint32_t instruction = read_memory(cpu, pc);
+    cpu->pc = wrap_pc(pc + 1);
+
+    INSTRUMENT_START(timer);
 
     decode_instruction(cpu, instruction);
 
-    execute_instruction(cpu, instruction);
+    if (cpu->heatmap) {
+        heatmap_record(cpu->heatmap, cpu, pc, instruction);
+    }
+
+    execute_nested(cpu, instruction, model);
+
+    INSTRUMENT_INSTRUCTION(timer, instruction);
+
+    if (cpu->trace) {
+        trace_instruction(cpu->trace, pc, instruction, cpu);
+    }
+
+    if (cpu->metrics) {
+        metrics_instruction(cpu->metrics, instruction, cpu);
+    }
+
+    if (cpu->profiler) {
+        profiler_record(cpu->profiler, pc, instruction, cpu->pc, cpu->cycles - cycles);
+    }
+}
+
+// Single steps with whichever interpreter the machine's model has
+void perform_cycle(PDP7_cpu* cpu) {
+    switch (cpu->model) {
+        case MODEL_PDP4:
+            step_pdp4(cpu);
+            break;
+        case MODEL_PDP9:
+            step_pdp9(cpu);
+            break;
+        default:
+            step_pdp7(cpu);
+    }
+}
+
+// Stops the machine on a word it cannot execute. The caller decides what
+// that means: the emulator reports it and exits 1, the fuzzer counts it.
+void cpu_trap(PDP7_cpu* cpu, cpu_trap_kind kind, uint32_t instruction) {
+    cpu->trap = kind;
+    cpu->trap_pc = wrap_pc(cpu->pc - 1);
+    cpu->trap_instruction = instruction;
+    cpu->running = false;
+}
+
+void print_trap(const PDP7_cpu* cpu) {
+    switch (cpu->trap) {
+        case TRAP_OPCODE:
+            fprintf(stderr, "Unknown opcode: %o\n", (cpu->trap_instruction >> 12) & 074);
+            break;
+        case TRAP_OPERATE:
+            fprintf(stderr, "Unknown operate instruction: %o\n", cpu->trap_instruction);
+            break;
+        case TRAP_IOT:
+            fprintf(stderr, "Unknown I/O instruction: %o\n", cpu->trap_instruction);
+            break;
+        case TRAP_XCT_LOOP:
+            fprintf(stderr, "XCT chain deeper than %d: %o\n", XCT_MAX_DEPTH, cpu->trap_instruction);
+            break;
+        case TRAP_NONE:
+            return;
+    }
+    fprintf(stderr, "Trapped at %05o\n", cpu->trap_pc);
+}
+
+// Headless run for tools that drive the CPU without a console. Stops on
+// HLT or once `budget` more cycles have run, returns instructions executed.
+uint64_t run_cycles(PDP7_cpu* cpu, uint64_t budget) {
+    uint64_t end = cpu->cycles + budget;
+    uint64_t instructions = 0;
+
+    while (cpu->running && cpu->cycles < end) {
+        perform_cycle(cpu);
+        instructions++;
+    }
+
+    return instructions;
+}
+
+// Runs up to `count` instructions, stopping early on HLT. This is the
+// reference engine's batch entry point; it picks the model's loop once.
+uint64_t run_instructions(PDP7_cpu* cpu, uint64_t count) {
+    switch (cpu->model) {
+        case MODEL_PDP4:
+            return run_pdp4_instructions(cpu, count);
+        case MODEL_PDP9:
+            return run_pdp9_instructions(cpu, count);
+        default:
+            return run_pdp7_instructions(cpu, count);
+    }
 }
 
 void decode_instruction(PDP7_cpu* cpu, uint32_t instruction) {
@@ -234,271 +600,342 @@ void decode_instruction(PDP7_cpu* cpu, uint32_t instruction) {
 
     cpu->ir = opcode;
     cpu->memory_address = get_effective_address(cpu, address, indirect);
-    cpu->memory_buffer = cpu->memory[cpu->memory_address];
+    cpu->memory_buffer = read_memory(cpu, cpu->memory_address);
 }
 
 void execute_instruction(PDP7_cpu* cpu, uint32_t instruction) {
+    execute_nested(cpu, instruction, cpu->model);
+}
+
+static inline __attribute__((always_inline)) void execute_model(PDP7_cpu* cpu, uint32_t instruction, const unsigned model) {
     switch (cpu->ir) {
         case OP_CAL:
             // Call subroutine and load accumulator
-            cpu->memory[cpu->memory_address] = cpu->pc;
-            cpu->pc = cpu->memory_address + 1;
-            cpu->accumulator = cpu->memory[cpu->memory_address];
-            cpu->cycles += 2;
+            REQUIRE_MODEL(CAL, TRAP_OPCODE);
+            write_memory(cpu, cpu->memory_address, cpu->pc);
+            cpu->pc = wrap_pc(cpu->memory_address + 1);
+            cpu->accumulator = read_memory(cpu, cpu->memory_address);
+            cpu->cycles += CYCLES_CAL;
             break;
         case OP_DAC:
             // Deposit accumulator into memory
-            cpu->memory[cpu->memory_address] = cpu->accumulator;
-            cpu->cycles += 2;
+            REQUIRE_MODEL(DAC, TRAP_OPCODE);
+            write_memory(cpu, cpu->memory_address, cpu->accumulator);
+            cpu->cycles += CYCLES_DAC;
             break;
         case OP_JMS:
             // Jump to subroutine
-            cpu->memory[cpu->memory_address] = cpu->pc + (cpu->link << 17);
-            cpu->pc = cpu->memory_address + 1 + program_start_address;
-            cpu->cycles += 2;
+            REQUIRE_MODEL(JMS, TRAP_OPCODE);
+            write_memory(cpu, cpu->memory_address, cpu->pc + (cpu->link << 17) + (cpu->extend_mode << 16));
+            cpu->pc = wrap_pc(cpu->memory_address + 1 + cpu->program_start_address);
+            cpu->cycles += CYCLES_JMS;
             break;
         case OP_DZM:
             // Deposit zero into memory
-            cpu->memory[cpu->memory_address] = 0;
-            cpu->cycles += 2;
+            REQUIRE_MODEL(DZM, TRAP_OPCODE);
+            write_memory(cpu, cpu->memory_address, 0);
+            cpu->cycles += CYCLES_DZM;
             break;
         case OP_LAC:
             // Load accumulator from memory
-            cpu->accumulator = cpu->memory[cpu->memory_address];
-            cpu->cycles += 2;
+            REQUIRE_MODEL(LAC, TRAP_OPCODE);
+            cpu->accumulator = read_memory(cpu, cpu->memory_address);
+            cpu->cycles += CYCLES_LAC;
             break;
         case OP_XOR:
             // Exclusive OR
-            cpu->accumulator ^= cpu->memory[cpu->memory_address];
-            cpu->cycles += 2;
+            REQUIRE_MODEL(XOR, TRAP_OPCODE);
+            cpu->accumulator ^= read_memory(cpu, cpu->memory_address);
+            cpu->cycles += CYCLES_XOR;
             break;
         case OP_ADD:
-            cpu->accumulator += cpu->memory[cpu->memory_address];
+            REQUIRE_MODEL(ADD, TRAP_OPCODE);
+            cpu->accumulator += read_memory(cpu, cpu->memory_address);
             cpu->link = cpu->accumulator >> 18; // Save carry in link
             cpu->accumulator = (cpu->accumulator + cpu->link) & 0777777;
             if (cpu->accumulator == 0777777) {
                 cpu->accumulator = 0;
             }
-            cpu->cycles += 2;
+            cpu->cycles += CYCLES_ADD;
             break;
         case OP_TAD:
-            cpu->accumulator += cpu->memory[cpu->memory_address];
+            REQUIRE_MODEL(TAD, TRAP_OPCODE);
+            cpu->accumulator += read_memory(cpu, cpu->memory_address);
             cpu->link = cpu->accumulator >> 18; // Save carry in link
             cpu->accumulator = (cpu->accumulator) & 0777777;
-            cpu->cycles += 2;
+            cpu->cycles += CYCLES_TAD;
             break;
         case OP_XCT:
             // Execute instruction
-            uint32_t next_instruction = cpu->memory[cpu->memory_address];
+            REQUIRE_MODEL(XCT, TRAP_OPCODE);
+            uint32_t next_instruction = read_memory(cpu, cpu->memory_address);
+            if (cpu->xct_depth == XCT_MAX_DEPTH) {
+                cpu_trap(cpu, TRAP_XCT_LOOP, instruction);
+                break;
+            }
+            cpu->xct_depth++;
             decode_instruction(cpu, next_instruction);
-            execute_instruction(cpu, next_instruction);
-            cpu->cycles += 1;
+            execute_nested(cpu, next_instruction, model);
+            cpu->xct_depth--;
+            cpu->cycles += CYCLES_XCT;
             break;
         case OP_ISZ:
             // Increment and skip if zero
-            cpu->memory[cpu->memory_address]++;
-            if (cpu->memory[cpu->memory_address] == 0) {
-                cpu->pc++;
+            REQUIRE_MODEL(ISZ, TRAP_OPCODE);
+            write_memory(cpu, cpu->memory_address, cpu->memory_buffer + 1);
+            if (read_memory(cpu, cpu->memory_address) == 0) {
+                cpu->pc = wrap_pc(cpu->pc + 1);
             }
-            cpu->cycles += 2;
+            cpu->cycles += CYCLES_ISZ;
             break;
         case OP_AND:
             // Logical AND with accumulator
-            cpu->accumulator &= cpu->memory[cpu->memory_address];
-            cpu->cycles += 2;
+            REQUIRE_MODEL(AND, TRAP_OPCODE);
+            cpu->accumulator &= read_memory(cpu, cpu->memory_address);
+            cpu->cycles += CYCLES_AND;
             break;
         case OP_SAD:
             // Skip on accumulator different
-            if (cpu->accumulator != cpu->memory[cpu->memory_address]) {
-                cpu->pc++;
+            REQUIRE_MODEL(SAD, TRAP_OPCODE);
+            if (cpu->accumulator != read_memory(cpu, cpu->memory_address)) {
+                cpu->pc = wrap_pc(cpu->pc + 1);
             }
-            cpu->cycles += 2;
+            cpu->cycles += CYCLES_SAD;
             break;
         case OP_JMP:
             // Jump
-            cpu->pc = cpu->memory_address + program_start_address;
-            cpu->cycles += 1;
+            REQUIRE_MODEL(JMP, TRAP_OPCODE);
+            cpu->pc = wrap_pc(cpu->memory_address + cpu->program_start_address);
+            cpu->cycles += CYCLES_JMP;
             break;
         case OP_IOT:
-            // Input/Output Transfer (stubbed)
+            // Input/Output Transfer: memory extension here, devices on the bus
+            REQUIRE_MODEL(IOT, TRAP_OPCODE);
             switch (instruction) {
-                case IOT_KRB:
-                    printf(">>> ");
-                    char input_char;
-                    scanf(" %c", &input_char);
-                    cpu->accumulator = (uint32_t)input_char;
+                case IOT_SEM:
+                    REQUIRE_MODEL(SEM, TRAP_IOT);
+                    if (cpu->extend_mode) {
+                        cpu->pc = wrap_pc(cpu->pc + 1);
+                    }
+                    break;
+                case IOT_EEM:
+                    REQUIRE_MODEL(EEM, TRAP_IOT);
+                    cpu->extend_mode = true;
                     break;
-                case IOT_TLS:
-                    while (*cpu->io_buffer != 0);
-                    *cpu->io_buffer = cpu->accumulator;
+                case IOT_LEM:
+                    REQUIRE_MODEL(LEM, TRAP_IOT);
+                    cpu->extend_mode = false;
                     break;
-                default: 
-                    fprintf(stderr, "Unknown I/O instruction: %o\n", cpu->ir);
-                    exit(1);
+                default:
+                    // Everything else goes to whichever device has the code
+                    if (!iot_dispatch(cpu->bus, cpu, instruction)) {
+                        cpu_trap(cpu, TRAP_IOT, instruction);
+                    }
             }
             break;
-        case OP_OPR:       
+        case OP_OPR:
+            REQUIRE_MODEL(OPR, TRAP_OPCODE);
             switch (instruction) {
                 case OP_OPR:
                     // No operation
-                    cpu->cycles += 3;
+                    cpu->cycles += CYCLES_OPR;
                     break;
                 case OPR_CMA:
                     // Complement AC
+                    REQUIRE_MODEL(CMA, TRAP_OPERATE);
                     cpu->accumulator = ~cpu->accumulator & 0777777;
-                    cpu->cycles += 3;
+                    cpu->cycles += CYCLES_CMA;
                     break;
                 case OPR_CML:
                     // Complement link
+                    REQUIRE_MODEL(CML, TRAP_OPERATE);
                     cpu->link = !cpu->link;
-                    cpu->cycles += 3;
+                    cpu->cycles += CYCLES_CML;
                     break;
                 case OPR_OAS:
                     // Inclusive OR AC switches
-                    cpu->accumulator |= cpu->memory[cpu->memory_address];
-                    cpu->cycles += 3;
+                    REQUIRE_MODEL(OAS, TRAP_OPERATE);
+                    cpu->accumulator |= read_memory(cpu, cpu->memory_address);
+                    cpu->cycles += CYCLES_OAS;
                     break;
                 case OPR_LAS:
                     // Load AC from switches
-                    cpu->accumulator = cpu->memory[cpu->memory_address];
-                    cpu->cycles += 2;
+                    REQUIRE_MODEL(LAS, TRAP_OPERATE);
+                    cpu->accumulator = read_memory(cpu, cpu->memory_address);
+                    cpu->cycles += CYCLES_LAS;
                     break;
                 case OPR_RAL:
                     // Rotate AC + link left one place
+                    REQUIRE_MODEL(RAL, TRAP_OPERATE);
                     {
                         uint32_t combined = (cpu->accumulator << 1) | cpu->link;
                         cpu->link = (combined >> 18) & 1;
                         cpu->accumulator = combined & 0x3FFFF;
-                        cpu->cycles += 3;
+                        cpu->cycles += CYCLES_RAL;
                     }
                     break;
                 case OPR_RCL:
                     // Clear link, then rotate left one place
+                    REQUIRE_MODEL(RCL, TRAP_OPERATE);
                     cpu->link = 0;
                     cpu->accumulator = (cpu->accumulator << 1) & 0x3FFFF;
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_RCL;
                     break;
                 case OPR_RTL:
                     // Rotate AC left twice
+                    REQUIRE_MODEL(RTL, TRAP_OPERATE);
                     {
                         uint32_t combined = (cpu->accumulator << 2) | (cpu->link << 1);
                         cpu->link = (combined >> 18) & 1;
                         cpu->accumulator = combined & 0x3FFFF;
-                        cpu->cycles += 2;
+                        cpu->cycles += CYCLES_RTL;
                     }
                     break;
                 case OPR_RAR:
                     // Rotate AC + link right one place
+                    REQUIRE_MODEL(RAR, TRAP_OPERATE);
                     {
                         uint32_t combined = (cpu->link << 18) | cpu->accumulator;
                         cpu->link = combined & 1;
                         cpu->accumulator = (combined >> 1) & 0x3FFFF;
-                        cpu->cycles += 2;
+                        cpu->cycles += CYCLES_RAR;
                     }
                     break;
                 case OPR_RCR:
                     // Clear link, then rotate right one place
+                    REQUIRE_MODEL(RCR, TRAP_OPERATE);
                     cpu->link = 0;
                     cpu->accumulator = (cpu->accumulator >> 1) & 0x3FFFF;
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_RCR;
                     break;
                 case OPR_RTR:
                     // Rotate AC right twice
+                    REQUIRE_MODEL(RTR, TRAP_OPERATE);
                     {
                         uint32_t combined = (cpu->link << 19) | (cpu->accumulator << 1);
                         cpu->link = (combined >> 18) & 1;
                         cpu->accumulator = (combined >> 2) & 0x3FFFF;
-                        cpu->cycles += 2;
+                        cpu->cycles += CYCLES_RTR;
                     }
                     break;
                 case OPR_HLT:
                     // Halt
+                    REQUIRE_MODEL(HLT, TRAP_OPERATE);
                     cpu->running = false;
-                    cpu->cycles += 4;
+                    cpu->cycles += CYCLES_HLT;
                     break;
                 case OPR_SZA:
                     // Skip on zero AC
+                    REQUIRE_MODEL(SZA, TRAP_OPERATE);
                     if (cpu->accumulator == 0) {
-                        cpu->pc++;
+                        cpu->pc = wrap_pc(cpu->pc + 1);
                     }
-                    cpu->cycles += 1;
+                    cpu->cycles += CYCLES_SZA;
                     break;
                 case OPR_SNA:
                     // Skip on non-zero AC
+                    REQUIRE_MODEL(SNA, TRAP_OPERATE);
                     if (cpu->accumulator != 0) {
-                        cpu->pc++;
+                        cpu->pc = wrap_pc(cpu->pc + 1);
                     }
-                    cpu->cycles += 1;
+                    cpu->cycles += CYCLES_SNA;
                     break;
                 case OPR_SPA:
                     // Skip on positive AC
+                    REQUIRE_MODEL(SPA, TRAP_OPERATE);
                     if ((cpu->accumulator & 0x20000) == 0) {
-                        cpu->pc++;
+                        cpu->pc = wrap_pc(cpu->pc + 1);
                     }
-                    cpu->cycles += 1;
+                    cpu->cycles += CYCLES_SPA;
                     break;
                 case OPR_SMA:
                     // Skip on negative AC
+                    REQUIRE_MODEL(SMA, TRAP_OPERATE);
                     if (cpu->accumulator & 0x20000) {
-                        cpu->pc++;
+                        cpu->pc = wrap_pc(cpu->pc + 1);
                     }
-                    cpu->cycles += 1;
+                    cpu->cycles += CYCLES_SMA;
                     break;
                 case OPR_SZL:
                     // Skip on zero link
+                    REQUIRE_MODEL(SZL, TRAP_OPERATE);
                     if (cpu->link == 0) {
-                        cpu->pc++;
+                        cpu->pc = wrap_pc(cpu->pc + 1);
                     }
-                    cpu->cycles += 1;
+                    cpu->cycles += CYCLES_SZL;
                     break;
                 case OPR_SNL:
                     // Skip on non-zero link
+                    REQUIRE_MODEL(SNL, TRAP_OPERATE);
                     if (cpu->link != 0) {
-                        cpu->pc++;
+                        cpu->pc = wrap_pc(cpu->pc + 1);
                     }
-                    cpu->cycles += 1;
+                    cpu->cycles += CYCLES_SNL;
                     break;
                 case OPR_SKP:
                     // Skip unconditionally
-                    cpu->pc++;
-                    cpu->cycles += 1;
+                    REQUIRE_MODEL(SKP, TRAP_OPERATE);
+                    cpu->pc = wrap_pc(cpu->pc + 1);
+                    cpu->cycles += CYCLES_SKP;
                     break;
                 case OPR_CLL:
                     // Clear link
+                    REQUIRE_MODEL(CLL, TRAP_OPERATE);
                     cpu->link = 0;
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_CLL;
                     break;
                 case OPR_STL:
                     // Set the link
+                    REQUIRE_MODEL(STL, TRAP_OPERATE);
                     cpu->link = 1;
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_STL;
                     break;
                 case OPR_CLA:
                     // Clear AC
+                    REQUIRE_MODEL(CLA, TRAP_OPERATE);
                     cpu->accumulator = 0;
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_CLA;
                     break;
                 case OPR_CLC:
                     // Clear and complement AC
+                    REQUIRE_MODEL(CLC, TRAP_OPERATE);
                     cpu->accumulator = 0x3FFFF;
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_CLC;
                     break;
                 case OPR_GLK:
                     // Get link
+                    REQUIRE_MODEL(GLK, TRAP_OPERATE);
                     cpu->accumulator = (cpu->accumulator & 0x1FFFF) | (cpu->link << 17);
-                    cpu->cycles += 2;
+                    cpu->cycles += CYCLES_GLK;
                     break;
                 default:
-                    fprintf(stderr, "Unknown operate instruction: %o\n", instruction);
-                    exit(1);
+                    cpu_trap(cpu, TRAP_OPERATE, instruction);
             }
             break;
         default:
-            fprintf(stderr, "Unknown opcode: %o\n", cpu->ir);
-            exit(1);
+            cpu_trap(cpu, TRAP_OPCODE, instruction);
     }
 }
 
+// A fully specialized interpreter per model, from the one body above
+#define DEFINE_MODEL_LOOPS(name, model) \
+    void execute_##name(PDP7_cpu* cpu, uint32_t instruction) { \
+        execute_model(cpu, instruction, model); \
+    } \
+    void step_##name(PDP7_cpu* cpu) { \
+        cycle_model(cpu, model); \
+    } \
+    uint64_t run_##name##_instructions(PDP7_cpu* cpu, uint64_t count) { \
+        uint64_t instructions = 0; \
+        while (cpu->running && instructions < count) { \
+            cycle_model(cpu, model); \
+            instructions++; \
+        } \
+        return instructions; \
+    }
+
+PDP7_MODELS(DEFINE_MODEL_LOOPS)
+
 void print_memory(const PDP7_cpu *cpu, uint32_t start, uint32_t end) {
     if (start >= MEMORY_SIZE || end >= MEMORY_SIZE || start > end) {
         printf("Invalid memory bounds\n");
@@ -521,7 +958,7 @@ void print_memory(const PDP7_cpu *cpu, uint32_t start, uint32_t end) {
         for (uint32_t col = 0; col < 8; ++col) {
             uint32_t current_addr = addr + col;
             if (current_addr >= start && current_addr <= end) {
-                printf("%0*" PRIo32 " ", 6, cpu->memory[current_addr]);
+                printf("%0*" PRIo32 " ", 6, read_memory(cpu, current_addr));
             } else {
                 printf("%*s ", 8, " ");  // Print spaces for out-of-bound addresses
             }
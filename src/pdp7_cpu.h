@@ -2,28 +2,82 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include "pdp7_isa.h"
 
 // Constants
-#define MEMORY_SIZE 8192 // PDP-7 has 13-bit addressing, giving 8K words of memory
+#define MEMORY_SIZE 32768 // Four 8K banks with the extended memory option (15-bit addresses)
+#define BANK_SIZE 8192 // Instructions address 13 bits, within the current bank
+#define BANK_MASK (MEMORY_SIZE - BANK_SIZE)
+#define XCT_MAX_DEPTH 64 // Nested XCTs before the chain counts as a loop
 #define INSTRUCTION_START 02000 // Start of instruction memory (octal 2000)
+#define MEMORY_PAGE_WORDS 256 // Unit of lazy allocation and dirty tracking
+#define MEMORY_PAGES (MEMORY_SIZE / MEMORY_PAGE_WORDS)
 
+// Why the machine stopped on something it cannot execute
+typedef enum {
+    TRAP_NONE,
+    TRAP_OPCODE,     // Unknown opcode
+    TRAP_OPERATE,    // Unknown OPR microinstruction
+    TRAP_IOT,        // IOT for no known device
+    TRAP_XCT_LOOP,   // XCT chain deeper than XCT_MAX_DEPTH, hangs a real machine
+} cpu_trap_kind;
+
+struct block_storage;
+struct keyboard_device;
+struct guest_profiler;
+struct trace_buffer;
+struct live_metrics;
+struct lockstep_checker;
+struct serial_line;
+struct memory_heatmap;
+struct iot_bus;
+
+// Laid out by how often the run loop touches things: the registers fill
+// the first cache line, the hooks tested on every instruction the second,
+// and the page table and devices come after.
 typedef struct {
+    _Alignas(64) uint32_t pc;        // Program Counter (15-bit)
     uint32_t accumulator;            // Accumulator (18-bit)
-    uint32_t memory_address;         // Memory Address (13-bit)
+    uint32_t memory_address;         // Memory Address (15-bit)
     uint32_t memory_buffer;          // Memory Buffer (18-bit)
-    uint32_t memory[MEMORY_SIZE];    // Memory array (18-bit words)
-    uint32_t pc;                     // Program Counter (13-bit)
-    uint32_t* io_buffer;             // I/O Buffer addr
+    uint64_t cycles;                 // Cycle counter
+    uint32_t program_start_address;  // Relocation JMP and JMS add to their targets
     uint8_t ir;                      // Instruction Register (4-bit)
+    uint8_t xct_depth;               // XCTs currently being executed
+    uint8_t model;                   // MODEL_* bit, picks the interpreter perform_cycle runs
     bool link;                       // Link Register (1-bit)
-    uint64_t cycles;                 // Cycle counter
+    bool extend_mode;                // Indirect addresses are 15 bits (EEM/LEM)
     bool running;                    // CPU running state
+    cpu_trap_kind trap;              // Set with running cleared on an unexecutable word
+    uint32_t trap_pc;                // Address of the trapping instruction
+    uint32_t trap_instruction;       // The word itself
+    uint32_t* memory;                // Arena for the machine's own pages, NULL until the first store
+
+    _Alignas(64) struct memory_heatmap* heatmap; // Per-word access counters for the heatmap view (NULL when off)
+    struct trace_buffer* trace;      // Execution trace ring (NULL when not tracing)
+    struct live_metrics* metrics;    // Shared memory counters (NULL when not published)
+    struct guest_profiler* profiler; // Guest profiler (NULL when not profiling)
+    const struct iot_bus* bus;       // Devices by IOT device code
+    uint32_t* io_buffer;             // I/O Buffer addr
+    atomic_bool* attention;          // Raised when another thread needs the run loop back
+    struct lockstep_checker* lockstep; // Differential check against another engine (NULL when off)
+
+    uint32_t* pages[MEMORY_PAGES];   // Page table: own pages in `memory`, shared ones, or memory_zero_page
+    uint8_t dirty[MEMORY_PAGES];     // Pages written since the flags were last cleared
+    struct block_storage* storage;   // Block storage device (NULL if not attached)
+    struct keyboard_device* keyboard; // Keyboard device (NULL if not attached)
+    struct serial_line* line_in;     // Serial line read by KSF/KRB instead of the keyboard (NULL if none)
+    struct serial_line* line_out;    // Serial line TLS sends on instead of the display (NULL if none)
 } PDP7_cpu;
 
+struct gdb_stub;
+
 typedef struct {
-    PDP7_cpu cpu;
+    PDP7_cpu* cpu;
     bool debug;
     bool headless;
+    struct gdb_stub* gdb;            // Remote debugger for headless runs (NULL when off)
 } PDP7_cpu_options;
 
 void* run_cpu(void* arg);
@@ -31,4 +85,62 @@ void initialize_cpu(PDP7_cpu *cpu, const char* program_file, const char* memory_
 void load_memory_from_file(PDP7_cpu *cpu, const char *filename, uint32_t start_address);
 void decode_instruction(PDP7_cpu* cpu, uint32_t instruction);
 void execute_instruction(PDP7_cpu* cpu, uint32_t instruction);
-uint32_t get_effective_address(PDP7_cpu* cpu, uint32_t address, bool indirect);
\ No newline at end of file
+void perform_cycle(PDP7_cpu* cpu);
+void cpu_trap(PDP7_cpu* cpu, cpu_trap_kind kind, uint32_t instruction);
+void print_trap(const PDP7_cpu* cpu);
+void print_cpu_state(const PDP7_cpu* cpu);
+void report_halt(PDP7_cpu* cpu);
+uint64_t run_cycles(PDP7_cpu* cpu, uint64_t budget);
+uint64_t run_instructions(PDP7_cpu* cpu, uint64_t count);
+
+// Each model's specialized interpreter: execute_pdp7, step_pdp7, run_pdp7_instructions, ...
+#define DECLARE_MODEL_LOOPS(name, model) \
+    void execute_##name(PDP7_cpu* cpu, uint32_t instruction); \
+    void step_##name(PDP7_cpu* cpu); \
+    uint64_t run_##name##_instructions(PDP7_cpu* cpu, uint64_t count);
+PDP7_MODELS(DECLARE_MODEL_LOOPS)
+
+uint32_t get_effective_address(PDP7_cpu* cpu, uint32_t address, bool indirect);
+uint32_t resolve_address(const PDP7_cpu* cpu, uint32_t address, bool indirect);
+void initialize_memory(PDP7_cpu* cpu);
+void free_memory(PDP7_cpu* cpu);
+uint32_t* allocate_page(PDP7_cpu* cpu, uint32_t page);
+void copy_page(PDP7_cpu* destination, const PDP7_cpu* source, uint32_t page);
+void copy_memory(PDP7_cpu* destination, const PDP7_cpu* source);
+void copy_cpu(PDP7_cpu* destination, const PDP7_cpu* source);
+void restore_cpu(PDP7_cpu* cpu, const PDP7_cpu* base);
+void share_memory(PDP7_cpu* cpu, const PDP7_cpu* image);
+uint32_t allocated_pages(const PDP7_cpu* cpu);
+void read_memory_range(const PDP7_cpu* cpu, uint32_t address, uint32_t* words, uint32_t count);
+void write_memory_range(PDP7_cpu* cpu, uint32_t address, const uint32_t* words, uint32_t count);
+
+extern uint32_t memory_zero_page[MEMORY_PAGE_WORDS];
+
+// The PC is 15 bits: it wraps around the top of memory like addresses do
+static inline uint32_t wrap_pc(uint32_t pc) {
+    return pc & (MEMORY_SIZE - 1);
+}
+
+// True when `page` lives in the machine's own arena and may be written.
+// Compared as integers, `memory` is NULL before the first store.
+static inline bool page_is_private(const PDP7_cpu* cpu, uint32_t page) {
+    return (uintptr_t)cpu->pages[page] == (uintptr_t)cpu->memory + page * MEMORY_PAGE_WORDS * sizeof(uint32_t);
+}
+
+static inline uint32_t read_memory(const PDP7_cpu* cpu, uint32_t address) {
+    address &= MEMORY_SIZE - 1;
+    return cpu->pages[address / MEMORY_PAGE_WORDS][address % MEMORY_PAGE_WORDS];
+}
+
+// Every store to guest memory goes through here so written pages are known.
+// The first store to a zero or shared page gives it storage of its own.
+static inline void write_memory(PDP7_cpu* cpu, uint32_t address, uint32_t word) {
+    address &= MEMORY_SIZE - 1;
+    uint32_t page = address / MEMORY_PAGE_WORDS;
+    uint32_t* words = cpu->pages[page];
+    if (!page_is_private(cpu, page)) {
+        words = allocate_page(cpu, page);
+    }
+    words[address % MEMORY_PAGE_WORDS] = word;
+    cpu->dirty[page] = 1;
+}
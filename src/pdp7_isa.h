@@ -0,0 +1,84 @@
+#pragma once
+
+// Machine models, as bits so an instruction can list the ones that have it
+#define MODEL_PDP4 1
+#define MODEL_PDP7 2
+#define MODEL_PDP9 4
+#define MODEL_ALL (MODEL_PDP4 | MODEL_PDP7 | MODEL_PDP9)
+#define MODEL_EXTENDED_MEMORY (MODEL_PDP7 | MODEL_PDP9) // 32K with the memory extension control
+
+// X(name, model bit). Each model gets its own interpreter loop and engine.
+#define PDP7_MODELS(X) \
+    X(pdp4, MODEL_PDP4) \
+    X(pdp7, MODEL_PDP7) \
+    X(pdp9, MODEL_PDP9)
+
+// The instruction set, one table each for opcodes, operate microinstructions
+// and the IOTs the CPU handles itself: X(name, octal word, cycles, models).
+// Everything else, the OP_/OPR_/IOT_ constants, the interpreter's cycle
+// costs and model checks, the disassembler's names, is generated from here.
+
+// Opcodes, cycles of OPR are those of a NOP
+#define PDP7_OPCODES(X) \
+    X(CAL, 000, 2, MODEL_ALL) /* Call subroutine and load accumulator */ \
+    X(DAC, 004, 2, MODEL_ALL) /* Deposit accumulator into memory */ \
+    X(JMS, 010, 2, MODEL_ALL) /* Jump to subroutine */ \
+    X(DZM, 014, 2, MODEL_ALL) /* Deposit zero into memory */ \
+    X(LAC, 020, 2, MODEL_ALL) /* Load accumulator from memory */ \
+    X(XOR, 024, 2, MODEL_ALL) /* Exclusive OR */ \
+    X(ADD, 030, 2, MODEL_ALL) /* Add to accumulator */ \
+    X(TAD, 034, 2, MODEL_ALL) /* Two's complement add to accumulator */ \
+    X(XCT, 040, 1, MODEL_ALL) /* Execute instruction */ \
+    X(ISZ, 044, 2, MODEL_ALL) /* Increment and skip if zero */ \
+    X(AND, 050, 2, MODEL_ALL) /* Logical AND with accumulator */ \
+    X(SAD, 054, 2, MODEL_ALL) /* Skip on accumulator different */ \
+    X(JMP, 060, 1, MODEL_ALL) /* Jump */ \
+    X(IOT, 070, 0, MODEL_ALL) /* Input/Output Transfer */ \
+    X(OPR, 074, 3, MODEL_ALL) /* Operate */
+
+// Operate instructions
+#define PDP7_OPERATES(X) \
+    X(CMA, 0740001, 3, MODEL_ALL) /* Complement AC */ \
+    X(CML, 0740002, 3, MODEL_ALL) /* Complement link */ \
+    X(OAS, 0740004, 3, MODEL_ALL) /* Inclusive OR AC switches */ \
+    X(LAS, 0750004, 2, MODEL_ALL) /* Load AC from switches */ \
+    X(RAL, 0740010, 3, MODEL_ALL) /* Rotate AC + link left one place */ \
+    X(RCL, 0744010, 2, MODEL_ALL) /* Clear link, then rotate left one place */ \
+    X(RTL, 0742010, 2, MODEL_ALL) /* Rotate AC left twice */ \
+    X(RAR, 0740020, 2, MODEL_ALL) /* Rotate AC + link right one place */ \
+    X(RCR, 0744020, 2, MODEL_ALL) /* Clear link, then rotate right one place */ \
+    X(RTR, 0742020, 2, MODEL_ALL) /* Rotate AC right twice */ \
+    X(HLT, 0740040, 4, MODEL_ALL) /* Halt */ \
+    X(SZA, 0740200, 1, MODEL_ALL) /* Skip on zero AC */ \
+    X(SNA, 0741200, 1, MODEL_ALL) /* Skip on non-zero AC */ \
+    X(SPA, 0741100, 1, MODEL_ALL) /* Skip on positive AC */ \
+    X(SMA, 0740100, 1, MODEL_ALL) /* Skip on negative AC */ \
+    X(SZL, 0741400, 1, MODEL_ALL) /* Skip on zero link */ \
+    X(SNL, 0740400, 1, MODEL_ALL) /* Skip on non-zero link */ \
+    X(SKP, 0471000, 1, MODEL_ALL) /* Skip unconditionally */ \
+    X(CLL, 0744000, 2, MODEL_ALL) /* Clear link */ \
+    X(STL, 0744002, 2, MODEL_ALL) /* Set the link */ \
+    X(CLA, 0750000, 2, MODEL_ALL) /* Clear AC */ \
+    X(CLC, 0750001, 2, MODEL_ALL) /* Clear and complement AC */ \
+    X(GLK, 0750020, 2, MODEL_ALL) /* Get link */
+
+// I/O instructions of the CPU itself, devices are on the IOT bus (iot_bus.h)
+#define PDP7_IOTS(X) \
+    X(SEM, 0707701, 0, MODEL_EXTENDED_MEMORY) /* Skip if extend mode */ \
+    X(EEM, 0707702, 0, MODEL_EXTENDED_MEMORY) /* Enter extend mode */ \
+    X(LEM, 0707704, 0, MODEL_EXTENDED_MEMORY) /* Leave extend mode */
+
+#define ISA_OPCODE(name, word, cycles, models) OP_##name = word, CYCLES_##name = cycles, MODELS_##name = models,
+#define ISA_OPERATE(name, word, cycles, models) OPR_##name = word, CYCLES_##name = cycles, MODELS_##name = models,
+#define ISA_IOT(name, word, cycles, models) IOT_##name = word, CYCLES_##name = cycles, MODELS_##name = models,
+
+enum {
+    PDP7_OPCODES(ISA_OPCODE)
+    PDP7_OPERATES(ISA_OPERATE)
+    PDP7_IOTS(ISA_IOT)
+};
+
+#define OP_EAE  077 // Extended arithmetic element (stubbed)
+
+// True when `model` has the instruction `name` (CAL, CMA, EEM, ...)
+#define MODEL_HAS(model, name) (((model) & MODELS_##name) != 0)
@@ -0,0 +1,287 @@
+#include "profiler.h"
+#include "disassembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define PROFILER_REPORT_ROWS 64
+#define PROFILER_INDEX_SIZE (2 * PROFILER_MAX_FRAMES)
+
+int32_t profiler_find_frame(guest_profiler* profiler, int32_t parent, uint32_t address);
+const char* profiler_label(const guest_profiler* profiler, uint32_t address, uint32_t* offset);
+void profiler_frame_name(const guest_profiler* profiler, uint32_t address, char* name, size_t size);
+void profiler_write_folded(guest_profiler* profiler, FILE* file);
+int compare_hotness(const void* a, const void* b);
+
+static const uint64_t* hotness_cycles;
+
+guest_profiler* create_profiler(const char* report_file, uint32_t start_address) {
+    guest_profiler* profiler = calloc(1, sizeof(guest_profiler));
+    if (!profiler) {
+        printf("Failed to allocate profiler\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < PROFILER_INDEX_SIZE; i++) {
+        profiler->frame_index[i] = -1;
+    }
+
+    // The root frame stands for the code entered at the start address
+    profiler->frames[0].address = start_address;
+    profiler->frames[0].parent = -1;
+    profiler->frame_count = 1;
+    profiler->stack[0] = 0;
+    profiler->depth = 0;
+    profiler->report_file = report_file;
+
+    return profiler;
+}
+
+void destroy_profiler(guest_profiler* profiler) {
+    for (int i = 0; i < MEMORY_SIZE; i++) {
+        free(profiler->labels[i]);
+        free(profiler->comments[i]);
+    }
+    free(profiler);
+}
+
+static char* trim(char* text) {
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    size_t length = strlen(text);
+    while (length > 0 && (text[length - 1] == ' ' || text[length - 1] == '\t')) {
+        text[--length] = '\0';
+    }
+    return text;
+}
+
+// Reads the `//` comments of a .dat file. A comment on a line of its own
+// labels the next word loaded (up to a " - " description), a trailing
+// comment annotates the word on that line.
+void profiler_load_labels(guest_profiler* profiler, const char* filename, uint32_t start_address) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        printf("Failed to open file %s\n", filename);
+        exit(1);
+    }
+
+    char line[256];
+    char pending_label[256] = "";
+    uint32_t address, word;
+
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char* comment = NULL;
+        char* comment_start = strstr(line, "//");
+        if (comment_start) {
+            *comment_start = '\0';
+            comment = trim(comment_start + 2);
+        }
+
+        if (sscanf(line, "%o %o", &address, &word) != 2) {
+            if (comment && strlen(trim(line)) == 0) {
+                char* separator = strstr(comment, " - ");
+                if (separator) {
+                    *separator = '\0';
+                }
+                snprintf(pending_label, sizeof(pending_label), "%s", trim(comment));
+            }
+            continue;
+        }
+
+        uint32_t location = start_address + address;
+        if (location >= MEMORY_SIZE) {
+            continue;
+        }
+
+        if (pending_label[0] != '\0') {
+            free(profiler->labels[location]);
+            profiler->labels[location] = strdup(pending_label);
+            pending_label[0] = '\0';
+        }
+        if (comment && comment[0] != '\0') {
+            free(profiler->comments[location]);
+            profiler->comments[location] = strdup(comment);
+        }
+    }
+
+    fclose(file);
+}
+
+int32_t profiler_find_frame(guest_profiler* profiler, int32_t parent, uint32_t address) {
+    uint32_t slot = ((uint32_t)parent * 2654435761u ^ address) & (PROFILER_INDEX_SIZE - 1);
+
+    while (profiler->frame_index[slot] >= 0) {
+        profiler_frame* frame = &profiler->frames[profiler->frame_index[slot]];
+        if (frame->parent == parent && frame->address == address) {
+            return profiler->frame_index[slot];
+        }
+        slot = (slot + 1) & (PROFILER_INDEX_SIZE - 1);
+    }
+
+    if (profiler->frame_count == PROFILER_MAX_FRAMES) {
+        return parent; // Tree is full, charge the caller instead
+    }
+
+    int32_t index = profiler->frame_count++;
+    profiler->frames[index].address = address;
+    profiler->frames[index].parent = parent;
+    profiler->frames[index].cycles = 0;
+    profiler->frame_index[slot] = index;
+    return index;
+}
+
+// JMS pushes a frame for the subroutine entered. A JMP landing on the
+// saved return address (or the word after it, for skip returns) pops it.
+void profiler_track_call(guest_profiler* profiler, uint32_t pc, uint32_t instruction, uint32_t next_pc) {
+    uint32_t opcode = (instruction >> 14) & 017;
+
+    if (opcode == 002) {
+        if (profiler->depth + 1 == PROFILER_MAX_DEPTH) {
+            return;
+        }
+        int32_t frame = profiler_find_frame(profiler, profiler->stack[profiler->depth], next_pc);
+        profiler->depth++;
+        profiler->stack[profiler->depth] = frame;
+        profiler->return_address[profiler->depth] = pc + 1;
+    } else if (profiler->depth > 0) {
+        uint32_t return_address = profiler->return_address[profiler->depth];
+        if (next_pc == return_address || next_pc == return_address + 1) {
+            profiler->depth--;
+        }
+    }
+}
+
+const char* profiler_label(const guest_profiler* profiler, uint32_t address, uint32_t* offset) {
+    for (uint32_t location = address + 1; location-- > 0;) {
+        if (profiler->labels[location]) {
+            *offset = address - location;
+            return profiler->labels[location];
+        }
+    }
+    *offset = 0;
+    return NULL;
+}
+
+void profiler_frame_name(const guest_profiler* profiler, uint32_t address, char* name, size_t size) {
+    if (profiler->labels[address]) {
+        snprintf(name, size, "%s", profiler->labels[address]);
+    } else {
+        snprintf(name, size, "%05" PRIo32, address);
+    }
+
+    // Collapsed stack format splits on ';' and the count on the last space
+    for (char* c = name; *c != '\0'; c++) {
+        if (*c == ' ' || *c == ';') {
+            *c = '_';
+        }
+    }
+}
+
+int compare_hotness(const void* a, const void* b) {
+    uint64_t cycles_a = hotness_cycles[*(const uint32_t*)a];
+    uint64_t cycles_b = hotness_cycles[*(const uint32_t*)b];
+
+    if (cycles_a != cycles_b) {
+        return cycles_a < cycles_b ? 1 : -1;
+    }
+    return (int)*(const uint32_t*)a - (int)*(const uint32_t*)b;
+}
+
+void profiler_write_folded(guest_profiler* profiler, FILE* file) {
+    char path[PROFILER_MAX_DEPTH * 64];
+    char name[64];
+    int32_t chain[PROFILER_MAX_DEPTH + 1];
+
+    for (uint32_t i = 0; i < profiler->frame_count; i++) {
+        if (profiler->frames[i].cycles == 0) {
+            continue;
+        }
+
+        int depth = 0;
+        for (int32_t frame = i; frame >= 0 && depth <= PROFILER_MAX_DEPTH; frame = profiler->frames[frame].parent) {
+            chain[depth++] = frame;
+        }
+
+        path[0] = '\0';
+        size_t length = 0;
+        while (depth-- > 0) {
+            profiler_frame_name(profiler, profiler->frames[chain[depth]].address, name, sizeof(name));
+            length += snprintf(path + length, sizeof(path) - length, "%s%s", length ? ";" : "", name);
+            if (length >= sizeof(path)) {
+                length = sizeof(path) - 1;
+            }
+        }
+
+        fprintf(file, "%s %" PRIu64 "\n", path, profiler->frames[i].cycles);
+    }
+}
+
+void profiler_write_report(guest_profiler* profiler) {
+    FILE* file = fopen(profiler->report_file, "w");
+    if (!file) {
+        printf("Failed to open profile report %s\n", profiler->report_file);
+        return;
+    }
+
+    uint32_t hot[MEMORY_SIZE];
+    uint32_t hot_count = 0;
+    uint64_t total_count = 0, total_cycles = 0;
+
+    for (uint32_t address = 0; address < MEMORY_SIZE; address++) {
+        if (profiler->count[address] != 0) {
+            hot[hot_count++] = address;
+            total_count += profiler->count[address];
+            total_cycles += profiler->cycles[address];
+        }
+    }
+    hotness_cycles = profiler->cycles;
+    qsort(hot, hot_count, sizeof(uint32_t), compare_hotness);
+
+    fprintf(file, "PDP-7 guest profile\n");
+    fprintf(file, "Instructions: %" PRIu64 "  Cycles: %" PRIu64 "\n\n", total_count, total_cycles);
+
+    fprintf(file, "Opcode %12s %12s\n", "Count", "Cycles");
+    for (int opcode = 0; opcode < PROFILER_OPCODES; opcode++) {
+        if (profiler->opcode_count[opcode] != 0) {
+            fprintf(file, "%-6s %12" PRIu64 " %12" PRIu64 "\n", opcode_name((uint32_t)opcode << 14),
+                    profiler->opcode_count[opcode], profiler->opcode_cycles[opcode]);
+        }
+    }
+
+    fprintf(file, "\n%-6s %12s %12s %6s %12s  %s\n", "Addr", "Count", "Cycles", "%", "Taken", "Label | Source");
+    for (uint32_t i = 0; i < hot_count && i < PROFILER_REPORT_ROWS; i++) {
+        uint32_t address = hot[i];
+        uint32_t offset;
+        const char* label = profiler_label(profiler, address, &offset);
+        const char* comment = profiler->comments[address];
+
+        fprintf(file, "%05" PRIo32 "  %12" PRIu64 " %12" PRIu64 " %6.2f %12" PRIu64 "  ",
+                address, profiler->count[address], profiler->cycles[address],
+                total_cycles ? 100.0 * profiler->cycles[address] / total_cycles : 0.0,
+                profiler->taken[address]);
+        if (label && offset) {
+            fprintf(file, "%s+%" PRIo32, label, offset);
+        } else if (label) {
+            fprintf(file, "%s", label);
+        }
+        fprintf(file, "%s%s\n", comment ? " | " : "", comment ? comment : "");
+    }
+
+    fclose(file);
+
+    char folded_file[512];
+    snprintf(folded_file, sizeof(folded_file), "%s.folded", profiler->report_file);
+    file = fopen(folded_file, "w");
+    if (!file) {
+        printf("Failed to open collapsed stacks %s\n", folded_file);
+        return;
+    }
+    profiler_write_folded(profiler, file);
+    fclose(file);
+
+    printf("Profile written to %s and %s\n", profiler->report_file, folded_file);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PROFILER_OPCODES 16
+#define PROFILER_MAX_DEPTH 64
+#define PROFILER_MAX_FRAMES 4096
+
+// A node in the call tree, one per distinct (caller, subroutine) pair
+typedef struct {
+    uint32_t address;            // Subroutine entry point
+    int32_t parent;              // Caller node (-1 for the root)
+    uint64_t cycles;             // Cycles spent with this node on top of the stack
+} profiler_frame;
+
+typedef struct guest_profiler {
+    // Flat per-address counters, indexed by PC
+    uint64_t count[MEMORY_SIZE];
+    uint64_t cycles[MEMORY_SIZE];
+    uint64_t taken[MEMORY_SIZE];
+
+    // Per-opcode totals, indexed by the top four bits of the instruction
+    uint64_t opcode_count[PROFILER_OPCODES];
+    uint64_t opcode_cycles[PROFILER_OPCODES];
+
+    // Call tree (JMS is a call) for collapsed-stack output
+    profiler_frame frames[PROFILER_MAX_FRAMES];
+    int32_t frame_index[2 * PROFILER_MAX_FRAMES]; // Open addressing table into frames
+    uint32_t frame_count;
+    int32_t stack[PROFILER_MAX_DEPTH];
+    uint32_t return_address[PROFILER_MAX_DEPTH];
+    uint32_t depth;
+
+    // Annotations taken from the `//` comments of the loaded .dat files
+    char* labels[MEMORY_SIZE];   // Standalone comment naming the code that follows
+    char* comments[MEMORY_SIZE]; // Comment on the line of the word itself
+
+    const char* report_file;
+} guest_profiler;
+
+guest_profiler* create_profiler(const char* report_file, uint32_t start_address);
+void destroy_profiler(guest_profiler* profiler);
+void profiler_load_labels(guest_profiler* profiler, const char* filename, uint32_t start_address);
+void profiler_track_call(guest_profiler* profiler, uint32_t pc, uint32_t instruction, uint32_t next_pc);
+void profiler_write_report(guest_profiler* profiler);
+
+// Called after every instruction while profiling. Only JMS/JMP leave the
+// fast path, to keep the call tree in step with the guest.
+static inline void profiler_record(guest_profiler* profiler, uint32_t pc, uint32_t instruction, uint32_t next_pc, uint64_t cycles) {
+    uint32_t opcode = (instruction >> 14) & 017;
+
+    profiler->count[pc]++;
+    profiler->cycles[pc] += cycles;
+    profiler->taken[pc] += next_pc != pc + 1;
+    profiler->opcode_count[opcode]++;
+    profiler->opcode_cycles[opcode] += cycles;
+    profiler->frames[profiler->stack[profiler->depth]].cycles += cycles;
+
+    if (opcode == 002 || opcode == 014) {
+        profiler_track_call(profiler, pc, instruction, next_pc);
+    }
+}
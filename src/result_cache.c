@@ -0,0 +1,309 @@
+#include "result_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define RESULT_CACHE_MAGIC 0x37504443 // "CDP7"
+#define CACHE_HASH_PRIME 0x100000001b3ULL
+#define CACHE_HASH_GOLDEN 0x9e3779b97f4a7c15ULL
+#define CACHE_INDEX_BYTES (sizeof(cache_header) + RESULT_CACHE_SLOTS * sizeof(cache_slot))
+#define CACHE_READ_CHUNK 65536
+
+// On disk in the results file, followed by the changes and the output words
+typedef struct {
+    cache_key key;
+    uint64_t cycles;
+    uint32_t accumulator;
+    uint32_t pc;
+    uint32_t link;
+    uint32_t extend_mode;
+    uint32_t running;
+    uint32_t trap;
+    uint32_t trap_pc;
+    uint32_t trap_instruction;
+    uint32_t change_count;
+    uint32_t output_count;
+} cache_record;
+
+void hash_word(cache_key* key, uint32_t word);
+cache_key finish_key(cache_key key);
+cache_key build_key(void);
+void reset_store(result_cache* cache);
+cache_slot* find_slot(result_cache* cache, cache_key key);
+bool keys_equal(cache_key a, cache_key b);
+
+result_cache* open_result_cache(const char* directory, uint64_t max_bytes) {
+    char path[4096];
+
+    if (mkdir(directory, 0755) < 0 && errno != EEXIST) {
+        fprintf(stderr, "Failed to create result cache %s\n", directory);
+        exit(1);
+    }
+
+    result_cache* cache = calloc(1, sizeof(result_cache));
+    if (!cache) {
+        fprintf(stderr, "Failed to allocate the result cache\n");
+        exit(1);
+    }
+    cache->max_bytes = max_bytes ? max_bytes : RESULT_CACHE_DEFAULT_BYTES;
+    cache->build = build_key();
+
+    snprintf(path, sizeof(path), "%s/index", directory);
+    cache->index_fd = open(path, O_RDWR | O_CREAT, 0644);
+    snprintf(path, sizeof(path), "%s/results", directory);
+    cache->results_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (cache->index_fd < 0 || cache->results_fd < 0) {
+        fprintf(stderr, "Failed to open result cache %s\n", directory);
+        exit(1);
+    }
+
+    flock(cache->index_fd, LOCK_EX);
+    struct stat index_stat;
+    if (fstat(cache->index_fd, &index_stat) < 0 ||
+        ((size_t)index_stat.st_size < CACHE_INDEX_BYTES && ftruncate(cache->index_fd, CACHE_INDEX_BYTES) < 0)) {
+        fprintf(stderr, "Failed to size result cache index %s\n", path);
+        exit(1);
+    }
+
+    void* index = mmap(NULL, CACHE_INDEX_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, cache->index_fd, 0);
+    if (index == MAP_FAILED) {
+        fprintf(stderr, "Failed to map result cache index of %s\n", directory);
+        exit(1);
+    }
+    cache->header = index;
+    cache->slots = (cache_slot*)(cache->header + 1);
+
+    if (cache->header->magic != RESULT_CACHE_MAGIC || cache->header->version != RESULT_CACHE_VERSION ||
+        !keys_equal(cache->header->build, cache->build)) {
+        reset_store(cache);
+    }
+    flock(cache->index_fd, LOCK_UN);
+
+    return cache;
+}
+
+void close_result_cache(result_cache* cache) {
+    munmap(cache->header, CACHE_INDEX_BYTES);
+    close(cache->index_fd);
+    close(cache->results_fd);
+    free(cache);
+}
+
+void clear_result_cache(result_cache* cache) {
+    flock(cache->index_fd, LOCK_EX);
+    reset_store(cache);
+    flock(cache->index_fd, LOCK_UN);
+}
+
+// Caller holds the index lock exclusively
+void reset_store(result_cache* cache) {
+    uint64_t generation = cache->header->magic == RESULT_CACHE_MAGIC ? cache->header->generation + 1 : 0;
+
+    memset(cache->slots, 0, RESULT_CACHE_SLOTS * sizeof(cache_slot));
+    cache->header->magic = RESULT_CACHE_MAGIC;
+    cache->header->version = RESULT_CACHE_VERSION;
+    cache->header->build = cache->build;
+    cache->header->entries = 0;
+    cache->header->bytes = 0;
+    cache->header->generation = generation;
+    if (ftruncate(cache->results_fd, 0) < 0) {
+        fprintf(stderr, "Failed to clear the result cache\n");
+        exit(1);
+    }
+}
+
+// Two multiply-xor lanes, mixed together at the end
+void hash_word(cache_key* key, uint32_t word) {
+    key->high = (key->high ^ word) * CACHE_HASH_PRIME;
+    key->low = ((key->low ^ word) << 27 | (key->low ^ word) >> 37) * CACHE_HASH_GOLDEN;
+}
+
+cache_key finish_key(cache_key key) {
+    uint64_t high = key.high ^ key.low >> 31;
+    uint64_t low = key.low ^ key.high >> 29;
+    high = (high ^ high >> 33) * 0xff51afd7ed558ccdULL;
+    low = (low ^ low >> 33) * 0xc4ceb9fe1a85ec53ULL;
+    return (cache_key){ high ^ high >> 33 ^ low, low ^ low >> 33 };
+}
+
+// Hash of the running executable, so a rebuilt emulator never sees results
+// of the old one
+cache_key build_key(void) {
+    cache_key key = { 0xcbf29ce484222325ULL, CACHE_HASH_GOLDEN };
+    FILE* file = fopen("/proc/self/exe", "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to read the emulator binary for the result cache\n");
+        exit(1);
+    }
+
+    uint32_t words[CACHE_READ_CHUNK / sizeof(uint32_t)];
+    size_t bytes;
+    while ((bytes = fread(words, 1, sizeof(words), file)) > 0) {
+        // A short tail is padded with zeros, the length is hashed below
+        memset((uint8_t*)words + bytes, 0, (sizeof(uint32_t) - bytes % sizeof(uint32_t)) % sizeof(uint32_t));
+        for (size_t i = 0; i < (bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t); i++) {
+            hash_word(&key, words[i]);
+        }
+        hash_word(&key, (uint32_t)bytes);
+    }
+    fclose(file);
+    return finish_key(key);
+}
+
+// Memory is hashed by content, the non-zero words with their addresses,
+// so it does not matter which files or pages put them there
+cache_key batch_key(const result_cache* cache, const batch_job* job) {
+    const PDP7_cpu* image = job->image;
+    cache_key key = { cache->build.high, cache->build.low };
+
+    hash_word(&key, image->model);
+    hash_word(&key, image->program_start_address);
+    hash_word(&key, image->pc);
+    hash_word(&key, (uint32_t)job->cycles);
+    hash_word(&key, (uint32_t)(job->cycles >> 32));
+    hash_word(&key, (uint32_t)job->input_size);
+    for (size_t i = 0; i < job->input_size; i++) {
+        hash_word(&key, job->input[i]);
+    }
+
+    for (uint32_t page = 0; page < MEMORY_PAGES; page++) {
+        if (image->pages[page] == memory_zero_page) {
+            continue;
+        }
+        for (uint32_t word = 0; word < MEMORY_PAGE_WORDS; word++) {
+            if (image->pages[page][word] != 0) {
+                hash_word(&key, page * MEMORY_PAGE_WORDS + word);
+                hash_word(&key, image->pages[page][word]);
+            }
+        }
+    }
+    return finish_key(key);
+}
+
+bool keys_equal(cache_key a, cache_key b) {
+    return a.high == b.high && a.low == b.low;
+}
+
+// The slot holding `key`, else the empty one it would go in
+cache_slot* find_slot(result_cache* cache, cache_key key) {
+    uint64_t index = key.low & (RESULT_CACHE_SLOTS - 1);
+    while (cache->slots[index].length != 0 && !keys_equal(cache->slots[index].key, key)) {
+        index = (index + 1) & (RESULT_CACHE_SLOTS - 1);
+    }
+    return &cache->slots[index];
+}
+
+// Fills `result` (freed with free_batch_result) when the key is stored
+bool cache_lookup(result_cache* cache, cache_key key, batch_result* result) {
+    flock(cache->index_fd, LOCK_SH);
+    cache_slot slot = *find_slot(cache, key);
+    bool current = keys_equal(cache->header->build, cache->build);
+    flock(cache->index_fd, LOCK_UN);
+    if (slot.length < sizeof(cache_record) || !current) {
+        return false;
+    }
+
+    uint8_t* bytes = malloc(slot.length);
+    if (!bytes) {
+        fprintf(stderr, "Failed to allocate a cached result\n");
+        exit(1);
+    }
+    // The store may have been cleared since, a record that is not there or
+    // not this key's is a miss
+    cache_record record;
+    bool valid = pread(cache->results_fd, bytes, slot.length, slot.offset) == (ssize_t)slot.length;
+    if (valid) {
+        memcpy(&record, bytes, sizeof(record));
+        valid = keys_equal(record.key, key) &&
+                sizeof(record) + (uint64_t)record.change_count * sizeof(memory_change) +
+                (uint64_t)record.output_count * sizeof(uint32_t) == slot.length;
+    }
+    if (!valid) {
+        free(bytes);
+        return false;
+    }
+
+    memset(result, 0, sizeof(batch_result));
+    result->cycles = record.cycles;
+    result->accumulator = record.accumulator;
+    result->pc = record.pc;
+    result->link = record.link;
+    result->extend_mode = record.extend_mode;
+    result->running = record.running;
+    result->trap = record.trap;
+    result->trap_pc = record.trap_pc;
+    result->trap_instruction = record.trap_instruction;
+    result->change_count = record.change_count;
+    result->output_count = record.output_count;
+    result->output_capacity = record.output_count;
+    result->changes = malloc(record.change_count * sizeof(memory_change) + 1);
+    result->output = malloc(record.output_count * sizeof(uint32_t) + 1);
+    if (!result->changes || !result->output) {
+        fprintf(stderr, "Failed to allocate a cached result\n");
+        exit(1);
+    }
+    memcpy(result->changes, bytes + sizeof(record), record.change_count * sizeof(memory_change));
+    memcpy(result->output, bytes + sizeof(record) + record.change_count * sizeof(memory_change),
+           record.output_count * sizeof(uint32_t));
+    free(bytes);
+    return true;
+}
+
+// Adds or replaces the result of `key`
+void cache_store(result_cache* cache, cache_key key, const batch_result* result) {
+    size_t changes_size = result->change_count * sizeof(memory_change);
+    size_t output_size = result->output_count * sizeof(uint32_t);
+    uint64_t length = sizeof(cache_record) + changes_size + output_size;
+
+    uint8_t* bytes = malloc(length);
+    if (!bytes) {
+        fprintf(stderr, "Failed to allocate a cached result\n");
+        exit(1);
+    }
+    cache_record record = {
+        .key = key,
+        .cycles = result->cycles,
+        .accumulator = result->accumulator,
+        .pc = result->pc,
+        .link = result->link,
+        .extend_mode = result->extend_mode,
+        .running = result->running,
+        .trap = result->trap,
+        .trap_pc = result->trap_pc,
+        .trap_instruction = result->trap_instruction,
+        .change_count = result->change_count,
+        .output_count = result->output_count,
+    };
+    memcpy(bytes, &record, sizeof(record));
+    if (changes_size) {
+        memcpy(bytes + sizeof(record), result->changes, changes_size);
+    }
+    if (output_size) {
+        memcpy(bytes + sizeof(record) + changes_size, result->output, output_size);
+    }
+
+    flock(cache->index_fd, LOCK_EX);
+    if (!keys_equal(cache->header->build, cache->build) || cache->header->bytes + length > cache->max_bytes ||
+        cache->header->entries >= RESULT_CACHE_SLOTS / 4 * 3) {
+        reset_store(cache);
+    }
+
+    // Written before the slot points at it, readers never see half a record
+    uint64_t offset = cache->header->bytes;
+    if (length <= cache->max_bytes && pwrite(cache->results_fd, bytes, length, offset) == (ssize_t)length) {
+        cache_slot* slot = find_slot(cache, key);
+        if (slot->length == 0) {
+            cache->header->entries++;
+        }
+        *slot = (cache_slot){ key, offset, length };
+        cache->header->bytes += length;
+    }
+    flock(cache->index_fd, LOCK_UN);
+    free(bytes);
+}
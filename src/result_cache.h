@@ -0,0 +1,56 @@
+#pragma once
+
+#include "batch.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RESULT_CACHE_SLOTS 65536                    // Must be a power of two
+#define RESULT_CACHE_DEFAULT_BYTES (256ULL << 20)   // Results kept before the store starts over
+#define RESULT_CACHE_VERSION 1
+
+// 128 bits over everything a batch run depends on
+typedef struct {
+    uint64_t high;
+    uint64_t low;
+} cache_key;
+
+typedef struct {
+    cache_key key;
+    uint64_t offset;             // Of the record in the results file
+    uint64_t length;             // 0 for an empty slot
+} cache_slot;
+
+// Start of the mmap'd index file, the slot table follows
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    cache_key build;             // Emulator binary the results came from
+    uint64_t entries;
+    uint64_t bytes;              // Used part of the results file
+    uint64_t generation;         // Times the store was cleared
+} cache_header;
+
+// Results of batch runs on disk, keyed by a hash of the loaded image, start
+// address, model, input, cycle budget and the emulator binary itself. The
+// index is an open-addressed table mmap'd shared, records are appended to
+// a results file and read back with one pread. Processes sharing a
+// directory take flock turns on the index.
+//
+// A different binary, an index three quarters full or a results file over
+// its byte limit clears the whole store: stale results never come back, and
+// a sweep refills what it still uses.
+typedef struct {
+    int index_fd;
+    int results_fd;
+    cache_header* header;
+    cache_slot* slots;
+    cache_key build;
+    uint64_t max_bytes;
+} result_cache;
+
+result_cache* open_result_cache(const char* directory, uint64_t max_bytes);
+void close_result_cache(result_cache* cache);
+void clear_result_cache(result_cache* cache);
+cache_key batch_key(const result_cache* cache, const batch_job* job);
+bool cache_lookup(result_cache* cache, cache_key key, batch_result* result);
+void cache_store(result_cache* cache, cache_key key, const batch_result* result);
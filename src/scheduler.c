@@ -0,0 +1,99 @@
+#include "scheduler.h"
+#include <stdlib.h>
+#include <inttypes.h>
+
+void step_display(void* device, PDP7_cpu* cpu);
+void run_until(cpu_scheduler* scheduler, uint64_t until, bool debug);
+void deliver_output(cpu_scheduler* scheduler);
+
+void initialize_scheduler(cpu_scheduler* scheduler, PDP7_cpu* cpu, display_340* display, FILE* output) {
+    scheduler->cpu = cpu;
+    scheduler->display = display;
+    scheduler->output = output;
+    scheduler->device_count = 0;
+    scheduler->output_words = 0;
+
+    if (display) {
+        schedule_device(scheduler, "display", step_display, display, DISPLAY_POLL_CYCLES);
+    }
+}
+
+void schedule_device(cpu_scheduler* scheduler, const char* name, void (*step)(void* device, PDP7_cpu* cpu),
+                     void* device, uint64_t interval) {
+    if (scheduler->device_count == SCHEDULER_MAX_DEVICES) {
+        fprintf(stderr, "Too many scheduled devices\n");
+        exit(1);
+    }
+
+    scheduled_device* scheduled = &scheduler->devices[scheduler->device_count++];
+    scheduled->name = name;
+    scheduled->step = step;
+    scheduled->device = device;
+    scheduled->interval = interval;
+    scheduled->next = scheduler->cpu->cycles + interval;
+    scheduled->steps = 0;
+}
+
+// Window events and keystrokes; closing the window stops the machine
+void step_display(void* device, PDP7_cpu* cpu) {
+    if (!display_poll_events(device)) {
+        cpu->running = false;
+    }
+}
+
+void run_scheduler(cpu_scheduler* scheduler, bool debug) {
+    PDP7_cpu* cpu = scheduler->cpu;
+
+    while (cpu->running) {
+        uint64_t until = cpu->cycles + SCHEDULER_SLICE_CYCLES;
+        for (uint32_t i = 0; i < scheduler->device_count; i++) {
+            if (scheduler->devices[i].next < until) {
+                until = scheduler->devices[i].next;
+            }
+        }
+
+        run_until(scheduler, until, debug);
+
+        if (cpu->io_buffer && *cpu->io_buffer != 0) {
+            deliver_output(scheduler);
+        }
+
+        for (uint32_t i = 0; i < scheduler->device_count && cpu->running; i++) {
+            scheduled_device* scheduled = &scheduler->devices[i];
+            if (cpu->cycles >= scheduled->next) {
+                scheduled->step(scheduled->device, cpu);
+                scheduled->steps++;
+                scheduled->next = cpu->cycles + scheduled->interval;
+            }
+        }
+    }
+}
+
+// The CPU's share of a slice. A word left in io_buffer ends it early, so
+// the next TLS always finds the buffer free and never waits on the host.
+void run_until(cpu_scheduler* scheduler, uint64_t until, bool debug) {
+    PDP7_cpu* cpu = scheduler->cpu;
+    volatile uint32_t* io_buffer = cpu->io_buffer;
+
+    while (cpu->running && cpu->cycles < until) {
+        perform_cycle(cpu);
+        if (debug) {
+            print_cpu_state(cpu);
+        }
+        if (io_buffer && *io_buffer != 0) {
+            return;
+        }
+    }
+}
+
+void deliver_output(cpu_scheduler* scheduler) {
+    PDP7_cpu* cpu = scheduler->cpu;
+
+    scheduler->output_words++;
+    if (scheduler->display) {
+        display_output(scheduler->display);
+        return;
+    }
+    fprintf(scheduler->output, "%06" PRIo32 "\n", *cpu->io_buffer);
+    *cpu->io_buffer = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include "display.h"
+#include <stdio.h>
+
+#define SCHEDULER_MAX_DEVICES 8
+#define SCHEDULER_SLICE_CYCLES 10000 // Longest CPU run between device checks
+#define DISPLAY_POLL_CYCLES 20000    // About 35 ms of guest time between window polls
+
+// A device stepped by the scheduler every `interval` guest cycles
+typedef struct {
+    const char* name;
+    void (*step)(void* device, PDP7_cpu* cpu);
+    void* device;
+    uint64_t interval;
+    uint64_t next;                // Cycle point of the next step
+    uint64_t steps;
+} scheduled_device;
+
+// Runs the CPU and its devices on one thread. The CPU runs in slices that
+// end at the next device cycle point or right after a TLS; devices then
+// run to completion before the CPU continues. Nothing depends on host
+// timing, so the same inputs give the same cycle counts and output.
+typedef struct {
+    PDP7_cpu* cpu;
+    display_340* display;         // Takes TLS words; NULL prints them to `output`
+    FILE* output;
+    scheduled_device devices[SCHEDULER_MAX_DEVICES];
+    uint32_t device_count;
+    uint64_t output_words;
+} cpu_scheduler;
+
+void initialize_scheduler(cpu_scheduler* scheduler, PDP7_cpu* cpu, display_340* display, FILE* output);
+void schedule_device(cpu_scheduler* scheduler, const char* name, void (*step)(void* device, PDP7_cpu* cpu),
+                     void* device, uint64_t interval);
+void run_scheduler(cpu_scheduler* scheduler, bool debug);
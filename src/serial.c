@@ -0,0 +1,81 @@
+#include "serial.h"
+#include <sched.h>
+
+#define SERIAL_POLL_SPINS 1024 // Full-line spins between attention checks
+
+// `baud` 0 makes the line unlimited, words arrive as soon as they are sent
+void initialize_serial(serial_line* line, uint32_t baud) {
+    atomic_store(&line->head, 0);
+    atomic_store(&line->tail, 0);
+    atomic_store(&line->closed, false);
+    line->cycles_per_word = baud ? (uint64_t)SERIAL_CYCLES_PER_SECOND * SERIAL_BITS_PER_WORD / baud : 0;
+    line->next_send = 0;
+    line->words = 0;
+    line->buffer = 0;
+}
+
+// Queues a word from the sending CPU. A busy line holds the sender until
+// the previous word is out, charged as cycles. A full ring blocks the host
+// thread instead; returns false if the run loop was asked back meanwhile,
+// the word is not sent then. Words to a closed line are dropped.
+bool serial_send(serial_line* line, PDP7_cpu* cpu, uint32_t word) {
+    uint32_t head = atomic_load_explicit(&line->head, memory_order_relaxed);
+
+    for (uint32_t spins = 1; head - atomic_load_explicit(&line->tail, memory_order_acquire) == SERIAL_BUFFER_SIZE; spins++) {
+        if (atomic_load_explicit(&line->closed, memory_order_relaxed)) {
+            return true;
+        }
+        if (spins % SERIAL_POLL_SPINS == 0 && cpu->attention &&
+            atomic_load_explicit(cpu->attention, memory_order_relaxed)) {
+            return false;
+        }
+        sched_yield();
+    }
+
+    if (atomic_load_explicit(&line->closed, memory_order_relaxed)) {
+        return true;
+    }
+
+    if (cpu->cycles < line->next_send) {
+        cpu->cycles = line->next_send;
+    }
+    line->next_send = cpu->cycles + line->cycles_per_word;
+
+    uint32_t slot = head & (SERIAL_BUFFER_SIZE - 1);
+    line->ring[slot] = word & 0777777;
+    line->arrival[slot] = line->next_send;
+    line->words++;
+    atomic_store_explicit(&line->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Receiver side: true once the oldest word has arrived by `cycles`
+bool serial_flag(serial_line* line, uint64_t cycles) {
+    uint32_t tail = atomic_load_explicit(&line->tail, memory_order_relaxed);
+
+    if (atomic_load_explicit(&line->head, memory_order_acquire) == tail) {
+        return false;
+    }
+    return line->arrival[tail & (SERIAL_BUFFER_SIZE - 1)] <= cycles;
+}
+
+uint32_t serial_read(serial_line* line, uint64_t cycles) {
+    if (serial_flag(line, cycles)) {
+        uint32_t tail = atomic_load_explicit(&line->tail, memory_order_relaxed);
+        line->buffer = line->ring[tail & (SERIAL_BUFFER_SIZE - 1)];
+        atomic_store_explicit(&line->tail, tail + 1, memory_order_release);
+    }
+
+    return line->buffer;
+}
+
+void serial_close(serial_line* line) {
+    atomic_store_explicit(&line->closed, true, memory_order_release);
+}
+
+// Closed with nothing left to read, the receiver will never see another word
+bool serial_drained(serial_line* line) {
+    return atomic_load_explicit(&line->closed, memory_order_acquire) &&
+           atomic_load_explicit(&line->head, memory_order_acquire) ==
+           atomic_load_explicit(&line->tail, memory_order_relaxed);
+}
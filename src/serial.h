@@ -0,0 +1,34 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SERIAL_BUFFER_SIZE 64 // Must be a power of two
+#define SERIAL_CYCLES_PER_SECOND 571428 // 1.75 us memory cycle
+#define SERIAL_BITS_PER_WORD 10 // Start bit, eight data bits, stop bit
+
+// One-way line between two machines: the sender's TLS pushes, the
+// receiver's KSF/KRB pop. Single-producer single-consumer like the keyboard
+// ring, but carrying whole 18-bit words the way io_buffer does. Each word is
+// stamped with the sender cycle it finishes arriving at, so a receiver only
+// sees it once its own clock has got there.
+typedef struct serial_line {
+    uint32_t ring[SERIAL_BUFFER_SIZE];
+    uint64_t arrival[SERIAL_BUFFER_SIZE];
+    _Atomic uint32_t head;   // Next slot to write (sender)
+    _Atomic uint32_t tail;   // Next slot to read (receiver)
+    atomic_bool closed;      // Either end has stopped, sends are dropped
+    uint64_t cycles_per_word; // Line time of one word, 0 for unlimited speed
+    uint64_t next_send;      // Sender cycle the line is free again
+    uint64_t words;          // Words carried so far
+    uint32_t buffer;         // Receive buffer, keeps the last word read
+} serial_line;
+
+void initialize_serial(serial_line* line, uint32_t baud);
+bool serial_send(serial_line* line, PDP7_cpu* cpu, uint32_t word);
+bool serial_flag(serial_line* line, uint64_t cycles);
+uint32_t serial_read(serial_line* line, uint64_t cycles);
+void serial_close(serial_line* line);
+bool serial_drained(serial_line* line);
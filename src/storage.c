@@ -0,0 +1,123 @@
+#include "storage.h"
+#include "data_channel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+void storage_transfer(block_storage* storage, PDP7_cpu* cpu, bool to_memory);
+
+void initialize_storage(block_storage* storage, const char* filename) {
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        printf("Failed to open storage file %s\n", filename);
+        exit(1);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0) {
+        printf("Failed to stat storage file %s\n", filename);
+        close(fd);
+        exit(1);
+    }
+
+    size_t block_bytes = STORAGE_BLOCK_WORDS * sizeof(uint32_t);
+    uint32_t blocks = file_stat.st_size / block_bytes;
+    if (blocks == 0) {
+        blocks = STORAGE_DEFAULT_BLOCKS;
+        if (ftruncate(fd, blocks * block_bytes) < 0) {
+            printf("Failed to size storage file %s\n", filename);
+            close(fd);
+            exit(1);
+        }
+    }
+
+    void* words = mmap(NULL, blocks * block_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (words == MAP_FAILED) {
+        printf("Failed to map storage file %s\n", filename);
+        close(fd);
+        exit(1);
+    }
+
+    storage->words = (uint32_t*)words;
+    storage->blocks = blocks;
+    storage->fd = fd;
+    storage->block = 0;
+    storage->address = 0;
+    storage->word_count = 0;
+    storage->flag = false;
+    storage->error = false;
+}
+
+void close_storage(block_storage* storage) {
+    if (storage->words == NULL) {
+        return;
+    }
+
+    size_t length = (size_t)storage->blocks * STORAGE_BLOCK_WORDS * sizeof(uint32_t);
+    msync(storage->words, length, MS_SYNC);
+    munmap(storage->words, length);
+    close(storage->fd);
+    storage->words = NULL;
+}
+
+// Every storage IOT but DSSF, whose skip the bus does from the flag.
+// False for a word the device does not implement.
+bool storage_iot(block_storage* storage, PDP7_cpu* cpu, uint32_t instruction) {
+    switch (instruction) {
+        case IOT_DSCF:
+            // Clear storage flags
+            storage->flag = false;
+            storage->error = false;
+            break;
+        case IOT_DSLB:
+            // Load block number from AC
+            storage->block = cpu->accumulator;
+            break;
+        case IOT_DSLA:
+            // Load core address from AC
+            storage->address = cpu->accumulator & (MEMORY_SIZE - 1);
+            break;
+        case IOT_DSLC:
+            // Load word count from AC
+            storage->word_count = cpu->accumulator;
+            break;
+        case IOT_DSRD:
+            // Read blocks into core
+            storage_transfer(storage, cpu, DATA_CHANNEL_TO_MEMORY);
+            break;
+        case IOT_DSWR:
+            // Write core into blocks
+            storage_transfer(storage, cpu, DATA_CHANNEL_FROM_MEMORY);
+            break;
+        case IOT_DSRS:
+            // Read status into AC
+            cpu->accumulator = (storage->flag ? STORAGE_STATUS_FLAG : 0) |
+                               (storage->error ? STORAGE_STATUS_ERROR : 0) |
+                               (storage->block & 0177777);
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+void storage_transfer(block_storage* storage, PDP7_cpu* cpu, bool to_memory) {
+    uint64_t first_word = (uint64_t)storage->block * STORAGE_BLOCK_WORDS;
+    uint64_t last_word = first_word + storage->word_count;
+
+    storage->flag = true;
+    if (last_word > (uint64_t)storage->blocks * STORAGE_BLOCK_WORDS) {
+        storage->error = true;
+        return;
+    }
+
+    data_channel_transfer(cpu, &storage->words[first_word], storage->address, storage->word_count, to_memory);
+
+    // Registers advance past the transferred words, so chained transfers continue
+    storage->address = (storage->address + storage->word_count) & (MEMORY_SIZE - 1);
+    storage->block += (storage->word_count + STORAGE_BLOCK_WORDS - 1) / STORAGE_BLOCK_WORDS;
+    storage->error = false;
+}
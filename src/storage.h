@@ -0,0 +1,38 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Block storage geometry (DECtape style: 578 blocks of 256 words per reel)
+#define STORAGE_BLOCK_WORDS 256
+#define STORAGE_DEFAULT_BLOCKS 578
+
+// Status bits returned by DSRS
+#define STORAGE_STATUS_FLAG  0400000 // Transfer complete
+#define STORAGE_STATUS_ERROR 0200000 // Last transfer was out of range
+
+// Storage I/O instructions in octal (device codes 60-62)
+#define IOT_DSSF 0706001 // Skip on storage flag
+#define IOT_DSCF 0706002 // Clear storage flags
+#define IOT_DSLB 0706004 // Load block number from AC
+#define IOT_DSLA 0706101 // Load core address from AC
+#define IOT_DSLC 0706102 // Load word count from AC
+#define IOT_DSRD 0706201 // Read blocks into core
+#define IOT_DSWR 0706202 // Write core into blocks
+#define IOT_DSRS 0706204 // Read status into AC
+
+typedef struct block_storage {
+    uint32_t* words;         // mmap'd backing file (one host word per 18-bit word)
+    uint32_t blocks;         // Number of blocks in the backing file
+    int fd;                  // Backing file descriptor
+    uint32_t block;          // Block Number register
+    uint32_t address;        // Core Address register
+    uint32_t word_count;     // Word Count register
+    bool flag;               // Transfer complete flag
+    bool error;              // Transfer error flag
+} block_storage;
+
+void initialize_storage(block_storage* storage, const char* filename);
+void close_storage(block_storage* storage);
+bool storage_iot(block_storage* storage, PDP7_cpu* cpu, uint32_t instruction);
@@ -0,0 +1,171 @@
+#include "terminal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TERMINAL_FRAME_BYTES (TERMINAL_CELLS * 16) // Cursor move plus a glyph for every cell
+
+// Braille dot bits by (column, row) within a cell
+static const uint8_t BRAILLE_DOTS[2][4] = {
+    { 0x01, 0x02, 0x04, 0x40 },
+    { 0x08, 0x10, 0x20, 0x80 },
+};
+
+uint64_t terminal_now_ms(void);
+size_t put_cell(char* frame, uint32_t cell);
+
+terminal_screen* create_terminal(FILE* out, bool raw_input) {
+    terminal_screen* terminal = calloc(1, sizeof(terminal_screen));
+    if (terminal) {
+        terminal->frame = malloc(TERMINAL_FRAME_BYTES);
+    }
+    if (!terminal || !terminal->frame) {
+        fprintf(stderr, "Failed to allocate the terminal display\n");
+        exit(1);
+    }
+    terminal->out = out;
+    terminal->cursor = -1;
+
+    // Keys typed for the guest shouldn't echo into the picture
+    if (raw_input && isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &terminal->saved_input) == 0) {
+        struct termios raw = terminal->saved_input;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        terminal->raw_input = true;
+    }
+
+    fputs("\x1b[2J\x1b[?25l", out); // Clear, hide the cursor
+    fflush(out);
+    return terminal;
+}
+
+// Sends the last frame and leaves the cursor under the picture
+void destroy_terminal(terminal_screen* terminal) {
+    terminal_flush(terminal);
+    fprintf(terminal->out, "\x1b[%d;1H\x1b[?25h\n", TERMINAL_ROWS);
+    fflush(terminal->out);
+
+    if (terminal->raw_input) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &terminal->saved_input);
+    }
+    free(terminal->frame);
+    free(terminal);
+}
+
+// Characters snap to the cell under their top left corner. Anything but
+// printable ASCII shows as '?', so the guest cannot send control codes to
+// the real terminal.
+void terminal_char(terminal_screen* terminal, int x, int y, char character) {
+    int column = x / TERMINAL_CELL_WIDTH;
+    int row = y / TERMINAL_CELL_HEIGHT;
+
+    if (x < 0 || y < 0 || column >= TERMINAL_COLUMNS || row >= TERMINAL_ROWS) {
+        return;
+    }
+    uint8_t code = (uint8_t)character;
+    if (code < 040 || code > 0176) {
+        code = '?';
+    }
+    terminal->screen[row * TERMINAL_COLUMNS + column] = TERMINAL_TEXT | code;
+}
+
+// A dot of a braille cell. Drawing into a character cell replaces it.
+void terminal_point(terminal_screen* terminal, int x, int y, bool lit) {
+    if (x < 0 || y < 0 || x >= TERMINAL_COLUMNS * TERMINAL_CELL_WIDTH || y >= TERMINAL_ROWS * TERMINAL_CELL_HEIGHT) {
+        return;
+    }
+
+    int dot_x = x / TERMINAL_DOT_WIDTH;
+    int dot_y = y / TERMINAL_DOT_HEIGHT;
+    uint32_t* cell = &terminal->screen[(dot_y / 4) * TERMINAL_COLUMNS + dot_x / 2];
+    uint8_t bits = (*cell & TERMINAL_DOTS) ? (uint8_t)*cell : 0;
+
+    if (lit) {
+        bits |= BRAILLE_DOTS[dot_x % 2][dot_y % 4];
+    } else {
+        bits &= ~BRAILLE_DOTS[dot_x % 2][dot_y % 4];
+    }
+    *cell = bits ? TERMINAL_DOTS | bits : 0;
+}
+
+// Bresenham over dots rather than pixels, each dot is set once
+void terminal_line(terminal_screen* terminal, int x0, int y0, int x1, int y1, bool lit) {
+    int dot_x0 = x0 / TERMINAL_DOT_WIDTH, dot_y0 = y0 / TERMINAL_DOT_HEIGHT;
+    int dot_x1 = x1 / TERMINAL_DOT_WIDTH, dot_y1 = y1 / TERMINAL_DOT_HEIGHT;
+    int dx = abs(dot_x1 - dot_x0), sx = dot_x0 < dot_x1 ? 1 : -1;
+    int dy = -abs(dot_y1 - dot_y0), sy = dot_y0 < dot_y1 ? 1 : -1;
+    int error = dx + dy;
+
+    for (;;) {
+        terminal_point(terminal, dot_x0 * TERMINAL_DOT_WIDTH, dot_y0 * TERMINAL_DOT_HEIGHT, lit);
+        if (dot_x0 == dot_x1 && dot_y0 == dot_y1) {
+            break;
+        }
+        int twice = 2 * error;
+        if (twice >= dy) {
+            error += dy;
+            dot_x0 += sx;
+        }
+        if (twice <= dx) {
+            error += dx;
+            dot_y0 += sy;
+        }
+    }
+}
+
+// UTF-8 for the cell's glyph, returns its length
+size_t put_cell(char* frame, uint32_t cell) {
+    if (cell & TERMINAL_DOTS) {
+        uint8_t bits = (uint8_t)cell;
+        frame[0] = (char)0xe2;            // U+2800 + bits
+        frame[1] = (char)(0xa0 | bits >> 6);
+        frame[2] = (char)(0x80 | (bits & 0x3f));
+        return 3;
+    }
+    frame[0] = (cell & TERMINAL_TEXT) ? (char)(uint8_t)cell : ' ';
+    return 1;
+}
+
+// Writes every changed cell, moving the cursor only where the previous
+// write didn't leave it. Returns the bytes sent.
+size_t terminal_flush(terminal_screen* terminal) {
+    size_t length = 0;
+
+    for (int cell = 0; cell < TERMINAL_CELLS; cell++) {
+        if (terminal->screen[cell] == terminal->shown[cell]) {
+            continue;
+        }
+        if (terminal->cursor != cell) {
+            length += sprintf(terminal->frame + length, "\x1b[%d;%dH", cell / TERMINAL_COLUMNS + 1,
+                              cell % TERMINAL_COLUMNS + 1);
+        }
+        length += put_cell(terminal->frame + length, terminal->screen[cell]);
+        terminal->shown[cell] = terminal->screen[cell];
+        // The cursor wraps to the next row after the last column on most terminals, not all
+        terminal->cursor = (cell + 1) % TERMINAL_COLUMNS ? cell + 1 : -1;
+    }
+
+    if (length) {
+        fwrite(terminal->frame, 1, length, terminal->out);
+        fflush(terminal->out);
+        terminal->frames++;
+    }
+    return length;
+}
+
+// Flushes at most once per TERMINAL_FRAME_MS however often the guest draws
+void terminal_present(terminal_screen* terminal) {
+    uint64_t now = terminal_now_ms();
+    if (now - terminal->last_flush_ms < TERMINAL_FRAME_MS) {
+        return;
+    }
+    terminal->last_flush_ms = now;
+    terminal_flush(terminal);
+}
+
+uint64_t terminal_now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
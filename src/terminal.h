@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <termios.h>
+
+#define TERMINAL_CELL_WIDTH 12   // Display pixels per cell, one character advance
+#define TERMINAL_CELL_HEIGHT 16  // Display pixels per cell, one line of text
+#define TERMINAL_COLUMNS 86      // Covers the 1024 pixel wide 340 screen
+#define TERMINAL_ROWS 64
+#define TERMINAL_DOT_WIDTH (TERMINAL_CELL_WIDTH / 2)  // Braille cells are 2x4 dots
+#define TERMINAL_DOT_HEIGHT (TERMINAL_CELL_HEIGHT / 4)
+#define TERMINAL_FRAME_MS 50     // Shortest time between two screen updates
+#define TERMINAL_CELLS (TERMINAL_COLUMNS * TERMINAL_ROWS)
+
+// Cell contents: empty, a character, or a braille dot pattern
+#define TERMINAL_TEXT 0x10000
+#define TERMINAL_DOTS 0x20000
+
+// 340 output drawn on an ANSI terminal. Drawing only touches `screen`;
+// a flush sends the cells that differ from `shown`, what the terminal
+// already has, as one write.
+typedef struct terminal_screen {
+    uint32_t screen[TERMINAL_CELLS];
+    uint32_t shown[TERMINAL_CELLS];
+    FILE* out;
+    char* frame;                 // Escape sequences of the frame being built
+    int cursor;                  // Cell the terminal cursor is on, -1 if unknown
+    uint64_t last_flush_ms;
+    uint64_t frames;
+    bool raw_input;              // Echo and line buffering were turned off
+    struct termios saved_input;
+} terminal_screen;
+
+terminal_screen* create_terminal(FILE* out, bool raw_input);
+void destroy_terminal(terminal_screen* terminal);
+void terminal_char(terminal_screen* terminal, int x, int y, char character);
+void terminal_point(terminal_screen* terminal, int x, int y, bool lit);
+void terminal_line(terminal_screen* terminal, int x0, int y0, int x1, int y1, bool lit);
+size_t terminal_flush(terminal_screen* terminal);
+void terminal_present(terminal_screen* terminal);
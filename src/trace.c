@@ -0,0 +1,139 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_WRITER_SLEEP_US 1000
+
+void* run_trace_writer(void* arg);
+void trace_write_header(trace_buffer* trace);
+uint64_t trace_drain(trace_buffer* trace, trace_record* chunk);
+
+trace_buffer* create_trace(const char* filename, uint32_t capacity, bool streaming) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        fprintf(stderr, "Trace capacity must be a power of two: %u\n", capacity);
+        exit(1);
+    }
+
+    trace_buffer* trace = calloc(1, sizeof(trace_buffer));
+    trace_record* records = calloc(capacity, sizeof(trace_record));
+    FILE* file = fopen(filename, "wb");
+    if (!trace || !records || !file) {
+        printf("Failed to set up trace file %s\n", filename);
+        exit(1);
+    }
+
+    trace->records = records;
+    trace->mask = capacity - 1;
+    atomic_store(&trace->head, 0);
+    trace->tail = 0;
+    trace->dropped = 0;
+    trace->file = file;
+    trace->streaming = streaming;
+    atomic_store(&trace->stop, false);
+
+    if (streaming) {
+        trace_write_header(trace);
+        pthread_create(&trace->writer, NULL, run_trace_writer, trace);
+    }
+
+    return trace;
+}
+
+void destroy_trace(trace_buffer* trace) {
+    if (trace->streaming) {
+        atomic_store(&trace->stop, true);
+        pthread_join(trace->writer, NULL);
+        if (trace->dropped) {
+            fprintf(stderr, "Trace writer fell behind, %lu records dropped\n", trace->dropped);
+        }
+    }
+
+    fclose(trace->file);
+    free(trace->records);
+    free(trace);
+}
+
+void trace_write_header(trace_buffer* trace) {
+    uint32_t record_size = sizeof(trace_record);
+    fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), trace->file);
+    fwrite(&record_size, sizeof(record_size), 1, trace->file);
+}
+
+// Writes the last ring's worth of records, used on halt and on traps.
+// Streaming traces are flushed by their writer thread instead.
+void trace_dump(trace_buffer* trace) {
+    if (trace->streaming) {
+        return;
+    }
+
+    uint64_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    uint64_t capacity = (uint64_t)trace->mask + 1;
+    uint64_t first = head > capacity ? head - capacity : 0;
+
+    rewind(trace->file);
+    trace_write_header(trace);
+    for (uint64_t i = first; i < head; i++) {
+        fwrite(&trace->records[i & trace->mask], sizeof(trace_record), 1, trace->file);
+    }
+    fflush(trace->file);
+}
+
+// Copies everything written since the last drain into `chunk`. The producer
+// never waits, so records it lapped while we were copying are discarded.
+uint64_t trace_drain(trace_buffer* trace, trace_record* chunk) {
+    uint64_t capacity = (uint64_t)trace->mask + 1;
+    uint64_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+
+    if (head - trace->tail > capacity) {
+        trace->dropped += head - capacity - trace->tail;
+        trace->tail = head - capacity;
+    }
+
+    uint64_t count = head - trace->tail;
+    for (uint64_t i = 0; i < count; i++) {
+        chunk[i] = trace->records[(trace->tail + i) & trace->mask];
+    }
+
+    // The slot at the producer's head may already be half written
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t overwritten_until = atomic_load_explicit(&trace->head, memory_order_relaxed) + 1;
+    overwritten_until = overwritten_until > capacity ? overwritten_until - capacity : 0;
+
+    uint64_t skip = 0;
+    if (overwritten_until > trace->tail) {
+        skip = (overwritten_until < head ? overwritten_until : head) - trace->tail;
+        trace->dropped += skip;
+    }
+
+    trace->tail = head;
+    if (skip) {
+        memmove(chunk, chunk + skip, (count - skip) * sizeof(trace_record));
+    }
+    return count - skip;
+}
+
+void* run_trace_writer(void* arg) {
+    trace_buffer* trace = (trace_buffer*)arg;
+    trace_record* chunk = malloc(((size_t)trace->mask + 1) * sizeof(trace_record));
+    if (!chunk) {
+        printf("Failed to allocate trace writer buffer\n");
+        exit(1);
+    }
+
+    bool stopping = false;
+    while (!stopping) {
+        stopping = atomic_load(&trace->stop);
+
+        uint64_t count = trace_drain(trace, chunk);
+        if (count) {
+            fwrite(chunk, sizeof(trace_record), count, trace->file);
+        } else if (!stopping) {
+            usleep(TRACE_WRITER_SLEEP_US);
+        }
+    }
+
+    fflush(trace->file);
+    free(chunk);
+    return NULL;
+}
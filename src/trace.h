@@ -0,0 +1,50 @@
+#pragma once
+
+#include "pdp7_cpu.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_MAGIC "PDP7TRC1"
+#define TRACE_DEFAULT_RECORDS (1u << 16) // Must be a power of two
+#define TRACE_LINK_BIT 0x80000000u
+
+// Packed state after one executed instruction (16 bytes)
+typedef struct {
+    uint16_t pc;             // Address the instruction was fetched from
+    uint16_t address;        // Effective address
+    uint32_t instruction;    // Instruction word, link in TRACE_LINK_BIT
+    uint32_t accumulator;    // AC after execution
+    uint32_t cycles;         // Low 32 bits of the cycle counter after execution
+} trace_record;
+
+typedef struct trace_buffer {
+    trace_record* records;
+    uint32_t mask;               // Capacity - 1
+    _Atomic uint64_t head;       // Records ever written (producer)
+    uint64_t tail;               // Records already on disk (writer)
+    uint64_t dropped;            // Records overwritten before the writer got them
+    FILE* file;
+    bool streaming;              // Background writer drains the ring continuously
+    _Atomic bool stop;
+    pthread_t writer;
+} trace_buffer;
+
+trace_buffer* create_trace(const char* filename, uint32_t capacity, bool streaming);
+void destroy_trace(trace_buffer* trace);
+void trace_dump(trace_buffer* trace);
+
+static inline void trace_instruction(trace_buffer* trace, uint32_t pc, uint32_t instruction, const PDP7_cpu* cpu) {
+    uint64_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    trace_record* record = &trace->records[head & trace->mask];
+
+    record->pc = (uint16_t)pc;
+    record->address = (uint16_t)cpu->memory_address;
+    record->instruction = instruction | (cpu->link ? TRACE_LINK_BIT : 0);
+    record->accumulator = cpu->accumulator;
+    record->cycles = (uint32_t)cpu->cycles;
+
+    atomic_store_explicit(&trace->head, head + 1, memory_order_release);
+}
@@ -0,0 +1,239 @@
+#include "pdp7_cpu.h"
+#include "lanes.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// Guest benchmark suite: runs fixed cycle budgets of each workload headless
+// and prints guest MIPS and host ns per instruction as JSON. With -l every
+// workload runs as a full group of vector lanes and MIPS are summed over
+// them.
+
+#define BENCH_DATA "tests/bench/data/"
+#define BENCH_START_ADDRESS 02000
+#define BENCH_DEFAULT_REPEATS 5
+
+typedef struct {
+    const char* name;
+    const char* program_file;
+    const char* memory_file;
+    uint64_t cycles;
+} bench_workload;
+
+typedef struct {
+    double mean;
+    double min;
+    double max;
+    double stddev;
+} bench_stats;
+
+static const bench_workload workloads[] = {
+    { "fibonacci", "data/program.dat", "data/memory.dat", 200000 },
+    { "alu", BENCH_DATA "alu_program.dat", BENCH_DATA "alu_memory.dat", 20000000 },
+    { "branch", BENCH_DATA "branch_program.dat", BENCH_DATA "branch_memory.dat", 20000000 },
+    { "indirect", BENCH_DATA "indirect_program.dat", BENCH_DATA "indirect_memory.dat", 20000000 },
+    { "xct", BENCH_DATA "xct_program.dat", BENCH_DATA "xct_memory.dat", 20000000 },
+    { "display", BENCH_DATA "display_program.dat", BENCH_DATA "display_memory.dat", 20000 },
+};
+
+#define BENCH_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+static uint32_t io_buffer;
+static atomic_bool sink_stop;
+static PDP7_cpu image;
+static PDP7_cpu cpu;
+
+int main(int argc, char *argv[]);
+void* run_output_sink(void* arg);
+double now_seconds(void);
+uint64_t run_workload(const bench_workload* workload, uint64_t budget, double* seconds);
+uint64_t run_lanes_workload(const bench_workload* workload, uint64_t budget, double* seconds);
+bench_stats compute_stats(const double* samples, int count);
+void print_stats(FILE* out, const char* name, bench_stats stats);
+
+// Stands in for the display thread so TLS never blocks for long
+void* run_output_sink(void* arg) {
+    volatile uint32_t* buffer = arg;
+    while (!atomic_load_explicit(&sink_stop, memory_order_relaxed)) {
+        if (*buffer != 0) {
+            *buffer = 0;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Runs `budget` guest cycles of a workload, restarting it from its loaded
+// image whenever it halts. Returns the instructions executed.
+uint64_t run_workload(const bench_workload* workload, uint64_t budget, double* seconds) {
+    free_memory(&image);
+    initialize_cpu(&image, workload->program_file, workload->memory_file, &io_buffer, BENCH_START_ADDRESS);
+    copy_cpu(&cpu, &image);
+
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    double start = now_seconds();
+    while (cycles < budget) {
+        uint64_t before = cpu.cycles;
+        instructions += run_cycles(&cpu, budget - cycles);
+        cycles += cpu.cycles - before;
+        if (!cpu.running) {
+            copy_cpu(&cpu, &image);
+        }
+    }
+    *seconds = now_seconds() - start;
+
+    return instructions;
+}
+
+// The same with PDP7_LANES copies of the workload in one lane group. All
+// lanes run identical data, so they share every dispatch.
+uint64_t run_lanes_workload(const bench_workload* workload, uint64_t budget, double* seconds) {
+    free_memory(&image);
+    initialize_cpu(&image, workload->program_file, workload->memory_file, NULL, BENCH_START_ADDRESS);
+    cpu_lanes* lanes = create_lanes(&image, PDP7_LANES);
+
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    double start = now_seconds();
+    while (cycles < budget) {
+        uint64_t before = lanes->cycles[0];
+        instructions += run_lanes(lanes, budget - cycles);
+        cycles += lanes->cycles[0] - before;
+        if (!lanes_running(lanes)) {
+            reset_lanes(lanes, &image);
+        }
+    }
+    *seconds = now_seconds() - start;
+
+    destroy_lanes(lanes);
+    return instructions;
+}
+
+bench_stats compute_stats(const double* samples, int count) {
+    bench_stats stats = { 0.0, samples[0], samples[0], 0.0 };
+    for (int i = 0; i < count; i++) {
+        stats.mean += samples[i] / count;
+        stats.min = samples[i] < stats.min ? samples[i] : stats.min;
+        stats.max = samples[i] > stats.max ? samples[i] : stats.max;
+    }
+
+    if (count > 1) {
+        double sum = 0.0;
+        for (int i = 0; i < count; i++) {
+            sum += (samples[i] - stats.mean) * (samples[i] - stats.mean);
+        }
+        stats.stddev = sqrt(sum / (count - 1));
+    }
+    return stats;
+}
+
+void print_stats(FILE* out, const char* name, bench_stats stats) {
+    fprintf(out, "      \"%s\": { \"mean\": %.3f, \"min\": %.3f, \"max\": %.3f, \"stddev\": %.3f }",
+            name, stats.mean, stats.min, stats.max, stats.stddev);
+}
+
+int main(int argc, char *argv[]) {
+    int repeats = BENCH_DEFAULT_REPEATS;
+    double scale = 1.0;
+    const char* only = NULL;
+    const char* output_file = NULL;
+    bool vector_lanes = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            scale = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0) {
+            vector_lanes = true;
+        } else {
+            repeats = 0;
+            break;
+        }
+    }
+
+    if (repeats <= 0 || scale <= 0.0) {
+        fprintf(stderr, "Usage: %s [-r <repeats>] [-s <budget scale>] [-w <workload>] [-o <json file>] [-l]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* out = stdout;
+    if (output_file) {
+        out = fopen(output_file, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open benchmark output %s\n", output_file);
+            return EXIT_FAILURE;
+        }
+    }
+
+    initialize_memory(&image);
+    initialize_memory(&cpu);
+
+    pthread_t sink_thread;
+    pthread_create(&sink_thread, NULL, run_output_sink, &io_buffer);
+
+    double* mips = malloc(repeats * sizeof(double));
+    double* ns_per_instruction = malloc(repeats * sizeof(double));
+
+    fprintf(out, "{\n  \"repeats\": %d,\n  \"scale\": %g,\n  \"lanes\": %d,\n  \"workloads\": [", repeats, scale,
+            vector_lanes ? PDP7_LANES : 1);
+    const char* separator = "\n";
+    for (size_t w = 0; w < BENCH_WORKLOADS; w++) {
+        const bench_workload* workload = &workloads[w];
+        if (only && strcmp(only, workload->name) != 0) {
+            continue;
+        }
+
+        uint64_t budget = (uint64_t)(workload->cycles * scale);
+        uint64_t instructions = 0;
+        double seconds;
+
+        // Untimed warm up pass for caches and branch predictors
+        uint64_t (*run)(const bench_workload*, uint64_t, double*) = vector_lanes ? run_lanes_workload : run_workload;
+        run(workload, budget / 10 + 1, &seconds);
+        for (int r = 0; r < repeats; r++) {
+            instructions = run(workload, budget, &seconds);
+            mips[r] = instructions / seconds / 1e6;
+            ns_per_instruction[r] = seconds * 1e9 / instructions;
+        }
+
+        fprintf(out, "%s    {\n", separator);
+        fprintf(out, "      \"name\": \"%s\",\n", workload->name);
+        fprintf(out, "      \"cycles\": %" PRIu64 ",\n", budget);
+        fprintf(out, "      \"instructions\": %" PRIu64 ",\n", instructions);
+        print_stats(out, "mips", compute_stats(mips, repeats));
+        fprintf(out, ",\n");
+        print_stats(out, "ns_per_instruction", compute_stats(ns_per_instruction, repeats));
+        fprintf(out, "\n    }");
+        separator = ",\n";
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    atomic_store(&sink_stop, true);
+    pthread_join(sink_thread, NULL);
+    free(mips);
+    free(ns_per_instruction);
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -2,6 +2,24 @@
 #include "test_cpu_addressing.h"
 #include "test_cpu_decode.h"
 #include "test_cpu_execute.h"
+#include "test_storage.h"
+#include "test_host_service.h"
+#include "test_keyboard.h"
+#include "test_profiler.h"
+#include "test_trace.h"
+#include "test_debugger.h"
+#include "test_console.h"
+#include "test_metrics.h"
+#include "test_lockstep.h"
+#include "test_fuzz.h"
+#include "test_network.h"
+#include "test_heatmap.h"
+#include "test_scheduler.h"
+#include "test_journal.h"
+#include "test_terminal.h"
+#include "test_gdb_stub.h"
+#include "test_lanes.h"
+#include "test_result_cache.h"
 
 int main(void);
 
@@ -11,10 +29,14 @@ int main() {
     printf("Testing CPU setup...\n");
     test_empty_pdp7();
     test_mem_load_pdp7();
+    test_lazy_pages();
+    test_shared_image();
 
     printf("Testing CPU addressing...\n");
     test_direct_address();
     test_indirect_address();
+    test_extended_address();
+    test_model_memory_extension();
 
     printf("Testing CPU decoding...\n");
     test_instruction_parsing();
@@ -23,6 +45,74 @@ int main() {
     test_execute_add();
     test_execute_tad();
     test_execute_lac();
+    test_execute_iot_bus();
+    test_execute_pc_wraps();
+
+    printf("Testing block storage...\n");
+    test_storage_write_read();
+    test_storage_out_of_range();
+    test_storage_read_masks_high_bits();
+
+    printf("Testing host service...\n");
+    test_host_service_write();
+    test_host_service_read();
+
+    printf("Testing keyboard...\n");
+    test_keyboard_skip_on_flag();
+    test_keyboard_overrun();
+
+    printf("Testing profiler...\n");
+    test_profiler_counts();
+    test_profiler_labels();
+
+    printf("Testing tracing...\n");
+    test_trace_ring_dump();
+    test_disassemble();
+
+    printf("Testing debugger...\n");
+    test_debugger_watchpoints();
+    test_debugger_conditions();
+
+    printf("Testing console queue...\n");
+    test_console_queue();
+
+    printf("Testing metrics...\n");
+    test_metrics_publish();
+
+    printf("Testing lockstep...\n");
+    test_lockstep_matching_engines();
+    test_lockstep_finds_divergence();
+
+    printf("Testing fuzzing...\n");
+    test_fuzz_outcomes_and_reset();
+
+    printf("Testing networked machines...\n");
+    test_serial_pacing();
+    test_network_chain();
+
+    printf("Testing heatmap...\n");
+    test_heatmap_counts_and_decay();
+
+    printf("Testing scheduler...\n");
+    test_scheduler_deterministic_output();
+
+    printf("Testing input journal...\n");
+    test_journal_record_replay();
+
+    printf("Testing terminal display...\n");
+    test_terminal_diff_updates();
+
+    printf("Testing GDB stub...\n");
+    test_gdb_packets();
+    test_gdb_framing();
+
+    printf("Testing vector lanes...\n");
+    test_lanes_match_interpreter();
+    test_lanes_xct();
+
+    printf("Testing batch result cache...\n");
+    test_batch_run();
+    test_result_cache();
 
     printf("All tests passed!\n");
 
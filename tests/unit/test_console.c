@@ -0,0 +1,35 @@
+#include "test_console.h"
+#include <stdio.h>
+#include <string.h>
+
+void test_console_queue(void) {
+    console_queue queue;
+    char line[CONSOLE_LINE_SIZE];
+    char expected[CONSOLE_LINE_SIZE];
+
+    initialize_console_queue(&queue);
+    assert_(!console_pop(&queue, line), "Empty console queue returned a line.");
+    assert_(!atomic_load(&queue.attention), "New console queue has attention raised.");
+
+    for (int i = 0; i < CONSOLE_QUEUE_SIZE; i++) {
+        snprintf(expected, sizeof(expected), "e %o", i);
+        assert_(console_try_push(&queue, expected), "Console queue rejected a line before it was full.");
+    }
+    assert_(atomic_load(&queue.attention), "Push did not raise attention.");
+    assert_(!console_try_push(&queue, "q"), "Full console queue accepted a line.");
+
+    // The CPU loop clears attention once it has seen the queue
+    atomic_store(&queue.attention, false);
+    for (int i = 0; i < CONSOLE_QUEUE_SIZE; i++) {
+        snprintf(expected, sizeof(expected), "e %o", i);
+        assert_(console_pop(&queue, line), "Console queue lost a line.");
+        assert_(strcmp(line, expected) == 0, "Console queue lines came out of order.");
+    }
+    assert_(!console_pop(&queue, line), "Drained console queue returned a line.");
+    assert_(!atomic_load(&queue.attention), "Pop raised attention.");
+
+    // Wrapped around the ring, it accepts lines again
+    assert_(console_try_push(&queue, "q"), "Drained console queue rejected a line.");
+    assert_(atomic_load(&queue.attention), "Push after a clear did not raise attention.");
+    assert_(console_pop(&queue, line) && strcmp(line, "q") == 0, "Line pushed after wrapping was not returned.");
+}
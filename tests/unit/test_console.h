@@ -0,0 +1,6 @@
+#pragma once
+
+#include "../utils/unit_utils.h"
+#include "../../src/console.h"
+
+void test_console_queue(void);
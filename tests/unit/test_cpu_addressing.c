@@ -22,4 +22,45 @@ void test_indirect_address(void) {
     assert_(addr1 == 0000001, "Error on indirect addressing.");
     assert_(addr2 == 0000002, "Error on indirect addressing.");
     assert_(addr3 == 0000003, "Error on indirect addressing.");
-}
\ No newline at end of file
+}
+
+void test_extended_address(void) {
+    PDP7_cpu cpu = create_empty_cpu();
+
+    cpu.pc = 042000;
+    write_memory(&cpu, 040010, 070020);
+
+    assert_(get_effective_address(&cpu, 010, false) == 040010, "Direct address left the current bank.");
+    assert_(get_effective_address(&cpu, 010, true) == 050020, "Indirect address outside extend mode is not 13 bits in the bank.");
+
+    write_memory(&cpu, 042000, 0707702); // EEM
+    perform_cycle(&cpu);
+    assert_(cpu.extend_mode, "EEM did not enter extend mode.");
+    assert_(get_effective_address(&cpu, 010, true) == 070020, "Indirect address in extend mode is not 15 bits.");
+
+    write_memory(&cpu, 042001, 0707701); // SEM
+    perform_cycle(&cpu);
+    assert_(cpu.pc == 042003, "SEM did not skip in extend mode.");
+
+    write_memory(&cpu, 042003, 0707704); // LEM
+    perform_cycle(&cpu);
+    assert_(!cpu.extend_mode, "LEM did not leave extend mode.");
+}
+
+void test_model_memory_extension(void) {
+    PDP7_cpu cpu = create_empty_cpu();
+
+    write_memory(&cpu, 02000, 0707702); // EEM
+    write_memory(&cpu, 02001, 0740040); // HLT
+
+    cpu.model = MODEL_PDP4;
+    perform_cycle(&cpu);
+    assert_(cpu.trap == TRAP_IOT && !cpu.extend_mode, "EEM did not trap on a PDP-4.");
+
+    cpu.pc = 02000;
+    cpu.running = true;
+    cpu.trap = TRAP_NONE;
+    run_pdp9_instructions(&cpu, 10);
+    assert_(cpu.extend_mode && cpu.trap == TRAP_NONE, "EEM did not run on a PDP-9.");
+    assert_(!cpu.running && cpu.pc == 02002, "PDP-9 loop did not stop on HLT.");
+}
@@ -4,4 +4,6 @@
 #include "../utils/unit_utils.h"
 
 void test_direct_address(void);
-void test_indirect_address(void);
\ No newline at end of file
+void test_indirect_address(void);
+void test_extended_address(void);
+void test_model_memory_extension(void);
\ No newline at end of file
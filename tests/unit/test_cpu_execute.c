@@ -5,7 +5,7 @@ void test_execute_add(void) {
 
     cpu.ir = 030;
     cpu.accumulator = 010;
-    cpu.memory[8] = 020;
+    write_memory(&cpu, 8, 020);
     cpu.memory_address = 8;
 
     execute_instruction(&cpu, 0300010); // ADD
@@ -18,7 +18,7 @@ void test_execute_tad(void) {
 
     cpu.ir = 034;
     cpu.accumulator = 010;
-    cpu.memory[8] = 020;
+    write_memory(&cpu, 8, 020);
     cpu.memory_address = 8;
 
     execute_instruction(&cpu, 0340010); // TAD
@@ -31,10 +31,79 @@ void test_execute_lac(void) {
 
     cpu.ir = 020;
     cpu.accumulator = 010;
-    cpu.memory[8] = 020;
+    write_memory(&cpu, 8, 020);
     cpu.memory_address = 8;
 
     execute_instruction(&cpu, 0200010); // LAC
 
     assert_(cpu.accumulator == 020, "Failed to execute LAC instruction");
-}
\ No newline at end of file
+}
+
+static bool test_device_flag(void* device, PDP7_cpu* cpu) {
+    (void)cpu;
+    return *(uint32_t*)device != 0;
+}
+
+static bool test_device_pulse(void* device, PDP7_cpu* cpu, uint32_t instruction) {
+    if ((instruction & IOT_PULSES) != IOT_IOP2) {
+        return false;
+    }
+    *(uint32_t*)device = cpu->accumulator;
+    return true;
+}
+
+void test_execute_iot_bus(void) {
+    PDP7_cpu cpu = create_empty_cpu();
+    iot_bus bus;
+    uint32_t latch = 0;
+
+    initialize_iot_bus(&bus);
+    iot_attach(&bus, 040, "latch", test_device_flag, test_device_pulse, &latch, 3);
+    cpu.bus = &bus;
+    cpu.ir = OP_IOT;
+    cpu.running = true;
+
+    uint32_t pc = cpu.pc;
+    execute_instruction(&cpu, 0704001); // Flag clear, no skip
+    assert_(cpu.pc == pc && cpu.cycles == 3, "IOT to an attached device did not test its flag or charge its cycles.");
+
+    cpu.accumulator = 0123;
+    execute_instruction(&cpu, 0704002);
+    assert_(latch == 0123, "IOT pulse did not reach the attached device.");
+
+    execute_instruction(&cpu, 0704001);
+    assert_(cpu.pc == pc + 1, "IOT did not skip on the device flag.");
+
+    execute_instruction(&cpu, 0704004);
+    assert_(!cpu.running && cpu.trap == TRAP_IOT, "IOT pulse the device rejects did not trap.");
+
+    cpu.running = true;
+    execute_instruction(&cpu, 0705001);
+    assert_(!cpu.running && cpu.trap == TRAP_IOT, "IOT to an empty device code did not trap.");
+}
+
+void test_execute_pc_wraps(void) {
+    PDP7_cpu cpu = create_empty_cpu();
+    guest_profiler* profiler = create_profiler("/dev/null", 0);
+    cpu.profiler = profiler;
+
+    // Runs off the top of memory, a skip and a fetch both wrap to 0
+    write_memory(&cpu, 077776, OPR_SKP);
+    write_memory(&cpu, 000001, OPR_HLT);
+    cpu.pc = 077776;
+    run_cycles(&cpu, 100);
+    assert_(cpu.trap == TRAP_NONE && !cpu.running, "PC did not wrap to address 0.");
+    assert_(cpu.pc == 2 && profiler->count[1] == 1, "Skip past the top of memory did not wrap.");
+
+    // A relocated JMP lands past the top of memory
+    cpu.running = true;
+    cpu.program_start_address = 02000;
+    cpu.ir = OP_JMP;
+    cpu.memory_address = 077777;
+    execute_instruction(&cpu, 0617777);
+    assert_(cpu.pc == 01777, "Relocated JMP did not wrap the PC.");
+
+    cpu.profiler = NULL;
+    destroy_profiler(profiler);
+    free_memory(&cpu);
+}
@@ -2,7 +2,11 @@
 
 #include "../fixtures/sample_cpus.h"
 #include "../utils/unit_utils.h"
+#include "../../src/iot_bus.h"
+#include "../../src/profiler.h"
 
 void test_execute_add(void);
 void test_execute_tad(void);
-void test_execute_lac(void);
\ No newline at end of file
+void test_execute_lac(void);
+void test_execute_iot_bus(void);
+void test_execute_pc_wraps(void);
\ No newline at end of file
@@ -14,8 +14,9 @@ void test_empty_pdp7(void) {
 
     // Test that the memory is initialized correctly
     for (int i = 0; i < MEMORY_SIZE; i++) {
-        assert_(sample_cpu.memory[i] == 0, "Memory is not initialized to 0.");
+        assert_(read_memory(&sample_cpu, i) == 0, "Memory is not initialized to 0.");
     }
+    assert_(allocated_pages(&sample_cpu) == 0, "Untouched memory has pages allocated.");
 }
 
 void test_mem_load_pdp7(void) {
@@ -25,8 +26,45 @@ void test_mem_load_pdp7(void) {
     load_memory_from_file(&sample_cpu, "tests/fixtures/data/halt_program.dat", TEST_PROGRAM_START);
     load_memory_from_file(&sample_cpu, "tests/fixtures/data/sample_memory.dat", 0);
 
-    assert_(sample_cpu.memory[TEST_PROGRAM_START] == 0300000, "Instruction memory is not loaded correctly.");
-    assert_(sample_cpu.memory[TEST_PROGRAM_START + 1] == 0700312, "Instruction memory is not loaded correctly.");
-    assert_(sample_cpu.memory[0] == 0000001, "Data memory is not loaded correctly.");
+    assert_(read_memory(&sample_cpu, TEST_PROGRAM_START) == 0300000, "Instruction memory is not loaded correctly.");
+    assert_(read_memory(&sample_cpu, TEST_PROGRAM_START + 1) == 0700312, "Instruction memory is not loaded correctly.");
+    assert_(read_memory(&sample_cpu, 0) == 0000001, "Data memory is not loaded correctly.");
 }
 
+
+void test_lazy_pages(void) {
+    PDP7_cpu sample_cpu = create_empty_cpu();
+
+    write_memory(&sample_cpu, 060123, 0123456);
+    assert_(allocated_pages(&sample_cpu) == 1, "A single store did not allocate exactly one page.");
+    assert_(read_memory(&sample_cpu, 060123) == 0123456, "Store to bank 3 did not read back.");
+    assert_(read_memory(&sample_cpu, 060124) == 0, "Rest of a new page is not zero.");
+    assert_(read_memory(&sample_cpu, 000123) == 0, "Store to bank 3 shows up in bank 0.");
+
+    PDP7_cpu copy = create_empty_cpu();
+    copy_cpu(&copy, &sample_cpu);
+    write_memory(&copy, 060123, 0);
+    assert_(read_memory(&sample_cpu, 060123) == 0123456, "Copied machine shares pages with its source.");
+
+    free_memory(&copy);
+    free_memory(&sample_cpu);
+    assert_(allocated_pages(&sample_cpu) == 0, "Freed memory still has pages.");
+}
+
+void test_shared_image(void) {
+    PDP7_cpu image = create_empty_cpu();
+    write_memory(&image, 02000, 0200100);
+
+    PDP7_cpu machine = create_empty_cpu();
+    share_memory(&machine, &image);
+    assert_(read_memory(&machine, 02000) == 0200100, "Sharing machine does not see the image.");
+    assert_(allocated_pages(&machine) == 0, "Sharing an image allocated pages.");
+
+    write_memory(&machine, 02001, 0740040);
+    assert_(allocated_pages(&machine) == 1, "A store to a shared page did not copy exactly one page.");
+    assert_(read_memory(&machine, 02000) == 0200100, "Copied page lost the image's words.");
+    assert_(read_memory(&image, 02001) == 0, "Store to a shared page changed the image.");
+
+    free_memory(&machine);
+    free_memory(&image);
+}
@@ -4,4 +4,6 @@
 #include "../utils/unit_utils.h"
 
 void test_empty_pdp7(void);
-void test_mem_load_pdp7(void);
\ No newline at end of file
+void test_mem_load_pdp7(void);
+void test_lazy_pages(void);
+void test_shared_image(void);
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "test_debugger.h"
+
+void test_debugger_watchpoints(void) {
+    cpu_debugger debugger;
+    initialize_debugger(&debugger);
+    PDP7_cpu cpu = create_empty_cpu();
+
+    assert_(!debugger_active(&debugger), "Empty debugger reports itself active.");
+
+    write_memory(&cpu, 02000, 0040010); // DAC 10
+    write_memory(&cpu, 02001, 0220011); // LAC I 11
+    write_memory(&cpu, 011, 0100);
+
+    debugger_flag_range(&debugger, 010, 010, DEBUG_WATCH_READ);
+    assert_(debugger_active(&debugger), "Debugger with a watchpoint is not active.");
+    assert_(!debugger_check(&debugger, &cpu), "Read watchpoint stopped on a write.");
+
+    debugger_flag_range(&debugger, 0, 010, DEBUG_WATCH_WRITE);
+    assert_(debugger_check(&debugger, &cpu), "Write watchpoint did not stop a DAC.");
+
+    cpu.pc = 02001;
+    debugger_flag_range(&debugger, 0100, 0100, DEBUG_WATCH_READ);
+    assert_(debugger_check(&debugger, &cpu), "Read watchpoint did not stop an indirect LAC.");
+
+    debugger_clear(&debugger);
+    debugger_flag_range(&debugger, 02001, 02001, DEBUG_BREAK);
+    assert_(debugger_check(&debugger, &cpu), "Breakpoint did not stop at its PC.");
+}
+
+void test_debugger_conditions(void) {
+    cpu_debugger debugger;
+    initialize_debugger(&debugger);
+    PDP7_cpu cpu = create_empty_cpu();
+
+    debugger_add_condition(&debugger, CONDITION_AC, 042);
+    debugger_add_condition(&debugger, CONDITION_CYCLES, 100);
+
+    assert_(!debugger_check(&debugger, &cpu), "Condition stopped before it was true.");
+
+    cpu.accumulator = 042;
+    assert_(debugger_check(&debugger, &cpu), "AC condition did not stop when it became true.");
+    assert_(!debugger_check(&debugger, &cpu), "AC condition stopped again while still true.");
+
+    cpu.cycles = 150;
+    assert_(debugger_check(&debugger, &cpu), "Cycle condition did not stop once reached.");
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/debugger.h"
+
+void test_debugger_watchpoints(void);
+void test_debugger_conditions(void);
@@ -0,0 +1,23 @@
+#include "test_fuzz.h"
+
+void test_fuzz_outcomes_and_reset(void) {
+    pdp7_fuzzer* fuzzer = create_fuzzer("tests/fixtures/data/key_program.dat", NULL, 02000, 1000);
+    const uint8_t key[] = { FUZZ_KEY_FLAG | 'A' };
+    const uint8_t nop_poke[] = { 0x04, 0x00, 0x03, 0xC0, 0x00 }; // 02000 <- 740000
+
+    assert_(fuzz_run(fuzzer, NULL, 0) == FUZZ_TIMEOUT, "Program without a key did not run out of cycles.");
+
+    assert_(fuzz_run(fuzzer, key, sizeof(key)) == FUZZ_HALT, "Keystroke input did not reach HLT.");
+    assert_(read_memory(&fuzzer->cpu, 0100) == 'A', "Keystroke input was not read by the program.");
+
+    assert_(fuzz_run(fuzzer, nop_poke, sizeof(nop_poke)) == FUZZ_TRAP, "Unknown OPR word did not trap.");
+    assert_(fuzzer->cpu.trap == TRAP_OPERATE && fuzzer->cpu.trap_pc == 02000, "Trap reported the wrong cause.");
+
+    fuzz_reset(fuzzer);
+    assert_(read_memory(&fuzzer->cpu, 02000) == 0700301, "Reset did not restore a poked word.");
+    assert_(read_memory(&fuzzer->cpu, 0100) == 0, "Reset did not restore a stored word.");
+    assert_(fuzzer->cpu.running && fuzzer->cpu.trap == TRAP_NONE, "Reset did not restart the machine.");
+    assert_(fuzzer->runs == 3 && fuzzer->outcomes[FUZZ_TRAP] == 1, "Fuzzer miscounted its runs.");
+
+    destroy_fuzzer(fuzzer);
+}
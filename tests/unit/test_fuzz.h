@@ -0,0 +1,7 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/fuzz.h"
+
+void test_fuzz_outcomes_and_reset(void);
@@ -0,0 +1,68 @@
+#include "test_gdb_stub.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+void test_gdb_packets(void) {
+    gdb_stub stub;
+    PDP7_cpu cpu = create_empty_cpu();
+    char reply[GDB_PACKET_SIZE];
+
+    initialize_debugger(&stub.debugger);
+    cpu.accumulator = 0123456;
+    write_memory(&cpu, 02000, 0200100); // LAC 100
+
+    gdb_execute(&stub, &cpu, "g", reply);
+    assert_(strcmp(reply, "2ea70000000000000010000000000000") == 0, "Registers were not little-endian words with a byte address PC.");
+
+    gdb_execute(&stub, &cpu, "m1000,4", reply);
+    assert_(strcmp(reply, "40000100") == 0, "Word 02000 was not read as four bytes.");
+
+    gdb_execute(&stub, &cpu, "M1001,1:7f", reply);
+    assert_(strcmp(reply, "OK") == 0 && read_memory(&cpu, 02000) == 0277500, "A byte write did not land in its word.");
+
+    gdb_execute(&stub, &cpu, "P2=04100000", reply);
+    assert_(cpu.pc == 02001, "PC write was not taken as a byte address.");
+
+    gdb_execute(&stub, &cpu, "Z0,1004,4", reply);
+    assert_(strcmp(reply, "OK") == 0 && stub.debugger.flags[02001] == DEBUG_BREAK, "Breakpoint was not set.");
+    gdb_execute(&stub, &cpu, "z0,1004,4", reply);
+    assert_(stub.debugger.flagged_words == 0, "Breakpoint was not removed.");
+
+    assert_(gdb_execute(&stub, &cpu, "c", reply) == GDB_CONTINUE, "Continue did not resume.");
+    assert_(gdb_execute(&stub, &cpu, "D", reply) == GDB_DETACH && strcmp(reply, "OK") == 0, "Detach was not acknowledged.");
+
+    gdb_execute(&stub, &cpu, "vMustReplyEmpty", reply);
+    assert_(reply[0] == '\0', "Unsupported packet did not get an empty reply.");
+
+    free_memory(&cpu);
+}
+
+static void frame_text(gdb_stub* stub, const char* text) {
+    while (*text) {
+        frame_byte(stub, (uint8_t)*text++);
+    }
+}
+
+void test_gdb_framing(void) {
+    static gdb_stub stub;
+    int fds[2];
+    char ack;
+
+    assert_(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, "Failed to create a socket pair.");
+    stub.fd = fds[0];
+
+    // A checksum that is not hex is a failed frame, not a shifted -1
+    frame_text(&stub, "$g#zz");
+    assert_(read(fds[1], &ack, 1) == 1 && ack == '-', "A non-hex checksum was not refused.");
+    frame_text(&stub, "$g#6z");
+    assert_(read(fds[1], &ack, 1) == 1 && ack == '-', "A non-hex low checksum digit was not refused.");
+    assert_(stub.packets == 0, "A refused frame was handed on.");
+
+    frame_text(&stub, "$g#67");
+    assert_(read(fds[1], &ack, 1) == 1 && ack == '+', "A good frame after refused ones was not acknowledged.");
+    assert_(stub.packets == 1 && strcmp(stub.inbox, "g") == 0, "A good frame was not handed on.");
+
+    close(fds[0]);
+    close(fds[1]);
+}
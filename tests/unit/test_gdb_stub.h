@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/gdb_stub.h"
+
+void test_gdb_packets(void);
+void test_gdb_framing(void);
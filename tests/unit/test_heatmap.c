@@ -0,0 +1,30 @@
+#include "test_heatmap.h"
+
+void test_heatmap_counts_and_decay(void) {
+    memory_heatmap* heatmap = create_heatmap();
+    PDP7_cpu cpu = create_empty_cpu();
+    cpu.heatmap = heatmap;
+
+    write_memory(&cpu, 02000, 0060100); // DAC I 100
+    write_memory(&cpu, 0100, 0200);
+    perform_cycle(&cpu);
+
+    assert_(heatmap->counts[HEAT_EXECUTE][02000] == 1, "Executed word was not counted.");
+    assert_(heatmap->counts[HEAT_READ][0100] == 1, "Indirect pointer read was not counted.");
+    assert_(heatmap->counts[HEAT_WRITE][0200] == 1, "Store was not counted.");
+    assert_(heatmap->counts[HEAT_READ][0200] == 0, "Store was counted as a read.");
+
+    heatmap_sample(heatmap);
+    uint32_t red = (heatmap->pixels[0200] >> 16) & 0xff;
+    assert_(red > 0 && (heatmap->pixels[0200] & 0xffff) == 0, "Written word did not show as a write.");
+
+    heatmap_sample(heatmap);
+    assert_(((heatmap->pixels[0200] >> 16) & 0xff) < red, "Heat did not decay without new accesses.");
+
+    heatmap_show_bank(heatmap, 1);
+    heatmap_sample(heatmap);
+    assert_(heatmap->pixels[0200] == 0xff000000u, "Bank 1 showed accesses to bank 0.");
+
+    free_memory(&cpu);
+    destroy_heatmap(heatmap);
+}
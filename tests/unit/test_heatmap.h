@@ -0,0 +1,7 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/heatmap.h"
+
+void test_heatmap_counts_and_decay(void);
@@ -0,0 +1,81 @@
+#include "test_host_service.h"
+#include <string.h>
+#include <unistd.h>
+
+static void write_descriptor(PDP7_cpu* cpu, uint32_t descriptor, uint32_t operation, uint32_t address, uint32_t length) {
+    write_memory(cpu, descriptor + HOST_DESCRIPTOR_OPERATION, operation);
+    write_memory(cpu, descriptor + HOST_DESCRIPTOR_ADDRESS, address);
+    write_memory(cpu, descriptor + HOST_DESCRIPTOR_LENGTH, length);
+    cpu->accumulator = descriptor;
+}
+
+void test_host_service_write(void) {
+    char filename[] = "/tmp/pdp7_hostXXXXXX";
+    int fd = mkstemp(filename);
+    assert_(fd >= 0, "Failed to create temporary host output.");
+    close(fd);
+
+    host_service* host = create_host_service(filename, NULL);
+    PDP7_cpu cpu = create_empty_cpu();
+    attach_host_service(host, &cpu);
+
+    // Crosses a page boundary
+    write_memory(&cpu, 0377, 0777777);
+    write_memory(&cpu, 0400, 012);
+    write_memory(&cpu, 01000, 'h');
+    write_memory(&cpu, 01001, 0400 | 'i');
+
+    write_descriptor(&cpu, 0100, HOST_WRITE_OCTAL, 0377, 2);
+    cpu.ir = OP_IOT;
+    execute_instruction(&cpu, IOT_HSR);
+    assert_(cpu.accumulator == 2, "HSR does not return the words written.");
+    assert_(cpu.cycles == 2, "HSR did not steal one cycle per word.");
+
+    write_descriptor(&cpu, 0100, HOST_WRITE_TEXT, 01000, 2);
+    execute_instruction(&cpu, IOT_HSR);
+    write_descriptor(&cpu, 0100, HOST_RESULT, 0400, 1);
+    execute_instruction(&cpu, IOT_HSR);
+    assert_(host->has_result && host->result == 012, "HOST_RESULT did not report the word.");
+
+    write_descriptor(&cpu, 0100, 077, 0, 1);
+    execute_instruction(&cpu, IOT_HSR);
+    assert_(cpu.accumulator == HOST_ERROR, "Unknown operation does not report an error.");
+    assert_(cpu.trap == TRAP_NONE, "HSR trapped with the host service attached.");
+    destroy_host_service(host);
+
+    char text[64] = { 0 };
+    FILE* file = fopen(filename, "rb");
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    unlink(filename);
+    assert_(length == 16 && strcmp(text, "777777\n000012\nhi") == 0, "Host output does not hold the written words.");
+}
+
+void test_host_service_read(void) {
+    char filename[] = "/tmp/pdp7_hostXXXXXX";
+    int fd = mkstemp(filename);
+    assert_(fd >= 0, "Failed to create temporary host input.");
+    uint32_t words[3] = { 0123456, 0777777 | 01000000, 7 };
+    assert_(write(fd, words, sizeof(words)) == sizeof(words), "Failed to write host input.");
+    close(fd);
+
+    host_service* host = create_host_service(NULL, filename);
+    PDP7_cpu cpu = create_empty_cpu();
+
+    // Asks for more than the file holds, gets what there is
+    write_descriptor(&cpu, 0100, HOST_READ_WORDS, 0776, 10);
+    host_service_iot(host, &cpu, IOT_HSR);
+    assert_(cpu.accumulator == 3, "HSR does not return the words read.");
+    assert_(read_memory(&cpu, 0776) == 0123456, "Read words did not reach memory.");
+    assert_(read_memory(&cpu, 0777) == 0777777, "Read words are not masked to 18 bits.");
+    assert_(read_memory(&cpu, 01000) == 7, "Read did not continue on the next page.");
+    assert_(cpu.dirty[01000 / MEMORY_PAGE_WORDS], "Read did not mark its pages dirty.");
+
+    write_descriptor(&cpu, 0100, HOST_READ_WORDS, 0, 1);
+    host_service_iot(host, &cpu, IOT_HSR);
+    assert_(cpu.accumulator == 0, "Read past the end of the input transferred words.");
+
+    destroy_host_service(host);
+    unlink(filename);
+    free_memory(&cpu);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/host_service.h"
+
+void test_host_service_write(void);
+void test_host_service_read(void);
@@ -0,0 +1,42 @@
+#include "test_journal.h"
+#include <unistd.h>
+
+void test_journal_record_replay(void) {
+    char filename[] = "/tmp/pdp7_journalXXXXXX";
+    int fd = mkstemp(filename);
+    assert_(fd >= 0, "Failed to create temporary journal file.");
+    close(fd);
+
+    keyboard_device keyboard;
+    initialize_keyboard(&keyboard, false, false);
+    keyboard.record = open_journal(filename, false);
+
+    keyboard_push(&keyboard, 'A');
+    keyboard_flag(&keyboard, 100);
+    keyboard_read(&keyboard, 150);
+    keyboard_push(&keyboard, 'B');
+    keyboard_push(&keyboard, 'C');
+    keyboard_read(&keyboard, 500);
+    keyboard_read(&keyboard, 700);
+    assert_(keyboard.record->events == 3, "Recording did not log each key once.");
+    close_journal(keyboard.record, 1000);
+
+    initialize_keyboard(&keyboard, false, false);
+    keyboard.replay = open_journal(filename, true);
+    assert_(!keyboard_flag(&keyboard, 99) && keyboard_flag(&keyboard, 100), "Replayed key arrived at the wrong cycle.");
+    assert_(keyboard_read(&keyboard, 100) == 'A', "Replay returned the wrong first key.");
+    assert_(keyboard_read(&keyboard, 500) == 'B', "Replay returned the wrong second key.");
+    assert_(!keyboard_flag(&keyboard, 699) && keyboard_read(&keyboard, 700) == 'C', "Replay made a key visible early.");
+    assert_(!keyboard_flag(&keyboard, 999) && !keyboard.replay_over, "Replay ended before the recorded session.");
+
+    PDP7_cpu cpu = create_empty_cpu();
+    cpu.keyboard = &keyboard;
+    cpu.cycles = 1000;
+    cpu.ir = 070;
+    execute_instruction(&cpu, IOT_KSF);
+    assert_(!cpu.running, "Machine kept waiting for keys after the replayed session ended.");
+
+    close_journal(keyboard.replay, cpu.cycles);
+    free_memory(&cpu);
+    unlink(filename);
+}
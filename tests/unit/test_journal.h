@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/keyboard.h"
+#include "../../src/journal.h"
+
+void test_journal_record_replay(void);
@@ -0,0 +1,42 @@
+#include "test_keyboard.h"
+
+void test_keyboard_skip_on_flag(void) {
+    keyboard_device keyboard;
+    initialize_keyboard(&keyboard, false, false);
+    PDP7_cpu cpu = create_empty_cpu();
+    cpu.keyboard = &keyboard;
+
+    cpu.ir = 070;
+    execute_instruction(&cpu, IOT_KSF);
+    assert_(cpu.pc == 02000, "KSF skipped with an empty keyboard buffer.");
+
+    keyboard_push(&keyboard, 'A');
+    keyboard_push(&keyboard, 'B');
+
+    execute_instruction(&cpu, IOT_KSF);
+    assert_(cpu.pc == 02001, "KSF did not skip with a character waiting.");
+
+    execute_instruction(&cpu, IOT_KRB);
+    assert_(cpu.accumulator == 'A', "KRB did not read the first character.");
+    execute_instruction(&cpu, IOT_KRB);
+    assert_(cpu.accumulator == 'B', "KRB did not read the second character.");
+
+    execute_instruction(&cpu, IOT_KSF);
+    assert_(cpu.pc == 02001, "KSF skipped after the buffer was drained.");
+
+    execute_instruction(&cpu, IOT_KRB);
+    assert_(cpu.accumulator == 'B', "KRB did not keep the last character in the buffer.");
+}
+
+void test_keyboard_overrun(void) {
+    keyboard_device keyboard;
+    initialize_keyboard(&keyboard, false, false);
+
+    for (int i = 0; i < KEYBOARD_BUFFER_SIZE; i++) {
+        assert_(keyboard_push(&keyboard, (uint8_t)i), "Keyboard ring rejected a character before it was full.");
+    }
+    assert_(!keyboard_push(&keyboard, 'X'), "Keyboard ring accepted a character while full.");
+
+    assert_(keyboard_read(&keyboard, 0) == 0, "Keyboard ring did not return characters in order.");
+    assert_(keyboard_push(&keyboard, 'X'), "Keyboard ring did not reuse a freed slot.");
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/keyboard.h"
+
+void test_keyboard_skip_on_flag(void);
+void test_keyboard_overrun(void);
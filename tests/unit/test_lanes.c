@@ -0,0 +1,109 @@
+#include "test_lanes.h"
+
+// Every lane must end exactly where the interpreter leaves the same machine
+static void assert_lane_matches(const cpu_lanes* lanes, uint32_t lane, const PDP7_cpu* cpu) {
+    PDP7_cpu extracted = create_empty_cpu();
+    extract_lane(lanes, lane, &extracted);
+
+    assert_(extracted.accumulator == cpu->accumulator && extracted.link == cpu->link, "Lane registers differ from the interpreter.");
+    assert_(extracted.pc == cpu->pc && extracted.cycles == cpu->cycles, "Lane PC or cycles differ from the interpreter.");
+    assert_(extracted.running == cpu->running && extracted.trap == cpu->trap, "Lane stopped differently from the interpreter.");
+    for (uint32_t address = 0; address < MEMORY_SIZE; address++) {
+        assert_(read_memory(&extracted, address) == read_memory(cpu, address), "Lane memory differs from the interpreter.");
+    }
+    free_memory(&extracted);
+}
+
+void test_lanes_match_interpreter(void) {
+    PDP7_cpu image;
+    initialize_cpu(&image, "data/program.dat", "data/memory.dat", NULL, 02000);
+
+    // A Fibonacci sweep: each lane computes a different count of numbers,
+    // so the lanes leave the loop at different times
+    cpu_lanes* lanes = create_lanes(&image, PDP7_LANES - 1);
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        lane_write(lanes, lane, 0, 2 + lane);
+    }
+    // The last lane runs XCT and KSF, only KSF goes through the interpreter
+    lane_write(lanes, PDP7_LANES - 2, 02000, 0402002); // XCT 2002 -> LAC 0
+    lane_write(lanes, PDP7_LANES - 2, 02001, 0700301); // KSF, never skips without a keyboard
+
+    uint64_t instructions = run_lanes(lanes, 100000);
+    assert_(!lanes_running(lanes), "Lanes did not all halt.");
+    assert_(lanes->running[PDP7_LANES - 1] == 0 && lanes->cycles[PDP7_LANES - 1] == image.cycles,
+            "A lane beyond the group's count ran.");
+    assert_(lanes->groups < instructions, "Lanes did not share any dispatch.");
+    assert_(lanes->scalar_instructions == 1, "KSF did not take the interpreter.");
+
+    for (uint32_t lane = 0; lane < PDP7_LANES - 1; lane++) {
+        PDP7_cpu cpu = create_empty_cpu();
+        copy_cpu(&cpu, &image);
+        write_memory(&cpu, 0, 2 + lane);
+        if (lane == PDP7_LANES - 2) {
+            write_memory(&cpu, 02000, 0402002);
+            write_memory(&cpu, 02001, 0700301);
+        }
+        run_cycles(&cpu, 100000);
+        assert_lane_matches(lanes, lane, &cpu);
+        free_memory(&cpu);
+    }
+
+    destroy_lanes(lanes);
+    free_memory(&image);
+}
+
+void test_lanes_xct(void) {
+    static const uint32_t program[][2] = {
+        { 02000, 0420101 }, // XCT I 101, each lane's pointer picks its target
+        { 02001, 0400113 }, // XCT 113 -> DAC 104
+        { 02002, 0400114 }, // XCT 114 -> SAD 100, skips until AC reaches the limit
+        { 02003, 0600005 }, // JMP 2005
+        { 02004, 0600000 }, // JMP 2000
+        { 02005, 0400115 }, // XCT 115 -> KSF, a device IOT through XCT
+        { 02006, 0740040 }, // HLT
+        { 00102, 1 },
+        { 00103, 2 },
+        { 00110, 0340102 }, // TAD 102
+        { 00111, 0400112 }, // XCT 112, nested
+        { 00112, 0340103 }, // TAD 103
+        { 00113, 0040104 }, // DAC 104
+        { 00114, 0540100 }, // SAD 100
+        { 00115, 0700301 }, // KSF
+        { 00116, 0400116 }, // XCT 116, a chain that never ends
+    };
+    PDP7_cpu image = create_empty_cpu();
+    for (uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++) {
+        write_memory(&image, program[i][0], program[i][1]);
+    }
+
+    // Even lanes add 1 per pass, odd ones 2 through the nested XCT, up to
+    // a limit of their own. The last lane's pointer is the endless chain.
+    cpu_lanes* lanes = create_lanes(&image, PDP7_LANES);
+    PDP7_cpu cpus[PDP7_LANES];
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        uint32_t pointer = lane == PDP7_LANES - 1 ? 0116 : 0110 + lane % 2;
+        lane_write(lanes, lane, 0100, 2 * (lane + 3));
+        lane_write(lanes, lane, 0101, pointer);
+        cpus[lane] = create_empty_cpu();
+        copy_cpu(&cpus[lane], &image);
+        write_memory(&cpus[lane], 0100, 2 * (lane + 3));
+        write_memory(&cpus[lane], 0101, pointer);
+    }
+
+    uint64_t instructions = run_lanes(lanes, 100000);
+    assert_(!lanes_running(lanes), "XCT lanes did not all stop.");
+    assert_(lanes->groups < instructions, "XCT lanes did not share any dispatch.");
+    assert_(lanes->scalar_instructions == PDP7_LANES - 1, "Only the KSFs should take the interpreter.");
+    assert_(lanes->trap[PDP7_LANES - 1] == TRAP_XCT_LOOP, "The endless XCT chain did not trap.");
+
+    for (uint32_t lane = 0; lane < PDP7_LANES; lane++) {
+        run_cycles(&cpus[lane], 100000);
+        assert_lane_matches(lanes, lane, &cpus[lane]);
+        assert_(lanes->trap_pc[lane] == cpus[lane].trap_pc && lanes->trap_instruction[lane] == cpus[lane].trap_instruction,
+                "XCT lane trapped differently from the interpreter.");
+        free_memory(&cpus[lane]);
+    }
+
+    destroy_lanes(lanes);
+    free_memory(&image);
+}
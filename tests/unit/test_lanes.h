@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/lanes.h"
+
+void test_lanes_match_interpreter(void);
+void test_lanes_xct(void);
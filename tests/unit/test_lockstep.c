@@ -0,0 +1,66 @@
+#include "test_lockstep.h"
+
+static void faulty_step(PDP7_cpu* cpu);
+static uint64_t faulty_run(PDP7_cpu* cpu, uint64_t instructions);
+static void load_counter_program(PDP7_cpu* cpu);
+
+// Reference behaviour until the counter passes 5, then DAC stores one off
+static void faulty_step(PDP7_cpu* cpu) {
+    uint32_t pc = cpu->pc;
+    perform_cycle(cpu);
+    if (pc == 02002 && read_memory(cpu, 010) > 5) {
+        write_memory(cpu, 010, read_memory(cpu, 010) ^ 1);
+    }
+}
+
+static uint64_t faulty_run(PDP7_cpu* cpu, uint64_t instructions) {
+    uint64_t executed = 0;
+    for (; executed < instructions && cpu->running; executed++) {
+        faulty_step(cpu);
+    }
+    return executed;
+}
+
+static void load_counter_program(PDP7_cpu* cpu) {
+    write_memory(cpu, 02000, 0200010); // LAC 10
+    write_memory(cpu, 02001, 0340011); // TAD 11
+    write_memory(cpu, 02002, 0040010); // DAC 10
+    write_memory(cpu, 02003, 0600000); // JMP 0
+    write_memory(cpu, 011, 1);
+}
+
+void test_lockstep_matching_engines(void) {
+    PDP7_cpu cpu = create_empty_cpu();
+    load_counter_program(&cpu);
+
+    lockstep_checker* checker = create_lockstep(find_engine("reference"), 16, &cpu);
+    for (int i = 0; i < 4; i++) {
+        assert_(lockstep_run(checker, &cpu), "Reference engine diverged from itself.");
+    }
+    assert_(checker->checkpoints == 4, "Lockstep did not count its checkpoints.");
+    assert_(checker->instructions == 64, "Lockstep did not count checked instructions.");
+    assert_(read_memory(&cpu, 010) == 16, "Live machine did not run under lockstep.");
+
+    destroy_lockstep(checker);
+}
+
+void test_lockstep_finds_divergence(void) {
+    cpu_engine faulty = { "faulty", faulty_step, faulty_run };
+    PDP7_cpu cpu = create_empty_cpu();
+    load_counter_program(&cpu);
+
+    lockstep_checker* checker = create_lockstep(&faulty, 8, &cpu);
+    bool matched = true;
+    for (int i = 0; i < 8 && matched; i++) {
+        matched = lockstep_run(checker, &cpu);
+    }
+
+    assert_(!matched && checker->diverged, "Lockstep missed a faulty engine.");
+    assert_(!cpu.running, "Divergence did not stop the live machine.");
+    assert_(checker->reproduced, "Replay did not reproduce the divergence.");
+    assert_(checker->divergence_pc == 02002, "Divergence reported at the wrong PC.");
+    assert_(checker->divergence_instruction == 0040010, "Divergence reported the wrong instruction.");
+    assert_(checker->divergence_index == 22, "Divergence reported the wrong instruction number.");
+
+    destroy_lockstep(checker);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/lockstep.h"
+
+void test_lockstep_matching_engines(void);
+void test_lockstep_finds_divergence(void);
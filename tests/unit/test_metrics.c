@@ -0,0 +1,26 @@
+#include "test_metrics.h"
+
+void test_metrics_publish(void) {
+    live_metrics* metrics = create_metrics("/pdp7_test_metrics");
+    PDP7_cpu cpu = create_empty_cpu();
+    metrics_page snapshot;
+
+    for (int i = 0; i < 10; i++) {
+        metrics_instruction(metrics, 0200000, &cpu); // LAC
+    }
+    metrics_instruction(metrics, 0740040, &cpu); // HLT
+    metrics->io_words = 3;
+    cpu.cycles = 25;
+
+    assert_(metrics_read(metrics->page, &snapshot), "Metrics page could not be read.");
+    assert_(snapshot.instructions == 0, "Counters were published before the interval.");
+
+    metrics_publish(metrics, &cpu);
+    assert_(metrics_read(metrics->page, &snapshot), "Metrics page could not be read.");
+    assert_(snapshot.instructions == 11 && snapshot.cycles == 25, "Instruction or cycle counts were not published.");
+    assert_(snapshot.opcode_count[004] == 10 && snapshot.opcode_count[017] == 1, "Opcode counts were not published.");
+    assert_(snapshot.io_words == 3, "I/O word count was not published.");
+    assert_((atomic_load(&metrics->page->sequence) & 1) == 0, "Sequence was left odd after publishing.");
+
+    destroy_metrics(metrics);
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/metrics.h"
+
+void test_metrics_publish(void);
@@ -0,0 +1,53 @@
+#include "test_network.h"
+
+void test_serial_pacing(void) {
+    serial_line line;
+    initialize_serial(&line, 110);
+    PDP7_cpu sender = create_empty_cpu();
+    PDP7_cpu receiver = create_empty_cpu();
+    sender.line_out = &line;
+    receiver.line_in = &line;
+    uint64_t word_cycles = line.cycles_per_word;
+
+    sender.accumulator = 0123456;
+    sender.ir = 070;
+    execute_instruction(&sender, IOT_TLS);
+    sender.accumulator = 0654321;
+    execute_instruction(&sender, IOT_TLS);
+    assert_(sender.cycles == word_cycles, "Second TLS did not wait for the line to be free.");
+    assert_(line.words == 2, "Line did not carry both words.");
+
+    receiver.ir = 070;
+    execute_instruction(&receiver, IOT_KSF);
+    assert_(receiver.pc == 02000, "KSF skipped before the word had arrived.");
+
+    receiver.cycles = word_cycles;
+    execute_instruction(&receiver, IOT_KSF);
+    assert_(receiver.pc == 02001, "KSF did not skip once the word had arrived.");
+    execute_instruction(&receiver, IOT_KRB);
+    assert_(receiver.accumulator == 0123456, "KRB did not read the first word.");
+    execute_instruction(&receiver, IOT_KRB);
+    assert_(receiver.accumulator == 0123456, "KRB read a word still on the line.");
+
+    serial_close(&line);
+    assert_(!serial_drained(&line), "Line counted as drained with a word left.");
+    receiver.cycles = 2 * word_cycles;
+    execute_instruction(&receiver, IOT_KRB);
+    assert_(receiver.accumulator == 0654321 && serial_drained(&line), "Line was not drained after the last word.");
+
+    free_memory(&sender);
+    free_memory(&receiver);
+}
+
+void test_network_chain(void) {
+    pdp7_network* network = load_network("data/network.topology");
+    run_network(network);
+
+    network_machine* sum = find_machine(network, "sum");
+    assert_(find_machine(network, "fib")->outcome == MACHINE_HALTED, "Sending machine did not halt.");
+    assert_(sum->outcome == MACHINE_DRAINED, "Receiving machine was not stopped by its drained line.");
+    assert_(read_memory(&sum->pdp7.cpu, 0101) == 26, "Receiving machine missed words.");
+    assert_(read_memory(&sum->pdp7.cpu, 0100) == 0754263, "Receiving machine summed the wrong words.");
+
+    destroy_network(network);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/network.h"
+#include "../../src/iot_bus.h"
+
+void test_serial_pacing(void);
+void test_network_chain(void);
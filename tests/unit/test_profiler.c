@@ -0,0 +1,35 @@
+#include "test_profiler.h"
+
+void test_profiler_counts(void) {
+    guest_profiler* profiler = create_profiler("/dev/null", 02000);
+
+    profiler_record(profiler, 02000, 0200010, 02001, 2); // LAC
+    profiler_record(profiler, 02001, 0741200, 02003, 1); // SNA, skipped
+    profiler_record(profiler, 02003, 0100020, 02021, 2); // JMS
+    profiler_record(profiler, 02021, 0200010, 02022, 2); // LAC
+    profiler_record(profiler, 02022, 0600004, 02004, 1); // JMP back to the return address
+
+    assert_(profiler->count[02000] == 1 && profiler->cycles[02000] == 2, "Per-address counters are wrong.");
+    assert_(profiler->taken[02001] == 1, "Taken skip was not counted.");
+    assert_(profiler->taken[02000] == 0, "Fall through was counted as taken.");
+    assert_(profiler->opcode_count[004] == 2 && profiler->opcode_cycles[004] == 4, "Per-opcode totals are wrong.");
+    assert_(profiler->frame_count == 2, "JMS did not open a call frame.");
+    assert_(profiler->frames[1].address == 02021 && profiler->frames[1].cycles == 3, "Subroutine frame cycles are wrong.");
+    assert_(profiler->depth == 0, "Returning JMP did not close the call frame.");
+    assert_(profiler->frames[0].cycles == 5, "Root frame cycles are wrong.");
+
+    destroy_profiler(profiler);
+}
+
+void test_profiler_labels(void) {
+    guest_profiler* profiler = create_profiler("/dev/null", 02000);
+
+    profiler_load_labels(profiler, "tests/fixtures/data/labeled_program.dat", 02000);
+
+    assert_(profiler->labels[02000] && strcmp(profiler->labels[02000], "START") == 0, "Entry label was not loaded.");
+    assert_(profiler->labels[02003] && strcmp(profiler->labels[02003], "SUB") == 0, "Subroutine label was not loaded.");
+    assert_(profiler->labels[02001] == NULL, "Label leaked onto the following word.");
+    assert_(profiler->comments[02004] && strcmp(profiler->comments[02004], "CLA") == 0, "Line comment was not loaded.");
+
+    destroy_profiler(profiler);
+}
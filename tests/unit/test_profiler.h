@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/profiler.h"
+#include <string.h>
+
+void test_profiler_counts(void);
+void test_profiler_labels(void);
@@ -0,0 +1,67 @@
+#include "test_result_cache.h"
+#include <unistd.h>
+
+void test_batch_run(void) {
+    PDP7_cpu image;
+    initialize_cpu(&image, "tests/fixtures/data/key_program.dat", NULL, NULL, 0);
+    batch_job job = { &image, (const uint8_t*)"A", 1, 1000 };
+    batch_result result;
+
+    run_batch(&job, &result);
+    assert_(!result.running && result.trap == TRAP_NONE, "Batch run did not halt.");
+    assert_(result.change_count == 1, "Batch run does not report exactly the word it stored.");
+    assert_(result.changes[0].address == 0100 && result.changes[0].word == 'A', "Batch run lost the key it stored.");
+    assert_(read_memory(&image, 0100) == 0, "Batch run wrote to the image.");
+    free_batch_result(&result);
+
+    // No input left: the KSF loop stops the machine instead of spinning
+    job.input_size = 0;
+    run_batch(&job, &result);
+    assert_(!result.running && result.change_count == 0, "Batch run without input did not stop.");
+    free_batch_result(&result);
+    free_memory(&image);
+}
+
+void test_result_cache(void) {
+    char directory[] = "/tmp/pdp7_cacheXXXXXX";
+    assert_(mkdtemp(directory) != NULL, "Failed to create a temporary cache directory.");
+
+    PDP7_cpu image;
+    initialize_cpu(&image, "tests/fixtures/data/key_program.dat", NULL, NULL, 0);
+    batch_job job = { &image, (const uint8_t*)"A", 1, 1000 };
+    batch_result result, cached;
+
+    result_cache* cache = open_result_cache(directory, 0);
+    cache_key key = batch_key(cache, &job);
+    assert_(!cache_lookup(cache, key, &cached), "Empty cache returned a result.");
+
+    run_batch(&job, &result);
+    cache_store(cache, key, &result);
+    close_result_cache(cache);
+
+    // Found again by a later process on the same binary
+    cache = open_result_cache(directory, 0);
+    assert_(cache_lookup(cache, batch_key(cache, &job), &cached), "Stored result was not found.");
+    assert_(batch_results_equal(&result, &cached), "Cached result differs from the run.");
+    free_batch_result(&cached);
+
+    job.input = (const uint8_t*)"B";
+    assert_(!cache_lookup(cache, batch_key(cache, &job), &cached), "A different input hit the cache.");
+    job.input = (const uint8_t*)"A";
+    job.cycles = 2000;
+    assert_(!cache_lookup(cache, batch_key(cache, &job), &cached), "A different budget hit the cache.");
+
+    clear_result_cache(cache);
+    assert_(!cache_lookup(cache, key, &cached), "Cleared cache returned a result.");
+
+    close_result_cache(cache);
+    free_batch_result(&result);
+    free_memory(&image);
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/index", directory);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/results", directory);
+    unlink(path);
+    rmdir(directory);
+}
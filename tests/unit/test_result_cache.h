@@ -0,0 +1,8 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/result_cache.h"
+
+void test_batch_run(void);
+void test_result_cache(void);
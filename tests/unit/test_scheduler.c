@@ -0,0 +1,43 @@
+#include "test_scheduler.h"
+#include <string.h>
+
+void count_step(void* device, PDP7_cpu* cpu);
+uint64_t run_fibonacci(char* output, size_t size, uint64_t* steps);
+
+void count_step(void* device, PDP7_cpu* cpu) {
+    (void)cpu;
+    (*(uint64_t*)device)++;
+}
+
+// Runs the sample program scheduled, returns its cycle count
+uint64_t run_fibonacci(char* output, size_t size, uint64_t* steps) {
+    PDP7_cpu cpu;
+    cpu_scheduler scheduler;
+    uint32_t io_buffer = 0;
+    FILE* file = tmpfile();
+
+    initialize_cpu(&cpu, "data/program.dat", "data/memory.dat", &io_buffer, 02000);
+    initialize_scheduler(&scheduler, &cpu, NULL, file);
+    schedule_device(&scheduler, "counter", count_step, steps, 100);
+    run_scheduler(&scheduler, false);
+
+    assert_(scheduler.output_words == 26, "Scheduler did not deliver every TLS word.");
+    rewind(file);
+    output[fread(output, 1, size - 1, file)] = '\0';
+    fclose(file);
+    free_memory(&cpu);
+    return cpu.cycles;
+}
+
+void test_scheduler_deterministic_output(void) {
+    char first[1024], second[1024];
+    uint64_t first_steps = 0, second_steps = 0;
+
+    uint64_t first_cycles = run_fibonacci(first, sizeof(first), &first_steps);
+    uint64_t second_cycles = run_fibonacci(second, sizeof(second), &second_steps);
+
+    assert_(first_cycles == 939 && second_cycles == 939, "Scheduled runs took different cycle counts.");
+    assert_(strcmp(first, second) == 0, "Scheduled runs printed different output.");
+    assert_(strncmp(first, "000001\n000002\n000003\n", 21) == 0, "Scheduled run printed the wrong words.");
+    assert_(first_steps == 9 && first_steps == second_steps, "Device was not stepped every 100 cycles.");
+}
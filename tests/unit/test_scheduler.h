@@ -0,0 +1,7 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/scheduler.h"
+
+void test_scheduler_deterministic_output(void);
@@ -0,0 +1,104 @@
+#include "test_storage.h"
+#include <unistd.h>
+
+static void create_storage(block_storage* storage, char* filename) {
+    int fd = mkstemp(filename);
+    assert_(fd >= 0, "Failed to create temporary storage file.");
+    close(fd);
+
+    initialize_storage(storage, filename);
+}
+
+static void load_ac_and_iot(PDP7_cpu* cpu, block_storage* storage, uint32_t value, uint32_t instruction) {
+    cpu->accumulator = value;
+    storage_iot(storage, cpu, instruction);
+}
+
+void test_storage_write_read(void) {
+    char filename[] = "/tmp/pdp7_storageXXXXXX";
+    block_storage storage;
+    create_storage(&storage, filename);
+    PDP7_cpu cpu = create_empty_cpu();
+
+    assert_(storage.blocks == STORAGE_DEFAULT_BLOCKS, "Empty storage file is not sized to the default block count.");
+
+    for (uint32_t i = 0; i < 300; i++) {
+        write_memory(&cpu, 0100 + i, 0700000 | i);
+    }
+
+    load_ac_and_iot(&cpu, &storage, 3, IOT_DSLB);
+    load_ac_and_iot(&cpu, &storage, 0100, IOT_DSLA);
+    load_ac_and_iot(&cpu, &storage, 300, IOT_DSLC);
+    storage_iot(&storage, &cpu, IOT_DSWR);
+
+    assert_(storage.flag, "Storage flag is not set after a write.");
+    assert_(cpu.cycles == 300, "Write did not steal one cycle per word.");
+    assert_(storage.words[3 * STORAGE_BLOCK_WORDS + 299] == (0700000 | 299), "Write did not reach the backing store.");
+
+    for (uint32_t i = 0; i < 300; i++) {
+        write_memory(&cpu, 04000 + i, 0);
+    }
+
+    storage_iot(&storage, &cpu, IOT_DSCF);
+    load_ac_and_iot(&cpu, &storage, 3, IOT_DSLB);
+    load_ac_and_iot(&cpu, &storage, 04000, IOT_DSLA);
+    storage_iot(&storage, &cpu, IOT_DSRD);
+
+    uint32_t pc = cpu.pc;
+    cpu.storage = &storage;
+    cpu.ir = OP_IOT;
+    execute_instruction(&cpu, IOT_DSSF);
+    assert_(cpu.pc == pc + 1, "DSSF does not skip when the flag is set.");
+
+    for (uint32_t i = 0; i < 300; i++) {
+        assert_(read_memory(&cpu, 04000 + i) == (0700000 | i), "Read did not transfer the stored words.");
+    }
+
+    close_storage(&storage);
+    unlink(filename);
+}
+
+void test_storage_out_of_range(void) {
+    char filename[] = "/tmp/pdp7_storageXXXXXX";
+    block_storage storage;
+    create_storage(&storage, filename);
+    PDP7_cpu cpu = create_empty_cpu();
+
+    load_ac_and_iot(&cpu, &storage, STORAGE_DEFAULT_BLOCKS, IOT_DSLB);
+    load_ac_and_iot(&cpu, &storage, 1, IOT_DSLC);
+    storage_iot(&storage, &cpu, IOT_DSRD);
+    storage_iot(&storage, &cpu, IOT_DSRS);
+
+    assert_(cpu.accumulator & STORAGE_STATUS_ERROR, "Out of range transfer does not report an error.");
+    assert_(cpu.accumulator & STORAGE_STATUS_FLAG, "Out of range transfer does not set the flag.");
+    assert_(cpu.cycles == 0, "Out of range transfer stole cycles.");
+
+    close_storage(&storage);
+    unlink(filename);
+}
+
+void test_storage_read_masks_high_bits(void) {
+    char filename[] = "/tmp/pdp7_storageXXXXXX";
+    block_storage storage;
+    create_storage(&storage, filename);
+    PDP7_cpu cpu = create_empty_cpu();
+
+    // A host file can hold anything in a word, core only keeps 18 bits
+    for (uint32_t i = 0; i < 300; i++) {
+        storage.words[5 * STORAGE_BLOCK_WORDS + i] = 0xFFF00000 | i;
+    }
+
+    load_ac_and_iot(&cpu, &storage, 5, IOT_DSLB);
+    load_ac_and_iot(&cpu, &storage, 077700, IOT_DSLA);
+    load_ac_and_iot(&cpu, &storage, 300, IOT_DSLC);
+    storage_iot(&storage, &cpu, IOT_DSRD);
+
+    for (uint32_t i = 0; i < 300; i++) {
+        assert_(read_memory(&cpu, 077700 + i) == ((0xFFF00000 | i) & 0777777), "Read put more than 18 bits into core.");
+    }
+    assert_(storage.words[5 * STORAGE_BLOCK_WORDS] == 0xFFF00000, "Read changed the backing store.");
+    assert_(cpu.cycles == 300, "Read did not steal one cycle per word.");
+
+    close_storage(&storage);
+    unlink(filename);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/storage.h"
+
+void test_storage_write_read(void);
+void test_storage_out_of_range(void);
+void test_storage_read_masks_high_bits(void);
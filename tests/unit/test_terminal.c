@@ -0,0 +1,53 @@
+#include "test_terminal.h"
+#include <string.h>
+
+void test_terminal_diff_updates(void) {
+    FILE* file = tmpfile();
+    terminal_screen* terminal = create_terminal(file, false);
+    char output[64];
+    long start;
+
+    terminal_char(terminal, 0, 0, 'A');
+    start = ftell(file);
+    size_t length = terminal_flush(terminal);
+    fseek(file, start, SEEK_SET);
+    output[fread(output, 1, length, file)] = '\0';
+    assert_(strcmp(output, "\x1b[1;1HA") == 0, "First frame did not place the character.");
+
+    assert_(terminal_flush(terminal) == 0, "Unchanged frame was sent again.");
+
+    terminal_char(terminal, TERMINAL_CELL_WIDTH, 0, 'B');
+    start = ftell(file);
+    length = terminal_flush(terminal);
+    fseek(file, start, SEEK_SET);
+    output[fread(output, 1, length, file)] = '\0';
+    assert_(strcmp(output, "B") == 0, "Adjacent cell was sent with a cursor move.");
+
+    // Control codes and NUL never reach the real terminal
+    terminal_char(terminal, 2 * TERMINAL_CELL_WIDTH, 0, '\x1b');
+    terminal_char(terminal, 3 * TERMINAL_CELL_WIDTH, 0, '\0');
+    start = ftell(file);
+    length = terminal_flush(terminal);
+    fseek(file, start, SEEK_SET);
+    output[fread(output, 1, length, file)] = '\0';
+    assert_(length == 2 && strcmp(output, "??") == 0, "Control characters were sent to the terminal.");
+
+    terminal_point(terminal, 0, TERMINAL_CELL_HEIGHT, true);
+    terminal_point(terminal, TERMINAL_DOT_WIDTH, TERMINAL_CELL_HEIGHT + 3 * TERMINAL_DOT_HEIGHT, true);
+    assert_(terminal->screen[TERMINAL_COLUMNS] == (TERMINAL_DOTS | 0x81), "Points set the wrong braille dots.");
+    start = ftell(file);
+    length = terminal_flush(terminal);
+    fseek(file, start, SEEK_SET);
+    output[fread(output, 1, length, file)] = '\0';
+    assert_(strcmp(output, "\x1b[2;1H\xe2\xa2\x81") == 0, "Braille cell was not sent as UTF-8.");
+
+    terminal_point(terminal, 0, TERMINAL_CELL_HEIGHT, false);
+    terminal_point(terminal, TERMINAL_DOT_WIDTH, TERMINAL_CELL_HEIGHT + 3 * TERMINAL_DOT_HEIGHT, false);
+    assert_(terminal->screen[TERMINAL_COLUMNS] == 0, "Unlit points did not clear their dots.");
+
+    terminal_line(terminal, 0, 0, 4 * TERMINAL_CELL_WIDTH - 1, 0, true);
+    assert_(terminal->screen[3] == (TERMINAL_DOTS | 0x09), "Line did not reach its end cell.");
+
+    destroy_terminal(terminal);
+    fclose(file);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include "../utils/unit_utils.h"
+#include "../../src/terminal.h"
+
+void test_terminal_diff_updates(void);
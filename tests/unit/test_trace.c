@@ -0,0 +1,52 @@
+#include "test_trace.h"
+#include <string.h>
+#include <unistd.h>
+
+void test_trace_ring_dump(void) {
+    char filename[] = "/tmp/pdp7_traceXXXXXX";
+    int fd = mkstemp(filename);
+    assert_(fd >= 0, "Failed to create temporary trace file.");
+    close(fd);
+
+    PDP7_cpu cpu = create_empty_cpu();
+    trace_buffer* trace = create_trace(filename, 4, false);
+
+    for (uint32_t i = 0; i < 6; i++) {
+        cpu.accumulator = i;
+        cpu.cycles = i * 2;
+        cpu.link = i & 1;
+        trace_instruction(trace, 02000 + i, 0200000 | i, &cpu);
+    }
+    trace_dump(trace);
+    destroy_trace(trace);
+
+    FILE* file = fopen(filename, "rb");
+    char magic[8];
+    uint32_t record_size;
+    trace_record records[5];
+    assert_(fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, TRACE_MAGIC, 8) == 0, "Trace header is missing.");
+    assert_(fread(&record_size, sizeof(record_size), 1, file) == 1 && record_size == sizeof(trace_record), "Trace record size is wrong.");
+    assert_(fread(records, sizeof(trace_record), 5, file) == 4, "Dump did not write exactly one ring of records.");
+    fclose(file);
+    unlink(filename);
+
+    assert_(records[0].pc == 02002 && records[0].accumulator == 2, "Dump did not start at the oldest record kept.");
+    assert_(records[3].pc == 02005 && records[3].cycles == 10, "Dump did not end at the newest record.");
+    assert_((records[3].instruction & TRACE_LINK_BIT) && (records[3].instruction & 0777777) == 0200005, "Link or instruction was not packed.");
+}
+
+void test_disassemble(void) {
+    char text[32];
+
+    disassemble_instruction(0220010, text, sizeof(text));
+    assert_(strcmp(text, "LAC I 00010") == 0, "Indirect memory reference was not disassembled.");
+
+    disassemble_instruction(0741200, text, sizeof(text));
+    assert_(strcmp(text, "SNA") == 0, "Operate instruction was not disassembled.");
+
+    disassemble_instruction(0700301, text, sizeof(text));
+    assert_(strcmp(text, "KSF") == 0, "I/O instruction was not disassembled.");
+
+    disassemble_instruction(0707777, text, sizeof(text));
+    assert_(strcmp(text, "707777") == 0, "Unknown instruction was not printed as octal.");
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../fixtures/sample_cpus.h"
+#include "../utils/unit_utils.h"
+#include "../../src/trace.h"
+#include "../../src/disassembler.h"
+
+void test_trace_ring_dump(void);
+void test_disassemble(void);
@@ -0,0 +1,182 @@
+#include "batch.h"
+#include "result_cache.h"
+#include "engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Runs one loaded program once per input file, headless, and reports how
+// each run ended. With -C the results go through an on-disk cache keyed by
+// everything a run depends on, so repeated sweeps become lookups.
+
+#define BATCH_DEFAULT_CYCLES 10000000
+
+int main(int argc, char *argv[]);
+uint64_t next_random(uint64_t* state);
+uint8_t* read_input(const char* filename, size_t* size);
+void print_result(const char* name, const batch_result* result, bool cached, bool words);
+
+uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+uint8_t* read_input(const char* filename, size_t* size) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to read %s\n", filename);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* data = malloc(length > 0 ? length : 1);
+    if (!data) {
+        fprintf(stderr, "Failed to allocate input %s\n", filename);
+        exit(1);
+    }
+    *size = length > 0 ? fread(data, 1, length, file) : 0;
+    fclose(file);
+    return data;
+}
+
+void print_result(const char* name, const batch_result* result, bool cached, bool words) {
+    const char* outcome = result->trap != TRAP_NONE ? "trapped" : result->running ? "cycle limit" : "stopped";
+    printf("%s: %s after %" PRIu64 " cycles, PC %05" PRIo32 " AC %06" PRIo32 ", %" PRIu32 " output words, %" PRIu32
+           " words changed%s\n", name, outcome, result->cycles, result->pc, result->accumulator, result->output_count,
+           result->change_count, cached ? " (cached)" : "");
+    if (!words) {
+        return;
+    }
+    for (uint32_t i = 0; i < result->output_count; i++) {
+        printf("%06" PRIo32 "%c", result->output[i], i % 8 == 7 || i + 1 == result->output_count ? '\n' : ' ');
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char* program_file = NULL;
+    const char* memory_file = NULL;
+    const char* cache_directory = NULL;
+    uint32_t start_address = INSTRUCTION_START;
+    uint8_t model = MODEL_PDP7;
+    uint64_t cycles = BATCH_DEFAULT_CYCLES;
+    uint64_t cache_bytes = 0;
+    double verify = 0;
+    uint64_t random = 0x9e3779b97f4a7c15ULL;
+    bool clear = false;
+    bool words = false;
+    int first_input = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            program_file = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            memory_file = argv[++i];
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            start_address = strtol(argv[++i], NULL, 8);
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc) {
+            model = find_model(argv[++i]);
+            if (!model) {
+                fprintf(stderr, "Unknown model %s, available: %s\n", argv[i], model_names());
+                return EXIT_FAILURE;
+            }
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cycles = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            cache_directory = argv[++i];
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            cache_bytes = strtoull(argv[++i], NULL, 10) << 20;
+        } else if (strcmp(argv[i], "-V") == 0 && i + 1 < argc) {
+            verify = strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            random = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (strcmp(argv[i], "-X") == 0) {
+            clear = true;
+        } else if (strcmp(argv[i], "-w") == 0) {
+            words = true;
+        } else if (argv[i][0] != '-') {
+            first_input = i;
+            break;
+        } else {
+            program_file = NULL;
+            break;
+        }
+    }
+
+    if (program_file == NULL) {
+        fprintf(stderr, "Usage: %s -p <program file> [-m <memory file>] [-a <start address>] [-M <model>] "
+                        "[-c <cycles>] [-C <cache directory> [-S <cache MB>] [-V <verify fraction>] [-s <seed>] [-X]] "
+                        "[-w] [<input file>...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    PDP7_cpu image;
+    initialize_cpu(&image, program_file, memory_file, NULL, start_address);
+    image.model = model;
+
+    result_cache* cache = NULL;
+    if (cache_directory) {
+        cache = open_result_cache(cache_directory, cache_bytes);
+        if (clear) {
+            clear_result_cache(cache);
+        }
+    }
+
+    // No input files is one run without input
+    uint32_t jobs = 0, cached = 0, verified = 0, mismatched = 0;
+    for (int i = first_input; i < argc || (jobs == 0 && i == argc); i++) {
+        const char* name = i < argc ? argv[i] : program_file;
+        batch_job job = { &image, NULL, 0, cycles };
+        uint8_t* input = i < argc ? read_input(argv[i], &job.input_size) : NULL;
+        job.input = input;
+        jobs++;
+
+        batch_result result;
+        if (!cache) {
+            run_batch(&job, &result);
+            print_result(name, &result, false, words);
+            free_batch_result(&result);
+            free(input);
+            continue;
+        }
+
+        cache_key key = batch_key(cache, &job);
+        bool hit = cache_lookup(cache, key, &result);
+        if (hit && verify > 0 && (next_random(&random) >> 11) * 0x1.0p-53 < verify) {
+            // Sampled: run it anyway, a different result replaces the entry
+            batch_result fresh;
+            run_batch(&job, &fresh);
+            verified++;
+            if (!batch_results_equal(&result, &fresh)) {
+                fprintf(stderr, "%s: cached result differs from a rerun, replaced\n", name);
+                mismatched++;
+                cache_store(cache, key, &fresh);
+                free_batch_result(&result);
+                result = fresh;
+                hit = false;
+            } else {
+                free_batch_result(&fresh);
+            }
+        } else if (!hit) {
+            run_batch(&job, &result);
+            cache_store(cache, key, &result);
+        }
+
+        cached += hit;
+        print_result(name, &result, hit, words);
+        free_batch_result(&result);
+        free(input);
+    }
+
+    if (cache) {
+        printf("%" PRIu32 " jobs: %" PRIu32 " cached, %" PRIu32 " run, %" PRIu32 " verified, %" PRIu32
+               " mismatched\n", jobs, cached, jobs - cached, verified, mismatched);
+        close_result_cache(cache);
+    }
+    free_memory(&image);
+    return mismatched ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+#include "fuzz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <inttypes.h>
+
+// Fuzzes guest code: each input pokes memory and types keys into a reset
+// copy of the loaded program, which then runs for a cycle budget. Built as
+// a standalone mutator by default, or as a libFuzzer target with
+// -DPDP7_LIBFUZZER (make fuzz-libfuzzer).
+
+#define FUZZ_MAX_INPUT 256
+#define FUZZ_CORPUS_SIZE 256
+#define FUZZ_SIGNATURES 4096 // Must be a power of two
+#define FUZZ_SIGNATURE_PROBES 16
+
+#ifdef PDP7_LIBFUZZER
+
+int LLVMFuzzerInitialize(int* argc, char*** argv);
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static pdp7_fuzzer* fuzzer;
+
+// libFuzzer owns argv, so the machine is configured from the environment
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    const char* program_file = getenv("PDP7_FUZZ_PROGRAM");
+    const char* memory_file = getenv("PDP7_FUZZ_MEMORY");
+    const char* start = getenv("PDP7_FUZZ_START");
+    const char* cycles = getenv("PDP7_FUZZ_CYCLES");
+
+    if (!program_file) {
+        fprintf(stderr, "Set PDP7_FUZZ_PROGRAM (and optionally PDP7_FUZZ_MEMORY, PDP7_FUZZ_START, PDP7_FUZZ_CYCLES)\n");
+        exit(1);
+    }
+    fuzzer = create_fuzzer(program_file, memory_file, start ? strtol(start, NULL, 8) : INSTRUCTION_START,
+                           cycles ? strtoull(cycles, NULL, 10) : FUZZ_DEFAULT_CYCLES);
+    return 0;
+}
+
+// A trap is the finding, so it is turned into the crash libFuzzer records
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (fuzz_run(fuzzer, data, size) == FUZZ_TRAP) {
+        print_trap(&fuzzer->cpu);
+        abort();
+    }
+    return 0;
+}
+
+#else
+
+static const char* OUTCOME_NAMES[] = { "halt", "trap", "timeout" };
+
+typedef struct {
+    uint8_t data[FUZZ_MAX_INPUT];
+    size_t size;
+} fuzz_input;
+
+int main(int argc, char *argv[]);
+uint64_t next_random(uint64_t* state);
+void mutate(fuzz_input* input, const fuzz_input* corpus, uint32_t corpus_size, uint64_t* random);
+bool new_signature(uint32_t* signatures, const PDP7_cpu* cpu, fuzz_outcome outcome);
+void save_trap(const char* directory, const PDP7_cpu* cpu, const fuzz_input* input);
+bool read_input(const char* filename, fuzz_input* input);
+
+uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// One or a few of: flip a bit, overwrite a byte, insert a poke or a key,
+// truncate, or splice in the tail of another corpus entry
+void mutate(fuzz_input* input, const fuzz_input* corpus, uint32_t corpus_size, uint64_t* random) {
+    int rounds = 1 + next_random(random) % 4;
+
+    for (int round = 0; round < rounds; round++) {
+        uint64_t choice = next_random(random);
+        size_t position = input->size ? next_random(random) % input->size : 0;
+
+        switch (choice % 6) {
+            case 0:
+                if (input->size) {
+                    input->data[position] ^= 1 << (next_random(random) % 8);
+                }
+                break;
+            case 1:
+                if (input->size) {
+                    input->data[position] = (uint8_t)next_random(random);
+                }
+                break;
+            case 2:
+                if (input->size + FUZZ_POKE_BYTES <= FUZZ_MAX_INPUT) {
+                    uint64_t poke = next_random(random);
+                    for (int i = 0; i < FUZZ_POKE_BYTES; i++) {
+                        input->data[input->size + i] = (uint8_t)(poke >> (8 * i));
+                    }
+                    input->data[input->size] &= ~FUZZ_KEY_FLAG;
+                    input->size += FUZZ_POKE_BYTES;
+                }
+                break;
+            case 3:
+                if (input->size < FUZZ_MAX_INPUT) {
+                    input->data[input->size++] = FUZZ_KEY_FLAG | (uint8_t)next_random(random);
+                }
+                break;
+            case 4:
+                input->size = position;
+                break;
+            case 5: {
+                const fuzz_input* other = &corpus[next_random(random) % corpus_size];
+                size_t from = other->size ? next_random(random) % other->size : 0;
+                size_t length = other->size - from;
+                if (position + length > FUZZ_MAX_INPUT) {
+                    length = FUZZ_MAX_INPUT - position;
+                }
+                memcpy(&input->data[position], &other->data[from], length);
+                input->size = position + length;
+                break;
+            }
+        }
+    }
+}
+
+// Coarse behaviour signature: how the run ended, where, and with which AC.
+// Inputs producing one not seen before are kept in the corpus. Once the
+// probe window around a signature is full it counts as seen.
+bool new_signature(uint32_t* signatures, const PDP7_cpu* cpu, fuzz_outcome outcome) {
+    uint32_t signature = (outcome << 28) ^ (cpu->trap << 24) ^ (cpu->pc << 9) ^ (cpu->accumulator >> 9) ^ 1;
+    uint32_t slot = (signature * 2654435761u) & (FUZZ_SIGNATURES - 1);
+
+    for (int probe = 0; probe < FUZZ_SIGNATURE_PROBES; probe++) {
+        if (signatures[slot] == signature) {
+            return false;
+        }
+        if (signatures[slot] == 0) {
+            signatures[slot] = signature;
+            return true;
+        }
+        slot = (slot + 1) & (FUZZ_SIGNATURES - 1);
+    }
+    return false;
+}
+
+void save_trap(const char* directory, const PDP7_cpu* cpu, const fuzz_input* input) {
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s/trap-%06" PRIo32 "-at-%05" PRIo32 ".bin", directory,
+             cpu->trap_instruction, cpu->trap_pc);
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "Failed to write %s\n", filename);
+        return;
+    }
+    fwrite(input->data, 1, input->size, file);
+    fclose(file);
+}
+
+bool read_input(const char* filename, fuzz_input* input) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return false;
+    }
+    input->size = fread(input->data, 1, FUZZ_MAX_INPUT, file);
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char* program_file = NULL;
+    const char* memory_file = NULL;
+    const char* trap_directory = NULL;
+    const char* replay_file = NULL;
+    uint32_t start_address = INSTRUCTION_START;
+    uint64_t cycles = FUZZ_DEFAULT_CYCLES;
+    uint64_t iterations = 1000000;
+    uint64_t random = 0x9e3779b97f4a7c15ULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            program_file = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            memory_file = argv[++i];
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            start_address = strtol(argv[++i], NULL, 8);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cycles = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            random = strtoull(argv[++i], NULL, 10) | 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            trap_directory = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else {
+            program_file = NULL;
+            break;
+        }
+    }
+
+    if (program_file == NULL) {
+        fprintf(stderr, "Usage: %s -p <program file> [-m <memory file>] [-a <start address>] [-c <cycles per input>] "
+                        "[-n <iterations>] [-s <seed>] [-o <trap directory>] [-r <input to replay>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    pdp7_fuzzer* fuzzer = create_fuzzer(program_file, memory_file, start_address, cycles);
+
+    if (replay_file) {
+        fuzz_input input;
+        if (!read_input(replay_file, &input)) {
+            fprintf(stderr, "Failed to read %s\n", replay_file);
+            return EXIT_FAILURE;
+        }
+        fuzz_outcome outcome = fuzz_run(fuzzer, input.data, input.size);
+        printf("%s after %" PRIu64 " cycles, PC %05" PRIo32 " AC %06" PRIo32 "\n", OUTCOME_NAMES[outcome],
+               fuzzer->cpu.cycles, fuzzer->cpu.pc, fuzzer->cpu.accumulator);
+        print_trap(&fuzzer->cpu);
+        destroy_fuzzer(fuzzer);
+        return EXIT_SUCCESS;
+    }
+
+    static fuzz_input corpus[FUZZ_CORPUS_SIZE];
+    static uint32_t signatures[FUZZ_SIGNATURES];
+    uint32_t corpus_size = 1; // Starts with the empty input
+    uint32_t corpus_next = 1;
+    uint64_t traps_saved = 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint64_t n = 0; n < iterations; n++) {
+        fuzz_input input = corpus[next_random(&random) % corpus_size];
+        mutate(&input, corpus, corpus_size, &random);
+
+        fuzz_outcome outcome = fuzz_run(fuzzer, input.data, input.size);
+        if (!new_signature(signatures, &fuzzer->cpu, outcome)) {
+            continue;
+        }
+
+        corpus[corpus_next] = input;
+        corpus_next = corpus_next + 1 < FUZZ_CORPUS_SIZE ? corpus_next + 1 : 1;
+        corpus_size = corpus_size < FUZZ_CORPUS_SIZE ? corpus_size + 1 : corpus_size;
+
+        if (outcome == FUZZ_TRAP) {
+            printf("Trap on %06" PRIo32 " at %05" PRIo32 " (input %zu bytes)\n", fuzzer->cpu.trap_instruction,
+                   fuzzer->cpu.trap_pc, input.size);
+            if (trap_directory) {
+                save_trap(trap_directory, &fuzzer->cpu, &input);
+                traps_saved++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%" PRIu64 " runs in %.2f s (%.0f runs/s): %" PRIu64 " halt, %" PRIu64 " trap, %" PRIu64 " timeout\n",
+           fuzzer->runs, seconds, fuzzer->runs / seconds, fuzzer->outcomes[FUZZ_HALT],
+           fuzzer->outcomes[FUZZ_TRAP], fuzzer->outcomes[FUZZ_TIMEOUT]);
+    printf("Corpus %" PRIu32 " inputs, %" PRIu64 " trap inputs saved\n", corpus_size, traps_saved);
+
+    destroy_fuzzer(fuzzer);
+    return EXIT_SUCCESS;
+}
+
+#endif
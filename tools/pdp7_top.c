@@ -0,0 +1,90 @@
+#include "metrics.h"
+#include "disassembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Live view of the counters published with `pdp7_emulator -S <name>`
+
+int main(int argc, char *argv[]);
+void print_metrics(const char* name, const metrics_page* snapshot);
+
+void print_metrics(const char* name, const metrics_page* snapshot) {
+    printf("PDP-7 %s (pid %d) %s\n\n", name, snapshot->pid, snapshot->running ? "running" : "halted");
+    printf("Instructions  %16" PRIu64 "\n", snapshot->instructions);
+    printf("Cycles        %16" PRIu64 "\n", snapshot->cycles);
+    printf("MIPS          %16.3f\n", snapshot->instructions_per_second / 1e6);
+    printf("I/O words     %16" PRIu64 "\n", snapshot->io_words);
+    printf("Frames        %16" PRIu64 "\n", snapshot->display_frames);
+    printf("TLS wait      %13.3f ms\n\n", snapshot->output_wait_ns / 1e6);
+
+    printf("Opcode %16s %8s\n", "Count", "Share");
+    for (int opcode = 0; opcode < METRICS_OPCODES; opcode++) {
+        if (snapshot->opcode_count[opcode] != 0) {
+            printf("%-6s %16" PRIu64 " %7.2f%%\n", opcode_name((uint32_t)opcode << 14), snapshot->opcode_count[opcode],
+                   snapshot->instructions ? 100.0 * snapshot->opcode_count[opcode] / snapshot->instructions : 0.0);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const char* name = NULL;
+    int iterations = -1;
+    useconds_t interval = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            interval = atoi(argv[++i]) * 1000;
+        } else if (argv[i][0] != '-' && name == NULL) {
+            name = argv[i];
+        } else {
+            name = NULL;
+            break;
+        }
+    }
+
+    if (name == NULL) {
+        fprintf(stderr, "Usage: %s <metrics name> [-n <iterations>] [-i <interval ms>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        fprintf(stderr, "No metrics segment %s, is the emulator running with -S?\n", name);
+        return EXIT_FAILURE;
+    }
+    const metrics_page* page = mmap(NULL, sizeof(metrics_page), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED) {
+        fprintf(stderr, "Failed to map metrics segment %s\n", name);
+        return EXIT_FAILURE;
+    }
+    if (page->version != METRICS_VERSION) {
+        fprintf(stderr, "Metrics segment %s has version %u, expected %u\n", name, page->version, METRICS_VERSION);
+        return EXIT_FAILURE;
+    }
+
+    metrics_page snapshot;
+    for (int i = 0; iterations < 0 || i < iterations; i++) {
+        if (i > 0) {
+            usleep(interval);
+        }
+        if (!metrics_read(page, &snapshot)) {
+            continue;
+        }
+        if (iterations != 1) {
+            printf("\033[H\033[2J");
+        }
+        print_metrics(name, &snapshot);
+        fflush(stdout);
+    }
+
+    munmap((void*)page, sizeof(metrics_page));
+    return EXIT_SUCCESS;
+}
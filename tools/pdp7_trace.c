@@ -0,0 +1,137 @@
+#include "trace.h"
+#include "disassembler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Offline reader for the traces written with `pdp7_emulator -T`
+
+typedef struct {
+    uint32_t pc_low;
+    uint32_t pc_high;
+    const char* mnemonic;
+    uint64_t from_cycle;
+    uint64_t last;
+} trace_filter;
+
+int main(int argc, char *argv[]);
+trace_record* read_trace(const char* filename, uint64_t* count);
+bool matches(const trace_filter* filter, const trace_record* record, uint64_t cycles, const char* text);
+
+trace_record* read_trace(const char* filename, uint64_t* count) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open trace %s\n", filename);
+        exit(1);
+    }
+
+    char magic[8];
+    uint32_t record_size;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0 ||
+        fread(&record_size, sizeof(record_size), 1, file) != 1 || record_size != sizeof(trace_record)) {
+        fprintf(stderr, "%s is not a PDP-7 trace\n", filename);
+        exit(1);
+    }
+
+    uint64_t capacity = 1024;
+    trace_record* records = malloc(capacity * sizeof(trace_record));
+    *count = 0;
+    while (records && fread(&records[*count], sizeof(trace_record), 1, file) == 1) {
+        if (++*count == capacity) {
+            capacity *= 2;
+            records = realloc(records, capacity * sizeof(trace_record));
+        }
+    }
+    if (!records) {
+        fprintf(stderr, "Failed to allocate trace records\n");
+        exit(1);
+    }
+
+    fclose(file);
+    return records;
+}
+
+bool matches(const trace_filter* filter, const trace_record* record, uint64_t cycles, const char* text) {
+    if (record->pc < filter->pc_low || record->pc > filter->pc_high || cycles < filter->from_cycle) {
+        return false;
+    }
+    if (filter->mnemonic) {
+        size_t length = strlen(filter->mnemonic);
+        if (strncmp(text, filter->mnemonic, length) != 0 || (text[length] != '\0' && text[length] != ' ')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    trace_filter filter = { .pc_low = 0, .pc_high = UINT32_MAX, .mnemonic = NULL, .from_cycle = 0, .last = 0 };
+    const char* filename = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            char* end;
+            filter.pc_low = strtoul(argv[++i], &end, 8);
+            filter.pc_high = *end == '-' ? strtoul(end + 1, NULL, 8) : filter.pc_low;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            filter.mnemonic = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            filter.from_cycle = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            filter.last = strtoull(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && filename == NULL) {
+            filename = argv[i];
+        } else {
+            filename = NULL;
+            break;
+        }
+    }
+
+    if (filename == NULL) {
+        fprintf(stderr, "Usage: %s <trace file> [-p <pc>[-<pc>]] [-o <mnemonic>] [-c <from cycle>] [-n <last records>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t count;
+    trace_record* records = read_trace(filename, &count);
+
+    // Records keep 32 bits of the cycle counter, widen them back assuming
+    // fewer than 2^32 cycles between consecutive records
+    uint64_t* cycles = malloc((count ? count : 1) * sizeof(uint64_t));
+    bool* selected = malloc((count ? count : 1) * sizeof(bool));
+    char text[32];
+    uint64_t selected_count = 0, epoch = 0;
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (i > 0 && records[i].cycles < records[i - 1].cycles) {
+            epoch += 1ull << 32;
+        }
+        cycles[i] = epoch + records[i].cycles;
+
+        disassemble_instruction(records[i].instruction & 0777777, text, sizeof(text));
+        selected[i] = matches(&filter, &records[i], cycles[i], text);
+        selected_count += selected[i];
+    }
+
+    uint64_t skip = filter.last && selected_count > filter.last ? selected_count - filter.last : 0;
+
+    printf("%12s %5s %6s %-12s %5s %6s %s\n", "Cycles", "PC", "Word", "Instruction", "EA", "AC", "L");
+    for (uint64_t i = 0; i < count; i++) {
+        if (!selected[i] || (skip && skip--)) {
+            continue;
+        }
+
+        const trace_record* record = &records[i];
+        uint32_t instruction = record->instruction & 0777777;
+        disassemble_instruction(instruction, text, sizeof(text));
+        printf("%12" PRIu64 " %05o %06" PRIo32 " %-12s %05o %06" PRIo32 " %d\n",
+               cycles[i], record->pc, instruction, text, record->address,
+               record->accumulator, (record->instruction & TRACE_LINK_BIT) != 0);
+    }
+
+    free(selected);
+    free(cycles);
+    free(records);
+    return EXIT_SUCCESS;
+}